@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raster.h"
+#include "raster_tiled.h"
+
+#define WIDTH 800
+#define HEIGHT 600
+
+// Headless batch rasterization: draw many random segments in one call
+// and report the throughput.
+//
+//   ./batch_lines [segment count] [bresenham|dda|wu|tiled|strip|strip-wu] [threads]
+//
+// "wu" draws anti-aliased lines. "tiled" is Bresenham on the multithreaded
+// tiled renderer; threads defaults to one per CPU. "strip" draws a
+// random-walk time series of that many vertices as one connected polyline
+// ("strip-wu" anti-aliased).
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    LineAlgorithm algorithm = LINE_BRESENHAM;
+    int tiled = 0;
+    int strip = 0;
+    int threads = argc > 3 ? atoi(argv[3]) : 0;
+    
+    if (argc > 2) {
+        if (strcmp(argv[2], "dda") == 0) {
+            algorithm = LINE_DDA;
+        } else if (strcmp(argv[2], "wu") == 0) {
+            algorithm = LINE_WU;
+        } else if (strcmp(argv[2], "tiled") == 0) {
+            tiled = 1;
+        } else if (strcmp(argv[2], "strip") == 0) {
+            strip = 1;
+        } else if (strcmp(argv[2], "strip-wu") == 0) {
+            strip = 1;
+            algorithm = LINE_WU;
+        } else if (strcmp(argv[2], "bresenham") != 0) {
+            printf("Unknown algorithm '%s' (use bresenham, dda, wu, tiled, strip or strip-wu)\n", argv[2]);
+            return 1;
+        }
+    }
+    
+    Pixel* pixels = malloc(sizeof(Pixel) * WIDTH * HEIGHT);
+    Segment* segments = malloc(sizeof(Segment) * (count ? count : 1));
+    Point* points = malloc(sizeof(Point) * (count ? count : 1));
+    if (!pixels || !segments || !points) {
+        printf("Memory allocation failed!\n");
+        free(pixels);
+        free(segments);
+        free(points);
+        return 1;
+    }
+    
+    // Fixed seed so runs are comparable
+    srand(12345);
+    for (size_t i = 0; i < count; i++) {
+        segments[i].x1 = rand() % WIDTH;
+        segments[i].y1 = rand() % HEIGHT;
+        segments[i].x2 = rand() % WIDTH;
+        segments[i].y2 = rand() % HEIGHT;
+        segments[i].color = COLOR_RGB(rand() % 256, rand() % 256, rand() % 256);
+    }
+    
+    // Time series: x sweeps the canvas once, y takes small random steps
+    int level = HEIGHT / 2;
+    for (size_t i = 0; i < count; i++) {
+        level += rand() % 9 - 4;
+        level = level < 0 ? 0 : level >= HEIGHT ? HEIGHT - 1 : level;
+        points[i].x = (int)((double)i * (WIDTH - 1) / (count > 1 ? count - 1 : 1));
+        points[i].y = level;
+    }
+    
+    Framebuffer fb;
+    initFramebuffer(&fb, pixels, WIDTH, HEIGHT);
+    clearFramebuffer(&fb, COLOR_WHITE);
+    
+    BatchStats stats;
+    if (tiled) {
+        TiledRenderer* renderer = createTiledRenderer(threads, TILED_DEFAULT_TILE_SIZE);
+        if (!renderer) {
+            printf("Could not start the tiled renderer!\n");
+            free(pixels);
+            free(segments);
+            free(points);
+            return 1;
+        }
+        threads = tiledRendererThreads(renderer);
+        drawLineBatchTiled(renderer, &fb, segments, count, &stats);
+        destroyTiledRenderer(renderer);
+        printf("Algorithm      : Bresenham, tiled (%d threads)\n", threads);
+    } else if (strip) {
+        drawPolyline(&fb, points, count, COLOR_BLUE, algorithm, &stats);
+        printf("Algorithm      : %s line strip\n", algorithm == LINE_WU ? "Wu (anti-aliased)" : "Bresenham");
+    } else {
+        drawLineBatch(&fb, segments, count, algorithm, &stats);
+        printf("Algorithm      : %s\n", algorithm == LINE_DDA ? "DDA" :
+                                         algorithm == LINE_WU ? "Wu (anti-aliased)" : "Bresenham");
+    }
+    printf("Canvas         : %d x %d\n", WIDTH, HEIGHT);
+    printf("Segments       : %zu\n", stats.segments);
+    printf("Pixels         : %zu\n", stats.pixels);
+    printf("Time           : %.3f s\n", stats.seconds);
+    printf("Throughput     : %.0f segments/s\n", stats.segmentsPerSecond);
+    printf("                 %.1f Mpixels/s\n",
+           stats.seconds > 0.0 ? stats.pixels / stats.seconds / 1e6 : 0.0);
+    
+    free(segments);
+    free(points);
+    free(pixels);
+    return 0;
+}
@@ -0,0 +1,606 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "raster.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define HAVE_PERF_EVENTS 1
+#endif
+
+// Rasterizer benchmark on reproducible workloads.
+//
+//   ./bench [--json] [--seed N] [--repeat N] [--pixels N]
+//           [--algorithms LIST] [--canvas LIST] [--lengths LIST]
+//           [--octants LIST] [--clip LIST]
+//
+// Every combination of the listed options is one workload: segments (or
+// circles) generated from a fixed seed until about --pixels pixels would
+// be stepped. Each algorithm draws the workload --repeat times and the
+// fastest run is reported, as ns/pixel and pixels/s over the pixels that
+// land on the canvas, with the hardware counters of that run. For lines
+// these are the visible steps (off-canvas ones are clipped away, not
+// drawn; wu blends two pixels per step), for circles the pixels written.
+//
+//   algorithms  dda, bresenham, circle; also fixed, simd, runslice, wu
+//               (anti-aliased; blends two pixels per step), or all
+//               (default dda,bresenham,circle)
+//   canvas      WxH sizes (default 800x600,3840x2160)
+//   lengths     short (2-16), medium (16-256), long (256 up to the canvas)
+//               or mixed (log-uniform); circles use half as the radius
+//               (default short,medium,long)
+//   octants     all (random per segment) or 0-7, counted clockwise from
+//               +x in screen coordinates (default all)
+//   clip        fraction of segments that cross the canvas edge
+//               (default 0,0.5)
+//
+// Counters come from perf_event_open and count this thread in user space.
+// Where they are not permitted (see /proc/sys/kernel/perf_event_paranoid)
+// or not supported they are reported as null / "-".
+
+#define MAX_ITEMS 8
+
+typedef enum {
+    BENCH_DDA,
+    BENCH_BRESENHAM,
+    BENCH_CIRCLE,
+    BENCH_FIXED,
+    BENCH_SIMD,
+    BENCH_RUN_SLICE,
+    BENCH_WU,
+    BENCH_ALGORITHMS
+} BenchAlgorithm;
+
+static const char* algorithmNames[BENCH_ALGORITHMS] = {
+    "dda", "bresenham", "circle", "fixed", "simd", "runslice", "wu"
+};
+static const LineAlgorithm lineAlgorithms[BENCH_ALGORITHMS] = {
+    LINE_DDA, LINE_BRESENHAM, LINE_BRESENHAM, LINE_DDA_FIXED, LINE_DDA_SIMD, LINE_RUN_SLICE,
+    LINE_WU
+};
+
+typedef enum {
+    LENGTH_SHORT,
+    LENGTH_MEDIUM,
+    LENGTH_LONG,
+    LENGTH_MIXED,
+    LENGTH_DISTRIBUTIONS
+} LengthDistribution;
+
+static const char* lengthNames[LENGTH_DISTRIBUTIONS] = { "short", "medium", "long", "mixed" };
+
+#define OCTANT_ALL -1
+
+typedef struct {
+    int width, height;
+    LengthDistribution lengths;
+    int octant;
+    double clip;
+} Workload;
+
+// Counters of one run; -1 where unavailable
+enum { COUNTER_CYCLES, COUNTER_INSTRUCTIONS, COUNTER_CACHE_MISSES, COUNTER_BRANCH_MISSES, COUNTERS };
+
+static const char* counterNames[COUNTERS] = {
+    "cycles", "instructions", "cache_misses", "branch_misses"
+};
+
+typedef struct {
+    int fd[COUNTERS];
+} PerfCounters;
+
+static void openCounters(PerfCounters* counters) {
+#ifdef HAVE_PERF_EVENTS
+    static const uint64_t configs[COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (int i = 0; i < COUNTERS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        counters->fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#else
+    for (int i = 0; i < COUNTERS; i++) {
+        counters->fd[i] = -1;
+    }
+#endif
+}
+
+static int countersAvailable(const PerfCounters* counters) {
+    for (int i = 0; i < COUNTERS; i++) {
+        if (counters->fd[i] >= 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void startCounters(PerfCounters* counters) {
+#ifdef HAVE_PERF_EVENTS
+    for (int i = 0; i < COUNTERS; i++) {
+        if (counters->fd[i] >= 0) {
+            ioctl(counters->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)counters;
+#endif
+}
+
+static void stopCounters(PerfCounters* counters, long long* values) {
+    for (int i = 0; i < COUNTERS; i++) {
+        values[i] = -1;
+#ifdef HAVE_PERF_EVENTS
+        uint64_t value;
+        if (counters->fd[i] >= 0) {
+            ioctl(counters->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(counters->fd[i], &value, sizeof(value)) == (ssize_t)sizeof(value)) {
+                values[i] = (long long)value;
+            }
+        }
+#endif
+    }
+}
+
+static void closeCounters(PerfCounters* counters) {
+    for (int i = 0; i < COUNTERS; i++) {
+#ifdef HAVE_PERF_EVENTS
+        if (counters->fd[i] >= 0) {
+            close(counters->fd[i]);
+        }
+#endif
+        counters->fd[i] = -1;
+    }
+}
+
+// xorshift64*, so workloads do not depend on the C library's rand()
+static uint64_t nextRandom(uint64_t* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ull;
+}
+
+static int randomBelow(uint64_t* state, int limit) {
+    return limit > 0 ? (int)(nextRandom(state) % (uint64_t)limit) : 0;
+}
+
+static int randomLength(uint64_t* state, LengthDistribution lengths, int longest) {
+    int length;
+
+    switch (lengths) {
+    case LENGTH_SHORT:
+        length = 2 + randomBelow(state, 15);
+        break;
+    case LENGTH_MEDIUM:
+        length = 16 + randomBelow(state, 241);
+        break;
+    case LENGTH_LONG:
+        length = longest > 256 ? 256 + randomBelow(state, longest - 255) : longest;
+        break;
+    case LENGTH_MIXED:
+    default:
+        length = (int)exp(log(2.0) + (log((double)longest) - log(2.0)) *
+                          (double)(nextRandom(state) >> 11) / 9007199254740992.0);
+        break;
+    }
+    return length < longest ? length : longest;
+}
+
+// A random point on the canvas edge
+static void edgePoint(uint64_t* state, const Workload* w, int* x, int* y) {
+    switch (randomBelow(state, 4)) {
+    case 0:  *x = randomBelow(state, w->width); *y = 0; break;
+    case 1:  *x = randomBelow(state, w->width); *y = w->height - 1; break;
+    case 2:  *x = 0; *y = randomBelow(state, w->height); break;
+    default: *x = w->width - 1; *y = randomBelow(state, w->height); break;
+    }
+}
+
+// One segment of the workload; returns the number of steps it takes
+// unclipped (its longer axis + 1)
+static int randomSegment(uint64_t* state, const Workload* w, Segment* s) {
+    int octant = w->octant == OCTANT_ALL ? randomBelow(state, 8) : w->octant;
+    int clipped = (double)(nextRandom(state) >> 11) / 9007199254740992.0 < w->clip;
+
+    // Octants 0, 3, 4 and 7 are x-major
+    int xMajor = octant == 0 || octant == 3 || octant == 4 || octant == 7;
+    int extent = xMajor ? w->width - 1 : w->height - 1;
+    int otherExtent = xMajor ? w->height - 1 : w->width - 1;
+    int major = randomLength(state, w->lengths, extent > 1 ? extent : 1);
+    int minor = randomBelow(state, (major < otherExtent ? major : otherExtent) + 1);
+    int dx = xMajor ? major : minor;
+    int dy = xMajor ? minor : major;
+
+    // x decreases in octants 2-5, y in octants 4-7
+    if (octant >= 2 && octant <= 5) {
+        dx = -dx;
+    }
+    if (octant >= 4) {
+        dy = -dy;
+    }
+
+    if (clipped) {
+        // Through a point on the edge, at a random position along the line
+        int px, py;
+        edgePoint(state, w, &px, &py);
+        double t = (double)(nextRandom(state) >> 11) / 9007199254740992.0;
+        s->x1 = px - (int)(t * dx);
+        s->y1 = py - (int)(t * dy);
+    } else {
+        // Anywhere the whole segment fits
+        s->x1 = (dx < 0 ? -dx : 0) + randomBelow(state, w->width - (dx < 0 ? -dx : dx));
+        s->y1 = (dy < 0 ? -dy : 0) + randomBelow(state, w->height - (dy < 0 ? -dy : dy));
+    }
+    s->x2 = s->x1 + dx;
+    s->y2 = s->y1 + dy;
+    s->color = (Color)(nextRandom(state) & 0xFFFFFF);
+    return major + 1;
+}
+
+// Circles use half the line length as the radius; clipped ones are
+// centered on the canvas edge
+static int randomCircle(uint64_t* state, const Workload* w, Circle* c) {
+    int clipped = (double)(nextRandom(state) >> 11) / 9007199254740992.0 < w->clip;
+    int fit = (w->width < w->height ? w->width : w->height) / 2 - 1;
+    int radius = randomLength(state, w->lengths, 2 * (fit > 1 ? fit : 1)) / 2;
+
+    if (clipped) {
+        edgePoint(state, w, &c->xc, &c->yc);
+    } else {
+        c->xc = radius + randomBelow(state, w->width - 2 * radius);
+        c->yc = radius + randomBelow(state, w->height - 2 * radius);
+    }
+    c->radius = radius;
+    c->color = (Color)(nextRandom(state) & 0xFFFFFF);
+
+    // Each octant is about r / sqrt(2) pixels
+    return (int)(5.66 * radius) + 1;
+}
+
+typedef struct {
+    size_t count;
+    size_t pixels;
+    double seconds;
+    long long counters[COUNTERS];
+} BenchResult;
+
+static void runWorkload(BenchAlgorithm algorithm, Framebuffer* fb, const void* items,
+                        size_t count, int repeats, PerfCounters* counters, BenchResult* result) {
+    for (int run = 0; run < repeats; run++) {
+        BatchStats stats;
+        long long values[COUNTERS];
+
+        clearFramebuffer(fb, COLOR_WHITE);
+        startCounters(counters);
+        if (algorithm == BENCH_CIRCLE) {
+            drawCircleBatch(fb, items, count, CIRCLE_OUTLINE, 0, &stats);
+        } else {
+            drawLineBatch(fb, items, count, lineAlgorithms[algorithm], &stats);
+        }
+        stopCounters(counters, values);
+
+        if (run == 0 || stats.seconds < result->seconds) {
+            result->count = count;
+            result->pixels = stats.pixels;
+            result->seconds = stats.seconds;
+            memcpy(result->counters, values, sizeof(values));
+        }
+    }
+}
+
+// Pixels of the segments that land on the framebuffer: the steps between
+// the first and last visible pixel of each line. BatchStats counts every
+// step, so a clipped line would otherwise count the steps the kernels skip.
+static size_t visibleLinePixels(const Framebuffer* fb, const Segment* segments, size_t count) {
+    ClipRect canvas = { 0, 0, fb->width - 1, fb->height - 1 };
+    size_t pixels = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        int x1 = segments[i].x1, y1 = segments[i].y1, x2 = segments[i].x2, y2 = segments[i].y2;
+        if (clipLine(&canvas, &x1, &y1, &x2, &y2)) {
+            int dx = abs(x2 - x1), dy = abs(y2 - y1);
+            pixels += (size_t)(dx > dy ? dx : dy) + 1;
+        }
+    }
+    return pixels;
+}
+
+static void printCounter(long long value, int json) {
+    if (json) {
+        if (value < 0) {
+            printf("null");
+        } else {
+            printf("%lld", value);
+        }
+    } else if (value < 0) {
+        printf(" %14s", "-");
+    } else {
+        printf(" %14lld", value);
+    }
+}
+
+// Generate, draw and report one workload; returns 0 if out of memory.
+// Every workload starts from the same seed, so changing one option does
+// not reshuffle the others.
+static int benchWorkload(BenchAlgorithm algorithm, Framebuffer* fb, const Workload* workload,
+                         unsigned long long seed, double pixelBudget, int repeats,
+                         PerfCounters* counters, int json, int first) {
+    int circles = algorithm == BENCH_CIRCLE;
+    size_t itemSize = circles ? sizeof(Circle) : sizeof(Segment);
+    size_t capacity = 1024, count = 0;
+    double steps = 0.0;
+    unsigned char* items = malloc(itemSize * capacity);
+    uint64_t state = seed * 2654435761ull + 1;
+
+    while (items && steps < pixelBudget) {
+        if (count == capacity) {
+            unsigned char* grown = realloc(items, itemSize * capacity * 2);
+            if (!grown) {
+                free(items);
+                return 0;
+            }
+            items = grown;
+            capacity *= 2;
+        }
+        steps += circles ? randomCircle(&state, workload, (Circle*)items + count)
+                         : randomSegment(&state, workload, (Segment*)items + count);
+        count++;
+    }
+    if (!items) {
+        return 0;
+    }
+
+    BenchResult result = { 0 };
+    runWorkload(algorithm, fb, items, count, repeats, counters, &result);
+    if (!circles) {
+        result.pixels = visibleLinePixels(fb, (const Segment*)items, count);
+    }
+    free(items);
+
+    double pixels = result.pixels ? (double)result.pixels : 1.0;
+    double nsPerPixel = result.seconds * 1e9 / pixels;
+    double pixelsPerSecond = result.seconds > 0.0 ? result.pixels / result.seconds : 0.0;
+    char octant[8];
+    if (workload->octant == OCTANT_ALL) {
+        snprintf(octant, sizeof(octant), "all");
+    } else {
+        snprintf(octant, sizeof(octant), "%d", workload->octant);
+    }
+
+    if (json) {
+        printf("%s\n    {\"algorithm\": \"%s\", \"width\": %d, \"height\": %d, "
+               "\"lengths\": \"%s\", \"octant\": \"%s\", \"clip\": %g, "
+               "\"items\": %zu, \"pixels\": %zu, \"seconds\": %.9f, "
+               "\"ns_per_pixel\": %.4f, \"pixels_per_second\": %.0f",
+               first ? "" : ",", algorithmNames[algorithm], workload->width, workload->height,
+               lengthNames[workload->lengths], octant, workload->clip, result.count,
+               result.pixels, result.seconds, nsPerPixel, pixelsPerSecond);
+        for (int c = 0; c < COUNTERS; c++) {
+            printf(", \"%s\": ", counterNames[c]);
+            printCounter(result.counters[c], 1);
+        }
+        printf("}");
+    } else {
+        char canvas[24];
+        snprintf(canvas, sizeof(canvas), "%dx%d", workload->width, workload->height);
+        printf("%-10s %-10s %-7s %-6s %5.2f %10zu %10zu %9.3f %12.1f", algorithmNames[algorithm],
+               canvas, lengthNames[workload->lengths], octant, workload->clip, result.count,
+               result.pixels, nsPerPixel, pixelsPerSecond / 1e6);
+        for (int c = 0; c < COUNTERS; c++) {
+            printCounter(result.counters[c], 0);
+        }
+        printf("\n");
+    }
+    return 1;
+}
+
+// Split the comma-separated list of option `name`; returns the number of
+// items, or -1 after printing an error if there are more than MAX_ITEMS
+static int splitList(char* list, char** items, const char* name) {
+    int count = 0;
+    for (char* item = strtok(list, ","); item; item = strtok(NULL, ",")) {
+        if (count == MAX_ITEMS) {
+            printf("Too many items in --%s (at most %d)\n", name, MAX_ITEMS);
+            return -1;
+        }
+        items[count++] = item;
+    }
+    return count;
+}
+
+static int findName(const char* name, const char* const* names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char* argv[]) {
+    int json = 0;
+    unsigned long long seed = 12345;
+    int repeats = 5;
+    double pixelBudget = 4e6;
+    char algorithmList[256] = "dda,bresenham,circle";
+    char canvasList[256] = "800x600,3840x2160";
+    char lengthList[256] = "short,medium,long";
+    char octantList[256] = "all";
+    char clipList[256] = "0,0.5";
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        char* list = NULL;
+
+        if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+            continue;
+        }
+        if (!value) {
+            printf("Unknown or incomplete option '%s'\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--seed") == 0) {
+            seed = strtoull(value, NULL, 10);
+        } else if (strcmp(argv[i], "--repeat") == 0) {
+            repeats = atoi(value);
+        } else if (strcmp(argv[i], "--pixels") == 0) {
+            pixelBudget = atof(value);
+        } else if (strcmp(argv[i], "--algorithms") == 0) {
+            list = algorithmList;
+        } else if (strcmp(argv[i], "--canvas") == 0) {
+            list = canvasList;
+        } else if (strcmp(argv[i], "--lengths") == 0) {
+            list = lengthList;
+        } else if (strcmp(argv[i], "--octants") == 0) {
+            list = octantList;
+        } else if (strcmp(argv[i], "--clip") == 0) {
+            list = clipList;
+        } else {
+            printf("Unknown option '%s'\n", argv[i]);
+            return 1;
+        }
+        if (list) {
+            snprintf(list, 256, "%s", strcmp(value, "all") == 0 && list == algorithmList
+                                      ? "dda,bresenham,circle,fixed,simd,runslice,wu" : value);
+        }
+        i++;
+    }
+    if (repeats < 1 || pixelBudget < 1) {
+        printf("--repeat and --pixels must be positive\n");
+        return 1;
+    }
+
+    // Parse the option lists into the workload matrix
+    char* items[MAX_ITEMS];
+    int algorithms[MAX_ITEMS], algorithmCount = splitList(algorithmList, items, "algorithms");
+    if (algorithmCount < 0) {
+        return 1;
+    }
+    for (int i = 0; i < algorithmCount; i++) {
+        algorithms[i] = findName(items[i], algorithmNames, BENCH_ALGORITHMS);
+        if (algorithms[i] < 0) {
+            printf("Unknown algorithm '%s'\n", items[i]);
+            return 1;
+        }
+    }
+    int widths[MAX_ITEMS], heights[MAX_ITEMS];
+    int canvasCount = splitList(canvasList, items, "canvas");
+    if (canvasCount < 0) {
+        return 1;
+    }
+    for (int i = 0; i < canvasCount; i++) {
+        if (sscanf(items[i], "%dx%d", &widths[i], &heights[i]) != 2 ||
+            widths[i] < 2 || heights[i] < 2) {
+            printf("Invalid canvas size '%s' (use WxH)\n", items[i]);
+            return 1;
+        }
+    }
+    int lengths[MAX_ITEMS], lengthCount = splitList(lengthList, items, "lengths");
+    if (lengthCount < 0) {
+        return 1;
+    }
+    for (int i = 0; i < lengthCount; i++) {
+        lengths[i] = findName(items[i], lengthNames, LENGTH_DISTRIBUTIONS);
+        if (lengths[i] < 0) {
+            printf("Unknown length distribution '%s'\n", items[i]);
+            return 1;
+        }
+    }
+    int octants[MAX_ITEMS], octantCount = splitList(octantList, items, "octants");
+    if (octantCount < 0) {
+        return 1;
+    }
+    for (int i = 0; i < octantCount; i++) {
+        octants[i] = strcmp(items[i], "all") == 0 ? OCTANT_ALL : atoi(items[i]);
+        if (octants[i] < OCTANT_ALL || octants[i] > 7) {
+            printf("Invalid octant '%s' (use all or 0-7)\n", items[i]);
+            return 1;
+        }
+    }
+    double clips[MAX_ITEMS];
+    int clipCount = splitList(clipList, items, "clip");
+    if (clipCount < 0) {
+        return 1;
+    }
+    for (int i = 0; i < clipCount; i++) {
+        clips[i] = atof(items[i]);
+        if (clips[i] < 0.0 || clips[i] > 1.0) {
+            printf("Invalid clip fraction '%s' (use 0-1)\n", items[i]);
+            return 1;
+        }
+    }
+
+    PerfCounters counters;
+    openCounters(&counters);
+
+    if (json) {
+        printf("{\n  \"seed\": %llu,\n  \"repeats\": %d,\n  \"simd\": \"%s\",\n"
+               "  \"counters\": %s,\n  \"results\": [",
+               seed, repeats, simdLevelName(activeSimdLevel()),
+               countersAvailable(&counters) ? "true" : "false");
+    } else {
+        printf("Seed %llu, best of %d runs, about %.0f pixels per workload\n",
+               seed, repeats, pixelBudget);
+        if (!countersAvailable(&counters)) {
+            printf("Hardware counters unavailable (perf_event_open not permitted or supported)\n");
+        }
+        printf("\n%-10s %-10s %-7s %-6s %5s %10s %10s %9s %12s", "algorithm", "canvas",
+               "lengths", "octant", "clip", "items", "pixels", "ns/pixel", "Mpixels/s");
+        for (int c = 0; c < COUNTERS; c++) {
+            printf(" %14s", counterNames[c]);
+        }
+        printf("\n");
+    }
+
+    int first = 1;
+    for (int ci = 0; ci < canvasCount; ci++) {
+        Framebuffer* fb = createFramebuffer(widths[ci], heights[ci], PIXEL_RGB24);
+        if (!fb) {
+            printf("Memory allocation failed!\n");
+            return 1;
+        }
+
+        for (int li = 0; li < lengthCount; li++) {
+            for (int oi = 0; oi < octantCount; oi++) {
+                for (int pi = 0; pi < clipCount; pi++) {
+                    Workload workload = { widths[ci], heights[ci], (LengthDistribution)lengths[li],
+                                          octants[oi], clips[pi] };
+
+                    for (int ai = 0; ai < algorithmCount; ai++) {
+                        if (!benchWorkload((BenchAlgorithm)algorithms[ai], fb, &workload, seed,
+                                           pixelBudget, repeats, &counters, json, first)) {
+                            printf("Memory allocation failed!\n");
+                            return 1;
+                        }
+                        first = 0;
+                    }
+                }
+            }
+        }
+        destroyFramebuffer(fb);
+    }
+
+    if (json) {
+        printf("\n  ]\n}\n");
+    }
+    closeCounters(&counters);
+    return 0;
+}
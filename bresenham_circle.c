@@ -1,79 +1,20 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <SDL2/SDL.h>
+#include "raster.h"
+#include "raster_trace.h"
+#include "sdl_presenter.h"
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 
-// Plot 8 symmetrical points of the circle
-void plotCirclePoints(SDL_Renderer* renderer, int xc, int yc, int x, int y) {
-    SDL_RenderDrawPoint(renderer, xc + x, yc + y);  // Octant 1
-    SDL_RenderDrawPoint(renderer, xc - x, yc + y);  // Octant 2
-    SDL_RenderDrawPoint(renderer, xc + x, yc - y);  // Octant 3
-    SDL_RenderDrawPoint(renderer, xc - x, yc - y);  // Octant 4
-    SDL_RenderDrawPoint(renderer, xc + y, yc + x);  // Octant 5
-    SDL_RenderDrawPoint(renderer, xc - y, yc + x);  // Octant 6
-    SDL_RenderDrawPoint(renderer, xc + y, yc - x);  // Octant 7
-    SDL_RenderDrawPoint(renderer, xc - y, yc - x);  // Octant 8
-}
-
-// Bresenham's Circle Drawing Algorithm (Midpoint Circle Algorithm)
-void drawCircleBresenham(SDL_Renderer* renderer, int xc, int yc, int radius) {
-    int x = 0;
-    int y = radius;
-    int d = 3 - 2 * radius;  // Initial decision parameter
-    
-    printf("\n╔════════════════════════════════════════════════════════╗\n");
-    printf("║    Bresenham's Circle Algorithm Calculation Details   ║\n");
-    printf("╚════════════════════════════════════════════════════════╝\n");
-    printf("  Center (xc, yc) : (%d, %d)\n", xc, yc);
-    printf("  Radius          : %d\n", radius);
-    printf("  ────────────────────────────────────────────────────────\n");
-    printf("  Initial decision parameter:\n");
-    printf("  d = 3 - 2*r = 3 - 2*%d = %d\n", radius, d);
-    printf("  ────────────────────────────────────────────────────────\n");
-    printf("  Starting point: (x=0, y=%d)\n", radius);
-    printf("╚════════════════════════════════════════════════════════╝\n\n");
-    
-    printf("Drawing circle using 8-way symmetry:\n");
-    printf("  (Each calculated point generates 8 symmetrical points)\n\n");
-    
-    int step = 0;
-    
-    // Draw initial point
-    plotCirclePoints(renderer, xc, yc, x, y);
-    
-    printf("Step %2d: x=%3d, y=%3d, d=%4d\n", step++, x, y, d);
-    
-    // Main loop - calculate one octant, use symmetry for others
-    while (x <= y) {
-        x++;
-        
-        if (d < 0) {
-            // Select E (East) point
-            d = d + 4 * x + 6;
-        } else {
-            // Select SE (South-East) point
-            y--;
-            d = d + 4 * (x - y) + 10;
-        }
-        
-        plotCirclePoints(renderer, xc, yc, x, y);
-        
-        if (step < 10 || x == y) {  // Show first 10 steps and last step
-            printf("Step %2d: x=%3d, y=%3d, d=%4d\n", step, x, y, d);
-        } else if (step == 10) {
-            printf("         ... (calculating remaining points) ...\n");
-        }
-        step++;
+int main(int argc, char* argv[]) {
+    int width = argc > 2 ? atoi(argv[1]) : WINDOW_WIDTH;
+    int height = argc > 2 ? atoi(argv[2]) : WINDOW_HEIGHT;
+    if (width <= 0 || height <= 0) {
+        printf("Invalid window size %s x %s\n", argv[1], argv[2]);
+        return 1;
     }
     
-    printf("\n✓ Circle drawn successfully!\n");
-    printf("  Total steps (octant): %d\n", step);
-    printf("  Total pixels plotted: %d (using 8-way symmetry)\n", step * 8);
-}
-
-int main(int argc, char* argv[]) {
     int xc, yc, radius;
     
     printf("\n");
@@ -82,8 +23,8 @@ int main(int argc, char* argv[]) {
     printf("║     (Midpoint Circle Algorithm)                          ║\n");
     printf("╚══════════════════════════════════════════════════════════╝\n\n");
     
-    printf("Window size: %d x %d pixels\n", WINDOW_WIDTH, WINDOW_HEIGHT);
-    printf("Valid center: x (0-%d), y (0-%d)\n\n", WINDOW_WIDTH-1, WINDOW_HEIGHT-1);
+    printf("Window size: %d x %d pixels\n", width, height);
+    printf("Valid center: x (0-%d), y (0-%d)\n\n", width-1, height-1);
     
     // Get user input for circle parameters
     printf("Enter the center coordinates:\n");
@@ -97,10 +38,10 @@ int main(int argc, char* argv[]) {
     scanf("%d", &radius);
     
     // Validate input
-    if (xc < 0 || xc >= WINDOW_WIDTH || yc < 0 || yc >= WINDOW_HEIGHT) {
+    if (xc < 0 || xc >= width || yc < 0 || yc >= height) {
         printf("\n⚠ ERROR: Center coordinates must be within window bounds!\n");
-        printf("   xc: 0 to %d\n", WINDOW_WIDTH-1);
-        printf("   yc: 0 to %d\n", WINDOW_HEIGHT-1);
+        printf("   xc: 0 to %d\n", width-1);
+        printf("   yc: 0 to %d\n", height-1);
         return 1;
     }
     
@@ -109,71 +50,44 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    if (xc - radius < 0 || xc + radius >= WINDOW_WIDTH ||
-        yc - radius < 0 || yc + radius >= WINDOW_HEIGHT) {
+    if (xc - radius < 0 || xc + radius >= width ||
+        yc - radius < 0 || yc + radius >= height) {
         printf("\n⚠ WARNING: Circle extends beyond window boundaries!\n");
         printf("   It will be clipped at the edges.\n\n");
     }
     
-    // Initialize SDL
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        printf("\n✗ SDL initialization failed: %s\n", SDL_GetError());
+    Framebuffer* fb = createFramebuffer(width, height, PIXEL_RGB24);
+    if (!fb) {
+        printf("\n✗ Memory allocation failed!\n");
         return 1;
     }
     
-    // Create window
-    SDL_Window* window = SDL_CreateWindow(
-        "Bresenham's Circle Algorithm",
-        SDL_WINDOWPOS_CENTERED,
-        SDL_WINDOWPOS_CENTERED,
-        WINDOW_WIDTH,
-        WINDOW_HEIGHT,
-        SDL_WINDOW_SHOWN
-    );
-    
-    if (!window) {
-        printf("\n✗ Window creation failed: %s\n", SDL_GetError());
-        SDL_Quit();
-        return 1;
-    }
+    // Clear with white background
+    clearFramebuffer(fb, COLOR_WHITE);
     
-    // Create renderer
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    if (!renderer) {
-        printf("\n✗ Renderer creation failed: %s\n", SDL_GetError());
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        return 1;
-    }
-    
-    // Clear screen with white background
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-    SDL_RenderClear(renderer);
-    
-    // Set drawing color to red for circle
-    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-    
-    // Draw the circle using Bresenham's algorithm
-    drawCircleBresenham(renderer, xc, yc, radius);
+    // Draw the circle in red using Bresenham's algorithm, listing the
+    // decision parameter of each octant step through the trace sink
+    setTraceSink(traceSinkText, stdout);
+    setTraceLevel(TRACE_STEPS);
+    drawCircleBresenham(fb, xc, yc, radius, COLOR_RED);
+    setTraceLevel(TRACE_OFF);
     
     // Draw center point marker (blue cross)
-    SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255);
     for (int i = -5; i <= 5; i++) {
-        SDL_RenderDrawPoint(renderer, xc + i, yc);      // Horizontal line
-        SDL_RenderDrawPoint(renderer, xc, yc + i);      // Vertical line
+        setPixel(fb, xc + i, yc, COLOR_BLUE);      // Horizontal line
+        setPixel(fb, xc, yc + i, COLOR_BLUE);      // Vertical line
     }
     
     // Draw small circle at center
-    for (int dx = -2; dx <= 2; dx++) {
-        for (int dy = -2; dy <= 2; dy++) {
-            if (dx*dx + dy*dy <= 4) {
-                SDL_RenderDrawPoint(renderer, xc + dx, yc + dy);
-            }
-        }
-    }
+    drawMarker(fb, xc, yc, 2, COLOR_BLUE);
     
-    // Update screen to show the circle
-    SDL_RenderPresent(renderer);
+    // Open the window and show the finished frame
+    SdlPresenter* presenter = createPresenter("Bresenham's Circle Algorithm", width, height);
+    if (!presenter) {
+        destroyFramebuffer(fb);
+        return 1;
+    }
+    presentFramebuffer(presenter, fb);
     
     printf("\n");
     printf("Window opened with your circle!\n");
@@ -185,24 +99,27 @@ int main(int argc, char* argv[]) {
     int quit = 0;
     SDL_Event e;
     
-    while (!quit) {
-        while (SDL_PollEvent(&e) != 0) {
-            if (e.type == SDL_QUIT) {
-                quit = 1;
+    // Sleep until something happens instead of polling
+    while (!quit && SDL_WaitEvent(&e)) {
+        if (e.type == SDL_QUIT) {
+            quit = 1;
+        }
+        else if (e.type == SDL_WINDOWEVENT) {
+            // The frame is still in the texture; show it again
+            if (e.window.event == SDL_WINDOWEVENT_EXPOSED) {
+                redrawPresenter(presenter);
             }
-            else if (e.type == SDL_KEYDOWN) {
-                if (e.key.keysym.sym == SDLK_ESCAPE) {
-                    quit = 1;
-                }
+        }
+        else if (e.type == SDL_KEYDOWN) {
+            if (e.key.keysym.sym == SDLK_ESCAPE) {
+                quit = 1;
             }
         }
-        SDL_Delay(10);
     }
     
     // Cleanup
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    destroyPresenter(presenter);
+    destroyFramebuffer(fb);
     
     printf("\nProgram ended. Goodbye!\n\n");
     return 0;
@@ -1,74 +1,20 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
-#include <SDL2/SDL.h>
+#include "raster.h"
+#include "raster_trace.h"
+#include "sdl_presenter.h"
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 
-// Bresenham's Line Drawing Algorithm
-void drawLineBresenham(SDL_Renderer* renderer, int x1, int y1, int x2, int y2) {
-    int dx = abs(x2 - x1);
-    int dy = abs(y2 - y1);
-    
-    int sx = (x1 < x2) ? 1 : -1;  // Step direction for x
-    int sy = (y1 < y2) ? 1 : -1;  // Step direction for y
-    
-    int err = dx - dy;  // Initial error term
-    int e2;
-    
-    int x = x1;
-    int y = y1;
-    
-    // Display Bresenham algorithm details
-    printf("\n╔════════════════════════════════════════════════════╗\n");
-    printf("║    Bresenham's Algorithm Calculation Details      ║\n");
-    printf("╚════════════════════════════════════════════════════╝\n");
-    printf("  Starting Point (x1, y1) : (%d, %d)\n", x1, y1);
-    printf("  Ending Point   (x2, y2) : (%d, %d)\n", x2, y2);
-    printf("  ────────────────────────────────────────────────────\n");
-    printf("  dx = |x2 - x1| = |%d - %d| = %d\n", x2, x1, dx);
-    printf("  dy = |y2 - y1| = |%d - %d| = %d\n", y2, y1, dy);
-    printf("  ────────────────────────────────────────────────────\n");
-    printf("  sx (x step direction) = %d\n", sx);
-    printf("  sy (y step direction) = %d\n", sy);
-    printf("  ────────────────────────────────────────────────────\n");
-    printf("  Initial error = dx - dy = %d - %d = %d\n", dx, dy, err);
-    printf("╚════════════════════════════════════════════════════╝\n\n");
-    
-    int pixelCount = 0;
-    
-    // Main loop - draw line pixel by pixel
-    while (1) {
-        // Plot current point
-        SDL_RenderDrawPoint(renderer, x, y);
-        pixelCount++;
-        
-        // Check if we've reached the end point
-        if (x == x2 && y == y2) {
-            break;
-        }
-        
-        e2 = 2 * err;
-        
-        // Move in x direction
-        if (e2 > -dy) {
-            err -= dy;
-            x += sx;
-        }
-        
-        // Move in y direction
-        if (e2 < dx) {
-            err += dx;
-            y += sy;
-        }
+int main(int argc, char* argv[]) {
+    int width = argc > 2 ? atoi(argv[1]) : WINDOW_WIDTH;
+    int height = argc > 2 ? atoi(argv[2]) : WINDOW_HEIGHT;
+    if (width <= 0 || height <= 0) {
+        printf("Invalid window size %s x %s\n", argv[1], argv[2]);
+        return 1;
     }
     
-    printf("✓ Line drawn successfully!\n");
-    printf("  Total pixels plotted: %d\n", pixelCount);
-}
-
-int main(int argc, char* argv[]) {
     int x1, y1, x2, y2;
     
     printf("\n");
@@ -76,8 +22,9 @@ int main(int argc, char* argv[]) {
     printf("║     Bresenham's Line Generation Algorithm           ║\n");
     printf("╚══════════════════════════════════════════════════════╝\n\n");
     
-    printf("Window size: %d x %d pixels\n", WINDOW_WIDTH, WINDOW_HEIGHT);
-    printf("Valid coordinates: x (0-%d), y (0-%d)\n\n", WINDOW_WIDTH-1, WINDOW_HEIGHT-1);
+    printf("Window size: %d x %d pixels\n", width, height);
+    printf("Visible area: x (0-%d), y (0-%d)\n", width-1, height-1);
+    printf("Points outside it are allowed; the line is clipped to the window.\n\n");
     
     // Get user input for line coordinates
     printf("Enter the starting point coordinates:\n");
@@ -92,79 +39,33 @@ int main(int argc, char* argv[]) {
     printf("  y2: ");
     scanf("%d", &y2);
     
-    // Validate coordinates
-    if (x1 < 0 || x1 >= WINDOW_WIDTH || x2 < 0 || x2 >= WINDOW_WIDTH ||
-        y1 < 0 || y1 >= WINDOW_HEIGHT || y2 < 0 || y2 >= WINDOW_HEIGHT) {
-        printf("\n⚠ ERROR: Coordinates must be within window bounds!\n");
-        printf("   x: 0 to %d\n", WINDOW_WIDTH-1);
-        printf("   y: 0 to %d\n", WINDOW_HEIGHT-1);
+    Framebuffer* fb = createFramebuffer(width, height, PIXEL_RGB24);
+    if (!fb) {
+        printf("\n✗ Memory allocation failed!\n");
         return 1;
     }
     
-    // Initialize SDL
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        printf("\n✗ SDL initialization failed: %s\n", SDL_GetError());
-        return 1;
-    }
-    
-    // Create window
-    SDL_Window* window = SDL_CreateWindow(
-        "Bresenham's Line Algorithm",
-        SDL_WINDOWPOS_CENTERED,
-        SDL_WINDOWPOS_CENTERED,
-        WINDOW_WIDTH,
-        WINDOW_HEIGHT,
-        SDL_WINDOW_SHOWN
-    );
+    // Clear with white background
+    clearFramebuffer(fb, COLOR_WHITE);
     
-    if (!window) {
-        printf("\n✗ Window creation failed: %s\n", SDL_GetError());
-        SDL_Quit();
-        return 1;
-    }
-    
-    // Create renderer
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    if (!renderer) {
-        printf("\n✗ Renderer creation failed: %s\n", SDL_GetError());
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        return 1;
-    }
-    
-    // Clear screen with white background
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-    SDL_RenderClear(renderer);
-    
-    // Set drawing color to blue for Bresenham line
-    SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255);
-    
-    // Draw the line using Bresenham's algorithm
-    drawLineBresenham(renderer, x1, y1, x2, y2);
+    // Draw the line in blue using Bresenham's algorithm, printing the
+    // calculation table through the trace sink
+    setTraceSink(traceSinkText, stdout);
+    setTraceLevel(TRACE_SUMMARY);
+    drawLineBresenham(fb, x1, y1, x2, y2, COLOR_BLUE);
+    setTraceLevel(TRACE_OFF);
     
     // Draw small circles at start and end points for clarity
-    // Red circle at starting point
-    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-    for (int dx = -4; dx <= 4; dx++) {
-        for (int dy = -4; dy <= 4; dy++) {
-            if (dx*dx + dy*dy <= 16) {
-                SDL_RenderDrawPoint(renderer, x1 + dx, y1 + dy);
-            }
-        }
-    }
+    drawMarker(fb, x1, y1, 4, COLOR_RED);     // Red circle at starting point
+    drawMarker(fb, x2, y2, 4, COLOR_GREEN);   // Green circle at ending point
     
-    // Green circle at ending point
-    SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
-    for (int dx = -4; dx <= 4; dx++) {
-        for (int dy = -4; dy <= 4; dy++) {
-            if (dx*dx + dy*dy <= 16) {
-                SDL_RenderDrawPoint(renderer, x2 + dx, y2 + dy);
-            }
-        }
+    // Open the window and show the finished frame
+    SdlPresenter* presenter = createPresenter("Bresenham's Line Algorithm", width, height);
+    if (!presenter) {
+        destroyFramebuffer(fb);
+        return 1;
     }
-    
-    // Update screen to show the line
-    SDL_RenderPresent(renderer);
+    presentFramebuffer(presenter, fb);
     
     printf("\n");
     printf("Window opened with your line!\n");
@@ -177,26 +78,28 @@ int main(int argc, char* argv[]) {
     int quit = 0;
     SDL_Event e;
     
-    while (!quit) {
-        while (SDL_PollEvent(&e) != 0) {
-            if (e.type == SDL_QUIT) {
-                quit = 1;
+    // Sleep until something happens instead of polling
+    while (!quit && SDL_WaitEvent(&e)) {
+        if (e.type == SDL_QUIT) {
+            quit = 1;
+        }
+        else if (e.type == SDL_WINDOWEVENT) {
+            // The frame is still in the texture; show it again
+            if (e.window.event == SDL_WINDOWEVENT_EXPOSED) {
+                redrawPresenter(presenter);
             }
-            else if (e.type == SDL_KEYDOWN) {
-                if (e.key.keysym.sym == SDLK_ESCAPE) {
-                    quit = 1;
-                }
+        }
+        else if (e.type == SDL_KEYDOWN) {
+            if (e.key.keysym.sym == SDLK_ESCAPE) {
+                quit = 1;
             }
         }
-        SDL_Delay(10);
     }
     
     // Cleanup
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    destroyPresenter(presenter);
+    destroyFramebuffer(fb);
     
     printf("\nProgram ended. Goodbye!\n\n");
     return 0;
 }
-
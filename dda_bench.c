@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raster.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#define REPEATS 5
+#define ALGORITHMS 5
+
+// Cycles per pixel for float, fixed-point and SIMD DDA, run-slice and plain
+// Bresenham on the same seeded workload, plus a pixel-for-pixel comparison
+// against Bresenham.
+//
+//   ./dda_bench [segment count] [long|shallow]
+//
+// "long" switches from random segments on 800x600 to long near-diagonal
+// lines on a 3840x2160 canvas; "shallow" draws near-horizontal chart-style
+// lines (|slope| <= 1/16) on 800x600.
+
+static unsigned long long readCounter(void) {
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Fastest of REPEATS runs, in counter ticks; also leaves the final image in fb
+static unsigned long long timeAlgorithm(Framebuffer* fb, const Segment* segments, size_t count,
+                                        LineAlgorithm algorithm, BatchStats* stats) {
+    unsigned long long best = 0;
+    
+    for (int run = 0; run < REPEATS; run++) {
+        BatchStats runStats;
+        clearFramebuffer(fb, COLOR_WHITE);
+        unsigned long long start = readCounter();
+        drawLineBatch(fb, segments, count, algorithm, &runStats);
+        unsigned long long ticks = readCounter() - start;
+        if (run == 0 || runStats.seconds < stats->seconds) {
+            best = ticks;
+            *stats = runStats;
+        }
+    }
+    return best;
+}
+
+static size_t countDifferences(const Framebuffer* a, const Framebuffer* b) {
+    size_t differences = 0;
+    
+    for (int y = 0; y < a->height; y++) {
+        for (int x = 0; x < a->width; x++) {
+            const Pixel* p = &a->pixels[y * a->stride + x];
+            const Pixel* q = &b->pixels[y * b->stride + x];
+            if (p->r != q->r || p->g != q->g || p->b != q->b) {
+                differences++;
+            }
+        }
+    }
+    return differences;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    int longLines = argc > 2 && strcmp(argv[2], "long") == 0;
+    int shallowLines = argc > 2 && strcmp(argv[2], "shallow") == 0;
+    int width = longLines ? 3840 : 800;
+    int height = longLines ? 2160 : 600;
+    
+    Pixel* pixels[ALGORITHMS];
+    Segment* segments = malloc(sizeof(Segment) * (count ? count : 1));
+    int allocated = segments != NULL;
+    for (int i = 0; i < ALGORITHMS; i++) {
+        pixels[i] = malloc(sizeof(Pixel) * width * height);
+        allocated = allocated && pixels[i] != NULL;
+    }
+    if (!allocated) {
+        printf("Memory allocation failed!\n");
+        return 1;
+    }
+    
+    srand(12345);
+    for (size_t i = 0; i < count; i++) {
+        if (longLines) {
+            // Corner-to-corner-ish diagonals, jittered along the edges
+            segments[i].x1 = rand() % (width / 8);
+            segments[i].y1 = rand() % height;
+            segments[i].x2 = width - 1 - rand() % (width / 8);
+            segments[i].y2 = rand() % height;
+        } else if (shallowLines) {
+            segments[i].x1 = rand() % width;
+            segments[i].y1 = rand() % height;
+            segments[i].x2 = rand() % width;
+            segments[i].y2 = segments[i].y1 + (segments[i].x2 - segments[i].x1) / 16;
+            if (segments[i].y2 < 0 || segments[i].y2 >= height) {
+                segments[i].y2 = segments[i].y1;
+            }
+        } else {
+            segments[i].x1 = rand() % width;
+            segments[i].y1 = rand() % height;
+            segments[i].x2 = rand() % width;
+            segments[i].y2 = rand() % height;
+        }
+        segments[i].color = COLOR_RGB(rand() % 256, rand() % 256, rand() % 256);
+    }
+    
+    const char* names[ALGORITHMS] = {
+        "DDA (float)", "DDA (32.32 fixed)", "DDA (SIMD)", "Bresenham (runs)", "Bresenham"
+    };
+    LineAlgorithm algorithms[ALGORITHMS] = {
+        LINE_DDA, LINE_DDA_FIXED, LINE_DDA_SIMD, LINE_RUN_SLICE, LINE_BRESENHAM
+    };
+    Framebuffer fb[ALGORITHMS];
+    
+    printf("Workload: %zu %s segments on %d x %d, best of %d runs\n",
+           count, longLines ? "long" : shallowLines ? "shallow" : "random", width, height, REPEATS);
+    printf("SIMD kernel: %s\n\n", simdLevelName(activeSimdLevel()));
+#ifdef HAVE_RDTSC
+    printf("%-20s %14s %14s %16s\n", "Algorithm", "cycles/pixel", "ns/pixel", "segments/s");
+#else
+    printf("%-20s %14s %16s\n", "Algorithm", "ns/pixel", "segments/s");
+#endif
+    
+    for (int i = 0; i < ALGORITHMS; i++) {
+        BatchStats stats;
+        initFramebuffer(&fb[i], pixels[i], width, height);
+        unsigned long long ticks = timeAlgorithm(&fb[i], segments, count, algorithms[i], &stats);
+        double pixelsDrawn = stats.pixels ? (double)stats.pixels : 1.0;
+        
+#ifdef HAVE_RDTSC
+        printf("%-20s %14.2f %14.3f %16.0f\n", names[i], ticks / pixelsDrawn,
+               stats.seconds * 1e9 / pixelsDrawn, stats.segmentsPerSecond);
+#else
+        (void)ticks;
+        printf("%-20s %14.3f %16.0f\n", names[i],
+               stats.seconds * 1e9 / pixelsDrawn, stats.segmentsPerSecond);
+#endif
+    }
+    
+    printf("\nPixels differing from Bresenham:\n");
+    for (int i = 0; i < ALGORITHMS - 1; i++) {
+        printf("  %-18s: %zu\n", names[i], countDifferences(&fb[i], &fb[ALGORITHMS - 1]));
+    }
+    
+    free(segments);
+    for (int i = 0; i < ALGORITHMS; i++) {
+        free(pixels[i]);
+    }
+    return 0;
+}
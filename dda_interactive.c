@@ -1,99 +1,123 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include "raster.h"
+#include "raster_farm.h"
+#include "raster_image.h"
+#include "raster_trace.h"
 
 #define WIDTH 800
 #define HEIGHT 600
 
-typedef struct {
-    unsigned char r, g, b;
-} Pixel;
+// Usage: ./dda_interactive [width height [output file]]
+//
+// The output defaults to my_lines.ppm. A PPM or PAM image is drawn
+// straight into the file through a memory mapping, so saving copies
+// nothing, and a large canvas (16384 x 16384 is 768 MB) is paged to the
+// file rather than held in allocated memory. A .png or .qoi output (or a
+// file that cannot be mapped) is drawn in memory and written at the end.
+//
+// Usage: ./dda_interactive --frames count [width height [output file]]
+//
+// Renders `count` frames of a turning fan of DDA lines without prompting,
+// on every core, as numbered files: frame.png (the default) becomes
+// frame000000.png, frame000001.png and so on.
 
-void initImage(Pixel image[HEIGHT][WIDTH]) {
-    for (int i = 0; i < HEIGHT; i++) {
-        for (int j = 0; j < WIDTH; j++) {
-            image[i][j].r = 255;
-            image[i][j].g = 255;
-            image[i][j].b = 255;
-        }
+#define FAN_SPOKES 72
+#define FAN_PERIOD 360      // frames per full turn
+
+static void drawFanFrame(Framebuffer* fb, int frame, void* arg) {
+    const double pi = 3.14159265358979323846;
+    int cx = fb->width / 2;
+    int cy = fb->height / 2;
+    double radius = (fb->width < fb->height ? fb->width : fb->height) / 2.0 - 4.0;
+    (void)arg;
+
+    clearFramebuffer(fb, COLOR_WHITE);
+    for (int i = 0; i < FAN_SPOKES; i++) {
+        double angle = 2.0 * pi * (i / (double)FAN_SPOKES + frame / (double)(FAN_PERIOD * FAN_SPOKES));
+        double length = radius * (0.55 + 0.45 * (i % 2));
+        Color color = COLOR_RGB(255 * i / FAN_SPOKES, 0, 255 - 255 * i / FAN_SPOKES);
+        drawLineDDA(fb, cx, cy, cx + (int)lround(length * cos(angle)),
+                    cy + (int)lround(length * sin(angle)), color);
     }
 }
 
-void setPixel(Pixel image[HEIGHT][WIDTH], int x, int y, unsigned char r, unsigned char g, unsigned char b) {
-    if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
-        image[y][x].r = r;
-        image[y][x].g = g;
-        image[y][x].b = b;
+static int renderFanFrames(int argc, char* argv[]) {
+    int count = argc > 2 ? atoi(argv[2]) : 0;
+    int width = argc > 4 ? atoi(argv[3]) : WIDTH;
+    int height = argc > 4 ? atoi(argv[4]) : HEIGHT;
+    const char* path = argc > 5 ? argv[5] : "frame.png";
+
+    if (count <= 0 || width <= 0 || height <= 0) {
+        printf("Usage: %s --frames count [width height [output file]]\n", argv[0]);
+        return 1;
     }
-}
 
-void drawLineDDA(Pixel image[HEIGHT][WIDTH], int x1, int y1, int x2, int y2, 
-                 unsigned char r, unsigned char g, unsigned char b) {
-    int dx = x2 - x1;
-    int dy = y2 - y1;
-    
-    int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
-    
-    float xIncrement = (float)dx / (float)steps;
-    float yIncrement = (float)dy / (float)steps;
-    
-    float x = x1;
-    float y = y1;
-    
-    printf("\n--- DDA Algorithm Details ---\n");
-    printf("Starting point: (%d, %d)\n", x1, y1);
-    printf("Ending point: (%d, %d)\n", x2, y2);
-    printf("dx = %d, dy = %d\n", dx, dy);
-    printf("Number of steps = %d\n", steps);
-    printf("x increment = %.4f\n", xIncrement);
-    printf("y increment = %.4f\n", yIncrement);
-    printf("----------------------------\n\n");
-    
-    for (int i = 0; i <= steps; i++) {
-        setPixel(image, (int)round(x), (int)round(y), r, g, b);
-        x += xIncrement;
-        y += yIncrement;
+    FrameFarm* farm = createFrameFarm(0, width, height);
+    if (!farm) {
+        printf("Could not start the render threads\n");
+        return 1;
     }
+
+    FarmStats stats;
+    char first[4096];
+    renderFrames(farm, count, drawFanFrame, NULL, path, imageFormatForPath(path), &stats);
+    frameFilePath(first, sizeof(first), path, 0);
+    printf("Frames         : %zu (%d threads)\n", stats.frames, frameFarmThreads(farm));
+    printf("Failed         : %zu\n", stats.failed);
+    printf("Time           : %.3f s\n", stats.seconds);
+    printf("Frames/second  : %.1f\n", stats.framesPerSecond);
+    printf("First frame    : %s\n", first);
+    destroyFrameFarm(farm);
+    return stats.failed == 0 ? 0 : 1;
 }
 
-void saveImage(Pixel image[HEIGHT][WIDTH], const char *filename) {
-    FILE *fp = fopen(filename, "wb");
-    if (!fp) {
-        printf("Error: Could not open file %s for writing\n", filename);
-        return;
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--frames") == 0) {
+        return renderFanFrames(argc, argv);
     }
-    
-    fprintf(fp, "P6\n%d %d\n255\n", WIDTH, HEIGHT);
-    
-    for (int i = 0; i < HEIGHT; i++) {
-        for (int j = 0; j < WIDTH; j++) {
-            fwrite(&image[i][j], 3, 1, fp);
-        }
-    }
-    
-    fclose(fp);
-    printf("✓ Image saved as %s\n", filename);
-}
 
-int main() {
-    Pixel (*image)[WIDTH] = malloc(sizeof(Pixel) * HEIGHT * WIDTH);
-    if (!image) {
-        printf("Memory allocation failed!\n");
+    const char* filename = argc > 3 ? argv[3] : "my_lines.ppm";
+    ImageFormat format = imageFormatForPath(filename);
+    int width = argc > 2 ? atoi(argv[1]) : WIDTH;
+    int height = argc > 2 ? atoi(argv[2]) : HEIGHT;
+    
+    if (width <= 0 || height <= 0) {
+        printf("Invalid image size %s x %s\n", argv[1], argv[2]);
         return 1;
     }
     
-    initImage(image);
+    Framebuffer* heapImage = NULL;
+    Framebuffer* image;
+    MappedImage* mapped = createMappedImage(filename, width, height, format);
+    if (mapped) {
+        image = mappedFramebuffer(mapped);
+    } else {
+        heapImage = createFramebuffer(width, height, PIXEL_RGB24);
+        if (!heapImage) {
+            printf("Memory allocation failed!\n");
+            return 1;
+        }
+        image = heapImage;
+    }
+    clearFramebuffer(image, COLOR_WHITE);
     
     printf("╔═══════════════════════════════════════════════════╗\n");
     printf("║  DDA (Digital Differential Analyzer) Algorithm    ║\n");
     printf("║  Line Drawing Program                             ║\n");
     printf("╚═══════════════════════════════════════════════════╝\n\n");
     
-    printf("Image dimensions: %d x %d pixels\n\n", WIDTH, HEIGHT);
+    printf("Image dimensions: %d x %d pixels\n\n", width, height);
     
     int x1, y1, x2, y2;
     char choice;
     
+    // Print each line's calculation details as it is drawn
+    setTraceSink(traceSinkText, stdout);
+    setTraceLevel(TRACE_SUMMARY);
+    
     do {
         printf("Enter starting point (x1 y1): ");
         scanf("%d %d", &x1, &y1);
@@ -101,16 +125,16 @@ int main() {
         printf("Enter ending point (x2 y2): ");
         scanf("%d %d", &x2, &y2);
         
-        // Validate input
-        if (x1 < 0 || x1 >= WIDTH || x2 < 0 || x2 >= WIDTH ||
-            y1 < 0 || y1 >= HEIGHT || y2 < 0 || y2 >= HEIGHT) {
-            printf("\n⚠ Warning: Coordinates should be within range:\n");
-            printf("  x: 0 to %d\n", WIDTH-1);
-            printf("  y: 0 to %d\n\n", HEIGHT-1);
+        // Off-image endpoints are fine; the line is clipped to the image
+        if (x1 < 0 || x1 >= width || x2 < 0 || x2 >= width ||
+            y1 < 0 || y1 >= height || y2 < 0 || y2 >= height) {
+            printf("\nNote: part of this line is outside the image and will be clipped to:\n");
+            printf("  x: 0 to %d\n", width-1);
+            printf("  y: 0 to %d\n\n", height-1);
         }
         
         // Draw the line (in red)
-        drawLineDDA(image, x1, y1, x2, y2, 255, 0, 0);
+        drawLineDDA(image, x1, y1, x2, y2, COLOR_RED);
         
         printf("Do you want to draw another line? (y/n): ");
         scanf(" %c", &choice);
@@ -118,14 +142,22 @@ int main() {
         
     } while (choice == 'y' || choice == 'Y');
     
-    saveImage(image, "my_lines.ppm");
+    int saved = mapped ? syncMappedImage(mapped) : saveFramebuffer(image, filename, format);
+    if (saved) {
+        printf("✓ Image saved as %s\n", filename);
+    } else {
+        printf("Error: Could not write file %s\n", filename);
+    }
     
     printf("\nTo view your image, use:\n");
-    printf("  eog my_lines.ppm\n");
-    printf("Or convert to PNG:\n");
-    printf("  convert my_lines.ppm my_lines.png\n\n");
+    printf("  eog %s\n", filename);
+    if (format == IMAGE_PPM || format == IMAGE_PAM) {
+        printf("Or save it compressed next time:\n");
+        printf("  ./dda_interactive %d %d my_lines.png\n", width, height);
+    }
+    printf("\n");
     
-    free(image);
-    return 0;
+    closeMappedImage(mapped);
+    destroyFramebuffer(heapImage);
+    return saved ? 0 : 1;
 }
-
@@ -1,59 +1,44 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
-#include <SDL2/SDL.h>
+#include "raster.h"
+#include "raster_scene.h"
+#include "sdl_presenter.h"
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 
-// DDA Line Drawing Algorithm
-void drawLineDDA(SDL_Renderer* renderer, int x1, int y1, int x2, int y2) {
-    int dx = x2 - x1;
-    int dy = y2 - y1;
-    int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
-    
-    float xIncrement = (float)dx / (float)steps;
-    float yIncrement = (float)dy / (float)steps;
-    
-    float x = x1;
-    float y = y1;
-    
-    printf("Drawing line: (%d,%d) -> (%d,%d) | dx=%d dy=%d steps=%d\n", 
-           x1, y1, x2, y2, dx, dy, steps);
-    
-    for (int i = 0; i <= steps; i++) {
-        SDL_RenderDrawPoint(renderer, (int)round(x), (int)round(y));
-        x += xIncrement;
-        y += yIncrement;
+// Items one finished line adds to the scene: start marker, line, end marker
+#define ITEMS_PER_LINE 3
+
+// Upload whatever the scene changed since the last frame
+static void presentScene(SdlPresenter* presenter, Scene* scene) {
+    ClipRect damage[SCENE_MAX_DAMAGE];
+    int count = takeSceneDamage(scene, damage);
+    if (count > 0) {
+        presentFramebufferRects(presenter, sceneFramebuffer(scene), damage, count);
     }
 }
 
 int main(int argc, char* argv[]) {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        printf("SDL initialization failed! %s\n", SDL_GetError());
+    int width = argc > 2 ? atoi(argv[1]) : WINDOW_WIDTH;
+    int height = argc > 2 ? atoi(argv[2]) : WINDOW_HEIGHT;
+    if (width <= 0 || height <= 0) {
+        printf("Invalid window size %s x %s\n", argv[1], argv[2]);
         return 1;
     }
     
-    SDL_Window* window = SDL_CreateWindow(
-        "DDA Line Drawing - Interactive (Click to draw!)",
-        SDL_WINDOWPOS_CENTERED,
-        SDL_WINDOWPOS_CENTERED,
-        WINDOW_WIDTH,
-        WINDOW_HEIGHT,
-        SDL_WINDOW_SHOWN
-    );
-    
-    if (!window) {
-        printf("Window creation failed! %s\n", SDL_GetError());
-        SDL_Quit();
+    // The scene keeps every line, so a change only redraws and uploads
+    // the region it touches
+    Scene* scene = createScene(width, height, COLOR_WHITE);
+    if (!scene) {
+        printf("Memory allocation failed!\n");
         return 1;
     }
     
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    if (!renderer) {
-        printf("Renderer creation failed! %s\n", SDL_GetError());
-        SDL_DestroyWindow(window);
-        SDL_Quit();
+    SdlPresenter* presenter = createPresenter("DDA Line Drawing - Interactive (Click to draw!)",
+                                              width, height);
+    if (!presenter) {
+        destroyScene(scene);
         return 1;
     }
     
@@ -63,99 +48,103 @@ int main(int argc, char* argv[]) {
     printf("Instructions:\n");
     printf("  1. Click to set the starting point (you'll see a small circle)\n");
     printf("  2. Click again to set the ending point and draw the line\n");
-    printf("  3. Press 'C' to clear the screen\n");
-    printf("  4. Press 'ESC' or close window to exit\n\n");
+    printf("  3. Press 'U' or Backspace to undo the last line\n");
+    printf("  4. Press 'C' to clear the screen\n");
+    printf("  5. Press 'ESC' or close window to exit\n\n");
     
-    // Clear with white background
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-    SDL_RenderClear(renderer);
-    SDL_RenderPresent(renderer);
+    presentScene(presenter, scene);
     
     int quit = 0;
     SDL_Event e;
     int clickCount = 0;
     int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
     
-    while (!quit) {
-        while (SDL_PollEvent(&e) != 0) {
-            if (e.type == SDL_QUIT) {
+    // Sleep until something happens instead of polling
+    while (!quit && SDL_WaitEvent(&e)) {
+        if (e.type == SDL_QUIT) {
+            quit = 1;
+        }
+        else if (e.type == SDL_WINDOWEVENT) {
+            if (e.window.event == SDL_WINDOWEVENT_EXPOSED) {
+                redrawPresenter(presenter);
+            }
+        }
+        else if (e.type == SDL_KEYDOWN) {
+            SDL_Keycode key = e.key.keysym.sym;
+            if (key == SDLK_ESCAPE) {
                 quit = 1;
             }
-            else if (e.type == SDL_KEYDOWN) {
-                if (e.key.keysym.sym == SDLK_ESCAPE) {
-                    quit = 1;
-                }
-                else if (e.key.keysym.sym == SDLK_c) {
-                    // Clear screen
-                    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-                    SDL_RenderClear(renderer);
-                    SDL_RenderPresent(renderer);
+            else if (key == SDLK_c) {
+                // Clear screen
+                sceneClear(scene);
+                clickCount = 0;
+                printf("\nScreen cleared!\n");
+            }
+            else if (key == SDLK_u || key == SDLK_BACKSPACE) {
+                // Undo the pending start point, or else the last line
+                if (clickCount == 1) {
+                    sceneRemoveLast(scene, 1);
                     clickCount = 0;
-                    printf("\nScreen cleared!\n");
+                    printf("\nStart point removed.\n");
+                }
+                else if (sceneItemCount(scene) >= ITEMS_PER_LINE) {
+                    sceneRemoveLast(scene, ITEMS_PER_LINE);
+                    printf("\nLast line removed.\n");
                 }
             }
-            else if (e.type == SDL_MOUSEBUTTONDOWN) {
-                if (e.button.button == SDL_BUTTON_LEFT) {
-                    int mouseX = e.button.x;
-                    int mouseY = e.button.y;
+        }
+        else if (e.type == SDL_MOUSEBUTTONDOWN) {
+            if (e.button.button == SDL_BUTTON_LEFT) {
+                int mouseX = e.button.x;
+                int mouseY = e.button.y;
+                
+                if (clickCount == 0) {
+                    // First click - starting point
+                    x1 = mouseX;
+                    y1 = mouseY;
                     
-                    if (clickCount == 0) {
-                        // First click - starting point
-                        x1 = mouseX;
-                        y1 = mouseY;
+                    // Draw a small circle to show starting point
+                    if (sceneAddMarker(scene, x1, y1, 3, COLOR_RED) == 0) {
                         clickCount = 1;
-                        
-                        // Draw a small circle to show starting point
-                        SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-                        for (int dx = -3; dx <= 3; dx++) {
-                            for (int dy = -3; dy <= 3; dy++) {
-                                if (dx*dx + dy*dy <= 9) {
-                                    SDL_RenderDrawPoint(renderer, x1 + dx, y1 + dy);
-                                }
-                            }
-                        }
-                        SDL_RenderPresent(renderer);
-                        
                         printf("\nStart point: (%d, %d) - Click again for end point\n", x1, y1);
                     }
+                }
+                else {
+                    // Second click - ending point, draw line
+                    x2 = mouseX;
+                    y2 = mouseY;
+                    
+                    printf("End point: (%d, %d)\n", x2, y2);
+                    
+                    // Draw the line using DDA
+                    int dx = x2 - x1;
+                    int dy = y2 - y1;
+                    int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+                    printf("Drawing line: (%d,%d) -> (%d,%d) | dx=%d dy=%d steps=%d\n", 
+                           x1, y1, x2, y2, dx, dy, steps);
+                    
+                    // Line and end point marker; on failure, drop the whole
+                    // line, start marker included
+                    size_t before = sceneItemCount(scene);
+                    if (sceneAddLine(scene, x1, y1, x2, y2, COLOR_BLUE, LINE_DDA) != 0 ||
+                        sceneAddMarker(scene, x2, y2, 3, COLOR_GREEN) != 0) {
+                        sceneRemoveLast(scene, sceneItemCount(scene) - before + 1);
+                        printf("Out of memory - line not added.\n");
+                    }
                     else {
-                        // Second click - ending point, draw line
-                        x2 = mouseX;
-                        y2 = mouseY;
-                        
-                        printf("End point: (%d, %d)\n", x2, y2);
-                        
-                        // Draw the line using DDA
-                        SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255);
-                        drawLineDDA(renderer, x1, y1, x2, y2);
-                        
-                        // Draw end point marker
-                        SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
-                        for (int dx = -3; dx <= 3; dx++) {
-                            for (int dy = -3; dy <= 3; dy++) {
-                                if (dx*dx + dy*dy <= 9) {
-                                    SDL_RenderDrawPoint(renderer, x2 + dx, y2 + dy);
-                                }
-                            }
-                        }
-                        
-                        SDL_RenderPresent(renderer);
-                        clickCount = 0;
-                        
                         printf("✓ Line drawn! Click again to draw another line.\n");
                     }
+                    clickCount = 0;
                 }
             }
         }
         
-        SDL_Delay(10);
+        presentScene(presenter, scene);
     }
     
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    destroyPresenter(presenter);
+    destroyScene(scene);
     
     printf("\nProgram closed.\n");
     return 0;
 }
-
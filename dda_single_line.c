@@ -1,55 +1,20 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
-#include <SDL2/SDL.h>
+#include "raster.h"
+#include "raster_trace.h"
+#include "sdl_presenter.h"
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 
-// DDA Line Drawing Algorithm
-void drawLineDDA(SDL_Renderer* renderer, int x1, int y1, int x2, int y2) {
-    // Calculate differences
-    int dx = x2 - x1;
-    int dy = y2 - y1;
-    
-    // Calculate steps required for generating pixels
-    int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
-    
-    // Calculate increment in x & y for each step
-    float xIncrement = (float)dx / (float)steps;
-    float yIncrement = (float)dy / (float)steps;
-    
-    // Starting point
-    float x = x1;
-    float y = y1;
-    
-    // Display DDA algorithm details
-    printf("\n╔════════════════════════════════════════════╗\n");
-    printf("║    DDA Algorithm Calculation Details      ║\n");
-    printf("╚════════════════════════════════════════════╝\n");
-    printf("  Starting Point (x1, y1) : (%d, %d)\n", x1, y1);
-    printf("  Ending Point   (x2, y2) : (%d, %d)\n", x2, y2);
-    printf("  ──────────────────────────────────────────\n");
-    printf("  dx = x2 - x1 = %d - %d = %d\n", x2, x1, dx);
-    printf("  dy = y2 - y1 = %d - %d = %d\n", y2, y1, dy);
-    printf("  ──────────────────────────────────────────\n");
-    printf("  Steps = max(|dx|, |dy|) = max(%d, %d) = %d\n", abs(dx), abs(dy), steps);
-    printf("  ──────────────────────────────────────────\n");
-    printf("  x increment = dx/steps = %d/%d = %.4f\n", dx, steps, xIncrement);
-    printf("  y increment = dy/steps = %d/%d = %.4f\n", dy, steps, yIncrement);
-    printf("╚════════════════════════════════════════════╝\n\n");
-    
-    // Draw each pixel point
-    printf("Drawing %d pixels...\n", steps + 1);
-    for (int i = 0; i <= steps; i++) {
-        SDL_RenderDrawPoint(renderer, (int)round(x), (int)round(y));
-        x += xIncrement;
-        y += yIncrement;
-    }
-    printf("✓ Line drawn successfully!\n");
-}
-
 int main(int argc, char* argv[]) {
+    int width = argc > 2 ? atoi(argv[1]) : WINDOW_WIDTH;
+    int height = argc > 2 ? atoi(argv[2]) : WINDOW_HEIGHT;
+    if (width <= 0 || height <= 0) {
+        printf("Invalid window size %s x %s\n", argv[1], argv[2]);
+        return 1;
+    }
+    
     int x1, y1, x2, y2;
     
     printf("\n");
@@ -57,8 +22,9 @@ int main(int argc, char* argv[]) {
     printf("║  DDA (Digital Differential Analyzer) Line Drawing   ║\n");
     printf("╚══════════════════════════════════════════════════════╝\n\n");
     
-    printf("Window size: %d x %d pixels\n", WINDOW_WIDTH, WINDOW_HEIGHT);
-    printf("Valid coordinates: x (0-%d), y (0-%d)\n\n", WINDOW_WIDTH-1, WINDOW_HEIGHT-1);
+    printf("Window size: %d x %d pixels\n", width, height);
+    printf("Visible area: x (0-%d), y (0-%d)\n", width-1, height-1);
+    printf("Points outside it are allowed; the line is clipped to the window.\n\n");
     
     // Get user input for line coordinates
     printf("Enter the starting point coordinates:\n");
@@ -73,79 +39,33 @@ int main(int argc, char* argv[]) {
     printf("  y2: ");
     scanf("%d", &y2);
     
-    // Validate coordinates
-    if (x1 < 0 || x1 >= WINDOW_WIDTH || x2 < 0 || x2 >= WINDOW_WIDTH ||
-        y1 < 0 || y1 >= WINDOW_HEIGHT || y2 < 0 || y2 >= WINDOW_HEIGHT) {
-        printf("\n⚠ ERROR: Coordinates must be within window bounds!\n");
-        printf("   x: 0 to %d\n", WINDOW_WIDTH-1);
-        printf("   y: 0 to %d\n", WINDOW_HEIGHT-1);
-        return 1;
-    }
-    
-    // Initialize SDL
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        printf("\n✗ SDL initialization failed: %s\n", SDL_GetError());
-        return 1;
-    }
-    
-    // Create window
-    SDL_Window* window = SDL_CreateWindow(
-        "DDA Line Drawing Algorithm",
-        SDL_WINDOWPOS_CENTERED,
-        SDL_WINDOWPOS_CENTERED,
-        WINDOW_WIDTH,
-        WINDOW_HEIGHT,
-        SDL_WINDOW_SHOWN
-    );
-    
-    if (!window) {
-        printf("\n✗ Window creation failed: %s\n", SDL_GetError());
-        SDL_Quit();
+    Framebuffer* fb = createFramebuffer(width, height, PIXEL_RGB24);
+    if (!fb) {
+        printf("\n✗ Memory allocation failed!\n");
         return 1;
     }
     
-    // Create renderer
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    if (!renderer) {
-        printf("\n✗ Renderer creation failed: %s\n", SDL_GetError());
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-        return 1;
-    }
-    
-    // Clear screen with white background
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-    SDL_RenderClear(renderer);
-    
-    // Set drawing color to black
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    // Clear with white background
+    clearFramebuffer(fb, COLOR_WHITE);
     
-    // Draw the line using DDA algorithm
-    drawLineDDA(renderer, x1, y1, x2, y2);
+    // Draw the line in black using DDA algorithm, printing the
+    // calculation table through the trace sink
+    setTraceSink(traceSinkText, stdout);
+    setTraceLevel(TRACE_SUMMARY);
+    drawLineDDA(fb, x1, y1, x2, y2, COLOR_BLACK);
+    setTraceLevel(TRACE_OFF);
     
     // Draw small circles at start and end points for clarity
-    // Red circle at starting point
-    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-    for (int dx = -4; dx <= 4; dx++) {
-        for (int dy = -4; dy <= 4; dy++) {
-            if (dx*dx + dy*dy <= 16) {
-                SDL_RenderDrawPoint(renderer, x1 + dx, y1 + dy);
-            }
-        }
-    }
+    drawMarker(fb, x1, y1, 4, COLOR_RED);     // Red circle at starting point
+    drawMarker(fb, x2, y2, 4, COLOR_GREEN);   // Green circle at ending point
     
-    // Green circle at ending point
-    SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
-    for (int dx = -4; dx <= 4; dx++) {
-        for (int dy = -4; dy <= 4; dy++) {
-            if (dx*dx + dy*dy <= 16) {
-                SDL_RenderDrawPoint(renderer, x2 + dx, y2 + dy);
-            }
-        }
+    // Open the window and show the finished frame
+    SdlPresenter* presenter = createPresenter("DDA Line Drawing Algorithm", width, height);
+    if (!presenter) {
+        destroyFramebuffer(fb);
+        return 1;
     }
-    
-    // Update screen to show the line
-    SDL_RenderPresent(renderer);
+    presentFramebuffer(presenter, fb);
     
     printf("\n");
     printf("Window opened with your line!\n");
@@ -158,26 +78,28 @@ int main(int argc, char* argv[]) {
     int quit = 0;
     SDL_Event e;
     
-    while (!quit) {
-        while (SDL_PollEvent(&e) != 0) {
-            if (e.type == SDL_QUIT) {
-                quit = 1;
+    // Sleep until something happens instead of polling
+    while (!quit && SDL_WaitEvent(&e)) {
+        if (e.type == SDL_QUIT) {
+            quit = 1;
+        }
+        else if (e.type == SDL_WINDOWEVENT) {
+            // The frame is still in the texture; show it again
+            if (e.window.event == SDL_WINDOWEVENT_EXPOSED) {
+                redrawPresenter(presenter);
             }
-            else if (e.type == SDL_KEYDOWN) {
-                if (e.key.keysym.sym == SDLK_ESCAPE) {
-                    quit = 1;
-                }
+        }
+        else if (e.type == SDL_KEYDOWN) {
+            if (e.key.keysym.sym == SDLK_ESCAPE) {
+                quit = 1;
             }
         }
-        SDL_Delay(10);
     }
     
     // Cleanup
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    destroyPresenter(presenter);
+    destroyFramebuffer(fb);
     
     printf("\nProgram ended. Goodbye!\n\n");
     return 0;
 }
-
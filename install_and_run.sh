@@ -10,7 +10,7 @@ if ! dpkg -l | grep -q libsdl2-dev; then
     echo "📦 SDL2 not found. Installing..."
     echo ""
     sudo apt update
-    sudo apt install -y libsdl2-dev
+    sudo apt install -y libsdl2-dev cmake
     
     if [ $? -eq 0 ]; then
         echo ""
@@ -30,27 +30,16 @@ echo "────────────────────────
 echo "Compiling programs..."
 echo ""
 
-cd "/mnt/data/UR/graphic design"
+cd "$(dirname "$0")"
 
-# Compile demo version
-echo "1. Compiling dda_line.c (demo version)..."
-gcc -o dda_line dda_line.c -lSDL2 -lm
+# Configure and build the library, tools and SDL demos with CMake
+echo "Building with CMake (release preset)..."
+cmake --preset release -DRASTER_SDL=ON && cmake --build --preset release
 
 if [ $? -eq 0 ]; then
-    echo "   ✓ dda_line compiled successfully!"
+    echo "   ✓ Build succeeded (programs are in build/release)"
 else
-    echo "   ✗ Compilation failed!"
-    exit 1
-fi
-
-# Compile interactive version
-echo "2. Compiling dda_interactive_graphics.c (interactive)..."
-gcc -o dda_interactive_graphics dda_interactive_graphics.c -lSDL2 -lm
-
-if [ $? -eq 0 ]; then
-    echo "   ✓ dda_interactive_graphics compiled successfully!"
-else
-    echo "   ✗ Compilation failed!"
+    echo "   ✗ Build failed!"
     exit 1
 fi
 
@@ -60,12 +49,12 @@ echo "║  ✓ Setup Complete!                                        ║"
 echo "╚═══════════════════════════════════════════════════════════╝"
 echo ""
 echo "📁 Available programs:"
-echo "   ./dda_line                    - Demo with multiple lines"
-echo "   ./dda_interactive_graphics    - Click to draw lines"
+echo "   build/release/dda_line                    - Demo with multiple lines"
+echo "   build/release/dda_interactive_graphics    - Click to draw lines"
 echo ""
 echo "🚀 Running demo program now..."
 echo ""
 
 # Run the demo
-./dda_line
+build/release/dda_line
 
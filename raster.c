@@ -0,0 +1,557 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "raster.h"
+#include "raster_internal.h"
+#include "raster_trace.h"
+
+static inline void rasterizeBresenham(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color,
+                                      TraceLevel trace);
+
+// DDA stepping shared by drawLineDDA and the batch path. Callers on the
+// hot path pass a constant TRACE_OFF so the trace calls compile away, and
+// a NULL `clip` unless pixels outside it must be left alone.
+static inline void rasterizeDDA(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color,
+                                TraceLevel trace, const ClipRect* clip) {
+    if (!lineInRange(x1, y1, x2, y2)) {
+        return;
+    }
+
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+
+    int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+
+    // Past DDA_MAX_STEPS, accumulating up to the first visible step would
+    // cost more than the line is worth
+    if (steps > DDA_MAX_STEPS) {
+        if (clip) {
+            drawLineClipped(fb, x1, y1, x2, y2, clip, color);
+        } else {
+            rasterizeBresenham(fb, x1, y1, x2, y2, color, trace);
+        }
+        return;
+    }
+
+    if (trace >= TRACE_SUMMARY) {
+        traceEmit(TRACE_BEGIN, TRACE_LINE_DDA, x1, y1, x2, y2, 0, 0, 0);
+    }
+
+    // A zero-length line is a single pixel (dx/steps would be 0/0)
+    if (steps == 0) {
+        if (!clip || insideClipRect(clip, x1, y1)) {
+            setPixel(fb, x1, y1, color);
+        }
+        if (trace >= TRACE_STEPS) {
+            traceEmit(TRACE_STEP, TRACE_LINE_DDA, 0, x1, y1, 0, 0, 0, 0);
+        }
+        if (trace >= TRACE_SUMMARY) {
+            traceEmit(TRACE_END, TRACE_LINE_DDA, 1, 1, x1, y1, 0, 0, 0);
+        }
+        return;
+    }
+
+    float xIncrement = (float)dx / (float)steps;
+    float yIncrement = (float)dy / (float)steps;
+
+    float x = x1;
+    float y = y1;
+    int first = 0;
+    int last = steps;
+
+    // Skip the steps that cannot reach the framebuffer. The float sums
+    // still have to be accumulated up to the first visible step to come
+    // out the same, but they are not rounded or plotted.
+    if (trace < TRACE_STEPS && !(insideFramebuffer(fb, x1, y1) && insideFramebuffer(fb, x2, y2))) {
+        if (!clipLineDDASteps(fb, x1, y1, x2, y2, steps, &first, &last)) {
+            last = -1;
+        }
+        for (int i = 0; i < first; i++) {
+            x += xIncrement;
+            y += yIncrement;
+        }
+    }
+
+    for (int i = first; i <= last; i++) {
+        if (!clip || insideClipRect(clip, (int)round(x), (int)round(y))) {
+            setPixel(fb, (int)round(x), (int)round(y), color);
+        }
+        if (trace >= TRACE_STEPS) {
+            traceEmit(TRACE_STEP, TRACE_LINE_DDA, i, (int)round(x), (int)round(y), 0, 0, 0, 0);
+        }
+        x += xIncrement;
+        y += yIncrement;
+    }
+
+    if (trace >= TRACE_SUMMARY) {
+        traceEmit(TRACE_END, TRACE_LINE_DDA, steps + 1, steps + 1, x2, y2, 0, 0, 0);
+    }
+}
+
+// Bresenham stepping shared by drawLineBresenham and the batch path
+static inline void rasterizeBresenham(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color,
+                                      TraceLevel trace) {
+    if (!lineInRange(x1, y1, x2, y2)) {
+        return;
+    }
+
+    int dx = abs(x2 - x1);
+    int dy = abs(y2 - y1);
+
+    int sx = (x1 < x2) ? 1 : -1;  // Step direction for x
+    int sy = (y1 < y2) ? 1 : -1;  // Step direction for y
+
+    int err = dx - dy;  // Initial error term
+    int e2;
+
+    // Both endpoints inside means every pixel in between is too, so the
+    // loop can walk a pixel pointer instead of bounds-checking each step
+    if (trace == TRACE_OFF && fb->format == PIXEL_RGB24 &&
+        insideFramebuffer(fb, x1, y1) && insideFramebuffer(fb, x2, y2)) {
+        Pixel* p = pixelAt(fb, x1, y1);
+        int stepY = sy * fb->stride;
+
+        for (int i = (dx > dy ? dx : dy); ; i--) {
+            writePixel(p, color);
+            if (i == 0) {
+                break;
+            }
+
+            e2 = 2 * err;
+            if (e2 > -dy) {
+                err -= dy;
+                p += sx;
+            }
+            if (e2 < dx) {
+                err += dx;
+                p += stepY;
+            }
+        }
+        return;
+    }
+
+    if (trace >= TRACE_SUMMARY) {
+        traceEmit(TRACE_BEGIN, TRACE_LINE_BRESENHAM, x1, y1, x2, y2, 0, 0, 0);
+    }
+
+    // Unless every step is traced, clip first so off-screen steps are never
+    // visited. The summary does not depend on it: the error term ends where
+    // it started, since it loses dy on each of the dx x-steps and gains dx
+    // on each of the dy y-steps.
+    if (trace < TRACE_STEPS) {
+        rasterizeLineClipped(fb, x1, y1, x2, y2, color);
+        if (trace >= TRACE_SUMMARY) {
+            int pixels = (dx > dy ? dx : dy) + 1;
+            traceEmit(TRACE_END, TRACE_LINE_BRESENHAM, pixels, pixels, x2, y2, dx - dy, 0, 0);
+        }
+        return;
+    }
+
+    int x = x1;
+    int y = y1;
+    int step = 0;
+
+    while (1) {
+        setPixel(fb, x, y, color);
+        if (trace >= TRACE_STEPS) {
+            traceEmit(TRACE_STEP, TRACE_LINE_BRESENHAM, step, x, y, err, 0, 0, 0);
+        }
+        step++;
+
+        if (x == x2 && y == y2) {
+            break;
+        }
+
+        e2 = 2 * err;
+
+        // Move in x direction
+        if (e2 > -dy) {
+            err -= dy;
+            x += sx;
+        }
+
+        // Move in y direction
+        if (e2 < dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+
+    if (trace >= TRACE_SUMMARY) {
+        traceEmit(TRACE_END, TRACE_LINE_BRESENHAM, step, step, x, y, err, 0, 0);
+    }
+}
+
+// Fixed-point DDA stepping. The minor axis offset is accumulated as an
+// unsigned 32.32 magnitude starting just under 0.5, so taking the integer
+// part rounds to nearest with ties toward the start point -- exactly the
+// choice drawLineBresenham makes.
+static inline void rasterizeDDAFixed(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color,
+                                     TraceLevel trace) {
+    if (!lineInRange(x1, y1, x2, y2)) {
+        return;
+    }
+
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+    int xMajor = abs(dx) >= abs(dy);
+    int steps = xMajor ? abs(dx) : abs(dy);
+    int minorDelta = xMajor ? abs(dy) : abs(dx);
+
+    if (steps > FIXED_DDA_MAX_STEPS) {
+        rasterizeBresenham(fb, x1, y1, x2, y2, color, trace);
+        return;
+    }
+
+    int sx = (dx < 0) ? -1 : 1;
+    int sy = (dy < 0) ? -1 : 1;
+
+    uint64_t increment = steps ? ((uint64_t)minorDelta << 32) / steps : 0;
+    uint64_t acc = FIXED_DDA_BIAS;
+
+    if (trace == TRACE_OFF && fb->format == PIXEL_RGB24 &&
+        insideFramebuffer(fb, x1, y1) && insideFramebuffer(fb, x2, y2)) {
+        Pixel* p = pixelAt(fb, x1, y1);
+        long majorStep = xMajor ? sx : (long)sy * fb->stride;
+        long minorStep = xMajor ? (long)sy * fb->stride : sx;
+        uint32_t minor = 0;
+
+        for (int i = steps; ; i--) {
+            writePixel(p, color);
+            if (i == 0) {
+                break;
+            }
+
+            acc += increment;
+            uint32_t next = (uint32_t)(acc >> 32);
+            p += majorStep + (long)(next - minor) * minorStep;
+            minor = next;
+        }
+        return;
+    }
+
+    if (trace >= TRACE_SUMMARY) {
+        traceEmit(TRACE_BEGIN, TRACE_LINE_DDA_FIXED, x1, y1, x2, y2, 0, 0, 0);
+    }
+
+    // Same pixels as Bresenham, so the clipped Bresenham stepping can draw
+    // lines that leave the framebuffer
+    if (trace < TRACE_STEPS) {
+        rasterizeLineClipped(fb, x1, y1, x2, y2, color);
+        if (trace >= TRACE_SUMMARY) {
+            traceEmit(TRACE_END, TRACE_LINE_DDA_FIXED, steps + 1, steps + 1, x2, y2,
+                      (int)(((acc + (uint64_t)steps * increment) >> 16) & 0xFFFF), 0, 0);
+        }
+        return;
+    }
+
+    int x = x1;
+    int y = y1;
+
+    for (int i = 0; i <= steps; i++) {
+        int offset = (int)(acc >> 32);
+        x = xMajor ? x1 + sx * i : x1 + sx * offset;
+        y = xMajor ? y1 + sy * offset : y1 + sy * i;
+
+        setPixel(fb, x, y, color);
+        if (trace >= TRACE_STEPS) {
+            traceEmit(TRACE_STEP, TRACE_LINE_DDA_FIXED, i, x, y, (int)((acc >> 16) & 0xFFFF), 0, 0, 0);
+        }
+        acc += increment;
+    }
+
+    if (trace >= TRACE_SUMMARY) {
+        traceEmit(TRACE_END, TRACE_LINE_DDA_FIXED, steps + 1, steps + 1, x, y,
+                  (int)(((acc - increment) >> 16) & 0xFFFF), 0, 0);
+    }
+}
+
+// DDA Line Drawing Algorithm
+void drawLineDDA(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    if (rasterTraceLevel == TRACE_OFF) {
+        rasterizeDDA(fb, x1, y1, x2, y2, color, TRACE_OFF, NULL);
+    } else {
+        rasterizeDDA(fb, x1, y1, x2, y2, color, rasterTraceLevel, NULL);
+    }
+}
+
+// Fixed-point DDA Line Drawing Algorithm
+void drawLineDDAFixed(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    if (rasterTraceLevel == TRACE_OFF) {
+        rasterizeDDAFixed(fb, x1, y1, x2, y2, color, TRACE_OFF);
+    } else {
+        rasterizeDDAFixed(fb, x1, y1, x2, y2, color, rasterTraceLevel);
+    }
+}
+
+void rasterizeLineDDAScalar(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    rasterizeDDA(fb, x1, y1, x2, y2, color, TRACE_OFF, NULL);
+}
+
+void rasterizeLineDDAClipped(Framebuffer* fb, int x1, int y1, int x2, int y2, const ClipRect* clip,
+                             Color color) {
+    rasterizeDDA(fb, x1, y1, x2, y2, color, TRACE_OFF, clip);
+}
+
+void rasterizeLineFixedScalar(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    rasterizeDDAFixed(fb, x1, y1, x2, y2, color, TRACE_OFF);
+}
+
+void rasterizeLineBresenhamScalar(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    rasterizeBresenham(fb, x1, y1, x2, y2, color, TRACE_OFF);
+}
+
+// Bresenham's Line Drawing Algorithm
+void drawLineBresenham(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    if (rasterTraceLevel == TRACE_OFF) {
+        rasterizeBresenham(fb, x1, y1, x2, y2, color, TRACE_OFF);
+    } else {
+        rasterizeBresenham(fb, x1, y1, x2, y2, color, rasterTraceLevel);
+    }
+}
+
+void initLineSteps(LineSteps* line, int x1, int y1, int x2, int y2) {
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+
+    line->x1 = x1;
+    line->y1 = y1;
+    line->xMajor = abs(dx) >= abs(dy);
+    line->major = line->xMajor ? abs(dx) : abs(dy);
+    line->minor = line->xMajor ? abs(dy) : abs(dx);
+    line->majorSign = (line->xMajor ? dx : dy) < 0 ? -1 : 1;
+    line->minorSign = (line->xMajor ? dy : dx) < 0 ? -1 : 1;
+}
+
+// Minor offset of step i, and what is left over toward the next one
+static inline int64_t minorOffsetAt(const LineSteps* line, int i, int64_t* remainder) {
+    if (line->major == 0) {
+        *remainder = 0;
+        return 0;
+    }
+
+    int64_t numerator = 2 * (int64_t)i * line->minor + line->major - 1;
+    int64_t denominator = 2 * (int64_t)line->major;
+    *remainder = numerator % denominator;
+    return numerator / denominator;
+}
+
+void lineStepPoint(const LineSteps* line, int i, int* x, int* y) {
+    int64_t remainder;
+    int majorCoord = (line->xMajor ? line->x1 : line->y1) + line->majorSign * i;
+    int minorCoord = (line->xMajor ? line->y1 : line->x1) +
+                     line->minorSign * (int)minorOffsetAt(line, i, &remainder);
+
+    *x = line->xMajor ? majorCoord : minorCoord;
+    *y = line->xMajor ? minorCoord : majorCoord;
+}
+
+int clipLineSteps(const LineSteps* line, int left, int top, int right, int bottom,
+                  int* first, int* last) {
+    int64_t majorStart = line->xMajor ? line->x1 : line->y1;
+    int64_t minorStart = line->xMajor ? line->y1 : line->x1;
+    int64_t majorLo = line->xMajor ? left : top;
+    int64_t majorHi = line->xMajor ? right : bottom;
+    int64_t minorLo = line->xMajor ? top : left;
+    int64_t minorHi = line->xMajor ? bottom : right;
+
+    // The major coordinate is linear in the step
+    int64_t from = line->majorSign > 0 ? majorLo - majorStart : majorStart - majorHi;
+    int64_t to = line->majorSign > 0 ? majorHi - majorStart : majorStart - majorLo;
+
+    // The minor offset is monotone in the step, so the offsets [a, b] that
+    // land inside map back to one contiguous range of steps as well
+    int64_t a = line->minorSign > 0 ? minorLo - minorStart : minorStart - minorHi;
+    int64_t b = line->minorSign > 0 ? minorHi - minorStart : minorStart - minorLo;
+
+    if (from < 0) {
+        from = 0;
+    }
+    if (to > line->major) {
+        to = line->major;
+    }
+    if (a < 0) {
+        a = 0;
+    }
+    if (b > line->minor) {
+        b = line->minor;
+    }
+    if (a > b) {
+        return 0;
+    }
+
+    if (line->minor > 0) {
+        // Offset j covers steps (2j - 1) * major / (2 * minor) + 1 through
+        // (2j + 1) * major / (2 * minor), the last offset running to the end
+        int64_t denominator = 2 * (int64_t)line->minor;
+        int64_t firstOfA = a == 0 ? 0 : (2 * a - 1) * line->major / denominator + 1;
+        int64_t lastOfB = b == line->minor ? line->major : (2 * b + 1) * line->major / denominator;
+
+        if (from < firstOfA) {
+            from = firstOfA;
+        }
+        if (to > lastOfB) {
+            to = lastOfB;
+        }
+    }
+
+    if (from > to) {
+        return 0;
+    }
+    *first = (int)from;
+    *last = (int)to;
+    return 1;
+}
+
+void seekLineSteps(const Framebuffer* fb, const LineSteps* line, int first, LineCursor* cursor) {
+    long stepX = line->xMajor ? line->majorSign : line->minorSign;
+    long stepY = (long)(line->xMajor ? line->minorSign : line->majorSign) * fb->stride;
+    int offset = (int)minorOffsetAt(line, first, &cursor->remainder);
+    int majorCoord = (line->xMajor ? line->x1 : line->y1) + line->majorSign * first;
+    int minorCoord = (line->xMajor ? line->y1 : line->x1) + line->minorSign * offset;
+
+    cursor->pixel = line->xMajor ? (long)minorCoord * fb->stride + majorCoord
+                                 : (long)majorCoord * fb->stride + minorCoord;
+    cursor->twoMajor = 2 * (int64_t)line->major;
+    cursor->twoMinor = 2 * (int64_t)line->minor;
+    cursor->majorStep = line->xMajor ? stepX : stepY;
+    cursor->minorStep = line->xMajor ? stepY : stepX;
+}
+
+void rasterizeLineSteps(Framebuffer* fb, const LineSteps* line, int first, int last, Color color) {
+    LineCursor cursor;
+
+    seekLineSteps(fb, line, first, &cursor);
+    if (fb->format == PIXEL_RGB24) {
+        stepLineCursor(fb, &cursor, last - first + 1, color);
+    } else {
+        stepLineCursorFormat(fb, &cursor, last - first + 1, color);
+    }
+}
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+double batchClock(void) {
+    return nowSeconds();
+}
+
+static void fillBatchStats(BatchStats* stats, size_t count, size_t pixels, double seconds) {
+    stats->seconds = seconds;
+    stats->segments = count;
+    stats->pixels = pixels;
+    stats->segmentsPerSecond = seconds > 0.0 ? count / seconds : 0.0;
+}
+
+void finishBatchPixels(BatchStats* stats, size_t count, size_t pixels, double start) {
+    fillBatchStats(stats, count, pixels, nowSeconds() - start);
+}
+
+size_t lineStepCount(int x1, int y1, int x2, int y2) {
+    if (!lineInRange(x1, y1, x2, y2)) {
+        return 0;
+    }
+    int64_t dx = llabs((int64_t)x2 - x1);
+    int64_t dy = llabs((int64_t)y2 - y1);
+    return (size_t)(dx > dy ? dx : dy) + 1;
+}
+
+void finishBatchStats(BatchStats* stats, const Segment* segments, size_t count, double start) {
+    // Stop the clock before counting, which is not part of the batch
+    double seconds = nowSeconds() - start;
+    size_t pixels = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        pixels += lineStepCount(segments[i].x1, segments[i].y1, segments[i].x2, segments[i].y2);
+    }
+    fillBatchStats(stats, count, pixels, seconds);
+}
+
+// Field of segment i in a column whose elements are `stride` bytes apart
+static inline int32_t fieldAt(const void* column, size_t stride, size_t i) {
+    return *(const int32_t*)((const unsigned char*)column + i * stride);
+}
+
+// Segment i has its endpoints at x1 + i * stride bytes and so on: a stride
+// of 4 walks columns, sizeof(Segment) walks a Segment array. Both callers
+// pass a constant stride, so each gets its own copy of the loops below
+// with the stepping kernels inlined.
+static inline void drawLines(Framebuffer* fb, const void* x1, const void* y1, const void* x2,
+                             const void* y2, const void* color, size_t stride, size_t count,
+                             LineAlgorithm algorithm) {
+#define SEGMENT_AT(i) fieldAt(x1, stride, i), fieldAt(y1, stride, i), \
+                      fieldAt(x2, stride, i), fieldAt(y2, stride, i)
+#define COLOR_AT(i) ((Color)fieldAt(color, stride, i))
+    // One switch per batch
+    switch (algorithm) {
+    case LINE_DDA:
+        for (size_t i = 0; i < count; i++) {
+            rasterizeDDA(fb, SEGMENT_AT(i), COLOR_AT(i), TRACE_OFF, NULL);
+        }
+        break;
+    case LINE_DDA_FIXED:
+        for (size_t i = 0; i < count; i++) {
+            rasterizeDDAFixed(fb, SEGMENT_AT(i), COLOR_AT(i), TRACE_OFF);
+        }
+        break;
+    case LINE_DDA_SIMD:
+        for (size_t i = 0; i < count; i++) {
+            rasterizeLineFixedSimd(fb, SEGMENT_AT(i), COLOR_AT(i));
+        }
+        break;
+    case LINE_RUN_SLICE:
+        for (size_t i = 0; i < count; i++) {
+            rasterizeLineRunSlice(fb, SEGMENT_AT(i), COLOR_AT(i));
+        }
+        break;
+    case LINE_WU:
+        for (size_t i = 0; i < count; i++) {
+            rasterizeLineWu(fb, SEGMENT_AT(i), 0, COLOR_AT(i));
+        }
+        break;
+    case LINE_BRESENHAM:
+    default:
+        for (size_t i = 0; i < count; i++) {
+            rasterizeBresenham(fb, SEGMENT_AT(i), COLOR_AT(i), TRACE_OFF);
+        }
+        break;
+    }
+#undef SEGMENT_AT
+#undef COLOR_AT
+}
+
+void drawLineBatch(Framebuffer* fb, const Segment* segments, size_t count,
+                   LineAlgorithm algorithm, BatchStats* stats) {
+    double start = stats ? nowSeconds() : 0.0;
+
+    if (count > 0) {
+        drawLines(fb, &segments->x1, &segments->y1, &segments->x2, &segments->y2,
+                  &segments->color, sizeof(Segment), count, algorithm);
+    }
+
+    if (stats) {
+        finishBatchStats(stats, segments, count, start);
+    }
+}
+
+void drawLineColumns(Framebuffer* fb, const SegmentColumns* columns, LineAlgorithm algorithm,
+                     BatchStats* stats) {
+    double start = stats ? nowSeconds() : 0.0;
+
+    drawLines(fb, columns->x1, columns->y1, columns->x2, columns->y2, columns->color,
+              sizeof(int32_t), columns->count, algorithm);
+
+    if (stats) {
+        double seconds = nowSeconds() - start;
+        size_t pixels = 0;
+        for (size_t i = 0; i < columns->count; i++) {
+            pixels += lineStepCount(columns->x1[i], columns->y1[i], columns->x2[i], columns->y2[i]);
+        }
+        fillBatchStats(stats, columns->count, pixels, seconds);
+    }
+}
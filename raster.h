@@ -0,0 +1,401 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Headless rasterization core shared by the demo programs.
+//
+// Every algorithm writes straight into a caller-owned framebuffer; nothing
+// here depends on SDL or prints to the terminal, so the same code runs in
+// the interactive demos and on machines without a display. Coordinates may
+// lie outside the framebuffer: lines are clipped to it before they are
+// rasterized. Line endpoints are limited to LINE_MAX_COORD, so the kernels'
+// integer deltas and error terms cannot overflow.
+
+// One RGB24 pixel, laid out exactly as a P6 PPM stores it
+typedef struct {
+    unsigned char r, g, b;
+} Pixel;
+
+// Packed 0xRRGGBB drawing color
+typedef uint32_t Color;
+
+#define COLOR_RGB(r, g, b) \
+    ((Color)((((uint32_t)(r) & 0xFF) << 16) | (((uint32_t)(g) & 0xFF) << 8) | ((uint32_t)(b) & 0xFF)))
+
+#define COLOR_R(c) ((unsigned char)(((c) >> 16) & 0xFF))
+#define COLOR_G(c) ((unsigned char)(((c) >> 8) & 0xFF))
+#define COLOR_B(c) ((unsigned char)((c) & 0xFF))
+
+#define COLOR_WHITE   COLOR_RGB(255, 255, 255)
+#define COLOR_BLACK   COLOR_RGB(0, 0, 0)
+#define COLOR_RED     COLOR_RGB(255, 0, 0)
+#define COLOR_GREEN   COLOR_RGB(0, 255, 0)
+#define COLOR_BLUE    COLOR_RGB(0, 0, 255)
+#define COLOR_MAGENTA COLOR_RGB(255, 0, 255)
+#define COLOR_CYAN    COLOR_RGB(0, 255, 255)
+#define COLOR_YELLOW  COLOR_RGB(255, 255, 0)
+
+// How a framebuffer stores its pixels. Every drawing function works on
+// every format; RGB24 is the fast path the line kernels are tuned for.
+typedef enum {
+    PIXEL_RGB24,        // Pixel: r, g, b bytes
+    PIXEL_RGBA32,       // r, g, b, a bytes; drawing writes opaque pixels
+    PIXEL_INDEXED8,     // one byte per pixel; the color value is the palette index
+    PIXEL_MASK1         // one bit per pixel, most significant bit first; the bit
+                        // is set for any color but COLOR_BLACK
+} PixelFormat;
+
+// A view onto pixel storage (row-major, top row first)
+typedef struct {
+    Pixel* pixels;      // first row; typed for RGB24, raw bytes in other formats
+    int width;
+    int height;
+    int stride;         // distance between rows, in pixels
+    PixelFormat format;
+} Framebuffer;
+
+// Wrap caller-owned RGB24 storage of width * height pixels
+void initFramebuffer(Framebuffer* fb, Pixel* pixels, int width, int height);
+
+// Wrap caller-owned storage of any format whose rows are `stride` pixels
+// apart. For PIXEL_MASK1 the stride must be a multiple of 8.
+void initFramebufferFormat(Framebuffer* fb, void* pixels, int width, int height, int stride,
+                           PixelFormat format);
+
+// Allocate a framebuffer of any size at run time. Every row starts on a
+// 64-byte (cache line) boundary, which pads the stride. The pixels are
+// not cleared. Returns NULL if the size is invalid or allocation fails.
+Framebuffer* createFramebuffer(int width, int height, PixelFormat format);
+
+// Free a framebuffer from createFramebuffer (not one from initFramebuffer)
+void destroyFramebuffer(Framebuffer* fb);
+
+// Bytes from the start of one row to the next
+size_t framebufferRowBytes(const Framebuffer* fb);
+
+// Fill the whole framebuffer with one color
+void clearFramebuffer(Framebuffer* fb, Color color);
+
+// Plot a single pixel; coordinates outside the framebuffer are ignored
+void setPixel(Framebuffer* fb, int x, int y, Color color);
+
+// Largest |x| or |y| of a line endpoint. Every line function draws nothing
+// for a line with an endpoint beyond it.
+#define LINE_MAX_COORD (1 << 28)
+
+// Most steps drawLineDDA takes in floating point
+#define DDA_MAX_STEPS (1 << 16)
+
+// DDA line: floating-point increments, rounded to the nearest pixel. The
+// float sums are accumulated over the off-screen steps too, so lines of
+// more than DDA_MAX_STEPS steps get the drawLineBresenham pixels instead.
+void drawLineDDA(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// DDA line in 32.32 fixed point: no floats or libm in the loop, and the
+// same pixels as drawLineBresenham (ties round toward the start point)
+void drawLineDDAFixed(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Bresenham line drawn as runs: each horizontal run of pixels is sized
+// directly and filled as one span. Untraced steep lines, and lines whose
+// runs average under 4 pixels, fall back to the per-pixel kernel, which
+// is faster for them; traced ones are walked as runs, vertical for steep
+// lines. Same pixels as drawLineBresenham.
+void drawLineRunSlice(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Fixed-point DDA with the per-step coordinates computed 4 (SSE2) or 8
+// (AVX2) at a time; same pixels as drawLineDDAFixed
+void drawLineDDASimd(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Instruction sets drawLineDDASimd can use, in increasing order
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2
+} SimdLevel;
+
+// Best level this CPU supports (checked at run time)
+SimdLevel detectSimdLevel(void);
+
+// Level currently used; defaults to detectSimdLevel()
+SimdLevel activeSimdLevel(void);
+
+// Force a lower level, e.g. to compare kernels; clamped to what the CPU has
+void setSimdLevel(SimdLevel level);
+
+const char* simdLevelName(SimdLevel level);
+
+// Bresenham line: integer-only error term
+void drawLineBresenham(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Anti-aliased line (Xiaolin Wu): each step is shared between the two
+// pixels nearest the exact line, with 8-bit coverage blended over what is
+// already there. The endpoints are fully covered. RGBA32 framebuffers are
+// treated as premultiplied, so coverage also accumulates in alpha;
+// INDEXED8 and MASK1 have nothing to blend and get the Bresenham line.
+// Never traces.
+void drawLineWu(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Inclusive pixel rectangle
+typedef struct {
+    int left, top;
+    int right, bottom;
+} ClipRect;
+
+// Trim a line to `clip`: on return the endpoints are the first and last
+// pixels of its Bresenham rasterization that fall inside. Returns 0 if none
+// do, or if an endpoint is beyond LINE_MAX_COORD. Redrawing between the trimmed endpoints can change the slope
+// slightly; use drawLineClipped to draw the visible part exactly.
+int clipLine(const ClipRect* clip, int* x1, int* y1, int* x2, int* y2);
+
+// Bresenham line drawn only inside `clip` (further limited to the
+// framebuffer). The line is entered at its first visible pixel with the
+// exact error term, so skipped pixels cost nothing and the visible ones
+// are exactly those drawLineBresenham plots. Never traces.
+void drawLineClipped(Framebuffer* fb, int x1, int y1, int x2, int y2, const ClipRect* clip,
+                     Color color);
+
+// Integer point, e.g. a polyline vertex
+typedef struct {
+    int x, y;
+} Point;
+
+// One line segment of a batch
+typedef struct {
+    int x1, y1;
+    int x2, y2;
+    Color color;
+} Segment;
+
+// Line rasterizer used by the batch entry point
+typedef enum {
+    LINE_BRESENHAM,
+    LINE_DDA,
+    LINE_DDA_FIXED,
+    LINE_DDA_SIMD,
+    LINE_RUN_SLICE,
+    LINE_WU             // anti-aliased; blends instead of overwriting
+} LineAlgorithm;
+
+// Timing of one drawLineBatch (or circle or marker batch) call
+typedef struct {
+    size_t segments;            // segments, circles or markers
+    size_t pixels;              // lines: pixels stepped, including off-screen
+                                // ones; circles and markers: pixels written
+    double seconds;             // drawing only, not the pixel count
+    double segmentsPerSecond;
+} BatchStats;
+
+// Rasterize `count` segments into one framebuffer. Prints nothing; pass a
+// BatchStats to get the throughput, or NULL to skip the clock reads.
+void drawLineBatch(Framebuffer* fb, const Segment* segments, size_t count,
+                   LineAlgorithm algorithm, BatchStats* stats);
+
+// Segments stored as structure of arrays: element i of each column is
+// segment i. This is the layout of a mapped segment file
+// (raster_segfile.h), so a batch can be drawn straight from it.
+typedef struct {
+    const int32_t* x1;
+    const int32_t* y1;
+    const int32_t* x2;
+    const int32_t* y2;
+    const Color* color;
+    size_t count;
+} SegmentColumns;
+
+// drawLineBatch for segments in columns: the same pixels, in the same
+// order, as drawLineBatch on the equivalent Segment array
+void drawLineColumns(Framebuffer* fb, const SegmentColumns* columns, LineAlgorithm algorithm,
+                     BatchStats* stats);
+
+// Connected line strip through `count` points, e.g. a time series. Each
+// segment after the first leaves out its start vertex, which the previous
+// segment ended on, so each shared vertex is plotted once: the same pixels
+// as drawing the segments separately, without blending the shared
+// vertices twice. Pixels where segments cross or retrace, and the first
+// point of a closed strip, are still plotted by every segment that
+// reaches them. The exact variants (LINE_BRESENHAM, LINE_DDA_FIXED,
+// LINE_DDA_SIMD, LINE_RUN_SLICE) all plot the Bresenham pixels and share
+// one kernel. LINE_WU leaves out the shared vertices the same way, with
+// the anti-aliased kernel. LINE_DDA rounds its own last step, so it draws
+// each segment whole. A single point is one pixel. BatchStats counts
+// segments and the pixels stepped. Never traces.
+void drawPolyline(Framebuffer* fb, const Point* points, size_t count, Color color,
+                  LineAlgorithm algorithm, BatchStats* stats);
+
+// Plot the 8 symmetrical points of a circle for one octant step
+void plotCirclePoints(Framebuffer* fb, int xc, int yc, int x, int y, Color color);
+
+// Largest radius the circle functions draw; larger ones draw nothing
+#define CIRCLE_MAX_RADIUS 32767
+
+// Bresenham (midpoint) circle outline using 8-way symmetry. The octant
+// walk is turned into horizontal spans, so each pixel is written once
+// (including where the octants meet) and circles may be partly or wholly
+// outside the framebuffer. Radius 0 is a single pixel; negative radii,
+// and radii above CIRCLE_MAX_RADIUS, draw nothing.
+void drawCircleBresenham(Framebuffer* fb, int xc, int yc, int radius, Color color);
+
+// Solid disc: every pixel on or inside the drawCircleBresenham outline,
+// one span per row. Never traces.
+void fillCircle(Framebuffer* fb, int xc, int yc, int radius, Color color);
+
+// Thick ring: the disc of `radius` minus the disc of `radius - thickness`,
+// so a thickness of at least radius + 1 gives a solid disc. Never traces.
+void drawRing(Framebuffer* fb, int xc, int yc, int radius, int thickness, Color color);
+
+// How drawCircleBatch draws each circle
+typedef enum {
+    CIRCLE_OUTLINE,     // as drawCircleBresenham
+    CIRCLE_FILLED,      // as fillCircle
+    CIRCLE_RING         // as drawRing
+} CircleMode;
+
+// One circle of a batch
+typedef struct {
+    int xc, yc;
+    int radius;
+    Color color;
+} Circle;
+
+// Draw `count` circles, e.g. scatter-plot markers. `thickness` only
+// applies to CIRCLE_RING. The octant walk is reused while consecutive
+// circles share a radius. Never traces.
+void drawCircleBatch(Framebuffer* fb, const Circle* circles, size_t count, CircleMode mode,
+                     int thickness, BatchStats* stats);
+
+// Largest semi-axis the ellipse functions draw; larger ones draw nothing
+#define ELLIPSE_MAX_RADIUS 32767
+
+// Midpoint ellipse outline with semi-axes rx (horizontal) and ry
+// (vertical), using 4-way symmetry and integer two-region decision
+// parameters. Drawn as spans, each pixel once, and clipped like the
+// circles. A zero semi-axis gives a line. Never traces.
+void drawEllipse(Framebuffer* fb, int xc, int yc, int rx, int ry, Color color);
+
+// Solid ellipse: every pixel on or inside the drawEllipse outline
+void fillEllipse(Framebuffer* fb, int xc, int yc, int rx, int ry, Color color);
+
+// The part of the drawEllipse outline whose pixels lie in the angular
+// sector from `startDegrees` sweeping `sweepDegrees` counterclockwise as
+// seen on screen (0 points right, 90 up). The sector includes its start
+// and excludes its end, so two arcs that share an angle never share a
+// pixel. A sweep of 360 or more is the whole outline; 0 or less draws
+// nothing.
+void drawEllipseArc(Framebuffer* fb, int xc, int yc, int rx, int ry, double startDegrees,
+                    double sweepDegrees, Color color);
+
+// Pie slice: the pixels of fillEllipse in the same sector, plus the center
+void fillEllipsePie(Framebuffer* fb, int xc, int yc, int rx, int ry, double startDegrees,
+                    double sweepDegrees, Color color);
+
+// How the ellipse batches draw each shape
+typedef enum {
+    ELLIPSE_OUTLINE,    // drawEllipse, or drawEllipseArc for arcs
+    ELLIPSE_FILLED      // fillEllipse, or fillEllipsePie for arcs
+} EllipseMode;
+
+// One ellipse of a batch
+typedef struct {
+    int xc, yc;
+    int rx, ry;
+    Color color;
+} Ellipse;
+
+// One arc or pie slice of a batch
+typedef struct {
+    int xc, yc;
+    int rx, ry;
+    double start, sweep;    // degrees
+    Color color;
+} EllipseArc;
+
+// Draw `count` ellipses. The quadrant walk is reused while consecutive
+// ellipses share their semi-axes. BatchStats counts ellipses as segments
+// and the pixels written.
+void drawEllipseBatch(Framebuffer* fb, const Ellipse* ellipses, size_t count, EllipseMode mode,
+                      BatchStats* stats);
+
+// Draw `count` arcs (ELLIPSE_OUTLINE) or pie slices (ELLIPSE_FILLED), e.g.
+// a pie chart or gauge ticks, with the same walk reuse
+void drawArcBatch(Framebuffer* fb, const EllipseArc* arcs, size_t count, EllipseMode mode,
+                  BatchStats* stats);
+
+// Largest marker radius; larger markers draw nothing
+#define MARKER_MAX_RADIUS 32767
+
+// Solid dot marker: every pixel with dx*dx + dy*dy <= radius * radius.
+// Row masks are cached per radius, so repeated markers only copy rows.
+void drawMarker(Framebuffer* fb, int x, int y, int radius, Color color);
+
+// One marker of a batch
+typedef struct {
+    int x, y;
+    Color color;
+} Marker;
+
+// Stamp `count` markers of one radius, e.g. the data points of a plot.
+// BatchStats counts markers as segments and the pixels written.
+void drawMarkerBatch(Framebuffer* fb, const Marker* markers, size_t count, int radius,
+                     BatchStats* stats);
+
+// How the ends of a thick line look
+typedef enum {
+    CAP_BUTT,           // flat, exactly at the endpoint
+    CAP_SQUARE,         // flat, half the width past the endpoint
+    CAP_ROUND           // a half disc around the endpoint
+} LineCap;
+
+// How a thick polyline turns a corner
+typedef enum {
+    JOIN_MITER,         // sharp corner, cut to a bevel beyond miterLimit
+    JOIN_BEVEL,         // corner cut straight across
+    JOIN_ROUND          // disc around the vertex
+} LineJoin;
+
+typedef struct {
+    int width;          // pixels; 1 or less draws the Bresenham line
+    LineCap cap;
+    LineJoin join;
+    double miterLimit;  // longest miter, in widths; below 1 means 4 (as in SVG)
+} StrokeStyle;
+
+// Thick line: every pixel whose center lies within width / 2 of the
+// segment, extended by the caps. Each row of the line is filled as one
+// span, so no pixel is written twice. Never traces.
+void drawThickLine(Framebuffer* fb, int x1, int y1, int x2, int y2, const StrokeStyle* style,
+                   Color color);
+
+// Thick polyline through `count` points, with the style's joins at the
+// inner vertices and caps at the two ends. The covered spans of all
+// segments, joins and caps are merged per row before filling, so every
+// pixel is written once. A single point draws just its caps.
+void drawThickPolyline(Framebuffer* fb, const Point* points, size_t count, const StrokeStyle* style,
+                       Color color);
+
+// Largest |x| or |y| of a polygon vertex; polygons beyond it draw nothing
+#define POLYGON_MAX_COORD (1 << 28)
+
+// Which pixels a self-intersecting or multi-contour polygon covers
+typedef enum {
+    FILL_EVEN_ODD,      // inside an odd number of times
+    FILL_NONZERO        // the edges around the pixel do not cancel out
+} FillRule;
+
+// Solid polygon through `count` points, closed from the last point back
+// to the first: every pixel whose center is inside by `rule`. Edges are
+// half-open like the stroke pieces, so polygons that share an edge share
+// no pixel and leave no gap. Concave and self-intersecting polygons are
+// fine; convex ones take a fast path. Each row is filled as spans, every
+// pixel once. Never traces.
+void fillPolygon(Framebuffer* fb, const Point* points, size_t count, FillRule rule, Color color);
+
+// Polygon of several closed contours filled as one shape, e.g. a map
+// region with islands and lakes. Contour i has counts[i] points, stored
+// after those of contour i - 1. Holes are cut by FILL_EVEN_ODD, or by
+// FILL_NONZERO when they wind against their outline.
+void fillPolygonContours(Framebuffer* fb, const Point* points, const size_t* counts,
+                         size_t contours, FillRule rule, Color color);
+
+#endif
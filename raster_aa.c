@@ -0,0 +1,346 @@
+#include <stdlib.h>
+#include <string.h>
+#include "raster.h"
+#include "raster_internal.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define RASTER_X86_SIMD 1
+#endif
+
+// Anti-aliased lines (Xiaolin Wu).
+//
+// Step i of a line sits at major offset i and exact minor offset
+// i * minor / major. Wu's algorithm shares each step between the two
+// pixels straddling that position, in proportion to how close each one
+// is. The position is tracked in 32.32 fixed point as in drawLineDDAFixed:
+// the integer part is the near pixel, and the top 8 bits of the fraction
+// are the coverage of the far one. The near pixel gets the rest, so every
+// step deposits exactly 255.
+//
+// Coverage is blended as premultiplied alpha over the framebuffer:
+// dst = color * a + dst * (255 - a), divided by 255 with exact rounding.
+// Steps are collected into blocks of pixel indices and coverages, and each
+// block is blended 4 (SSE2) or 8 (AVX2) pixels at a time in 16-bit lanes.
+// Only the loads and stores of the scattered pixels stay scalar.
+
+// Pixels collected before a blend pass
+#define WU_BLOCK 64
+
+typedef struct {
+    long index[WU_BLOCK];
+    unsigned char alpha[WU_BLOCK];
+    int count;
+} WuBlock;
+
+// src * alpha + dst * (255 - alpha), over 255 and rounded to nearest
+static inline unsigned char blendChannel(unsigned src, unsigned dst, unsigned alpha) {
+    unsigned t = src * alpha + dst * (255 - alpha) + 128;
+    return (unsigned char)((t + (t >> 8)) >> 8);
+}
+
+// A pixel's channels as one word, red in the low byte; RGB24 leaves the
+// top byte 0. Built from bytes rather than copied, so the compiler never
+// goes through a stack slot for the 3-byte case. `format` is a constant at
+// every call.
+static inline uint32_t loadPacked(const unsigned char* p, PixelFormat format) {
+    uint32_t value = p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16;
+    return format == PIXEL_RGBA32 ? value | (uint32_t)p[3] << 24 : value;
+}
+
+static inline void storePacked(unsigned char* p, uint32_t value, PixelFormat format) {
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    if (format == PIXEL_RGBA32) {
+        p[3] = (unsigned char)(value >> 24);
+    }
+}
+
+static inline void blendBlockScalar(unsigned char* base, const WuBlock* block, int first,
+                                    Color color, PixelFormat format) {
+    int size = format == PIXEL_RGBA32 ? 4 : 3;
+
+    for (int k = first; k < block->count; k++) {
+        unsigned char* p = base + block->index[k] * size;
+        unsigned alpha = block->alpha[k];
+
+        p[0] = blendChannel(COLOR_R(color), p[0], alpha);
+        p[1] = blendChannel(COLOR_G(color), p[1], alpha);
+        p[2] = blendChannel(COLOR_B(color), p[2], alpha);
+        if (format == PIXEL_RGBA32) {
+            p[3] = blendChannel(255, p[3], alpha);
+        }
+    }
+}
+
+#ifdef RASTER_X86_SIMD
+
+// The source color as loadPacked lays it out, opaque
+static uint32_t packColor(Color color) {
+    return COLOR_R(color) | (uint32_t)COLOR_G(color) << 8 | (uint32_t)COLOR_B(color) << 16 | 0xFF000000u;
+}
+
+// blendChannel on eight 16-bit lanes. The products fit 16 bits unsigned,
+// so the wrapping multiplies and adds are exact.
+__attribute__((target("sse2")))
+static inline __m128i blendLanesSSE2(__m128i src, __m128i dst, __m128i alpha) {
+    __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, inverse));
+    t = _mm_add_epi16(t, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("sse2")))
+__attribute__((always_inline))
+static inline void blendPixelsSSE2(unsigned char* base, const WuBlock* block, Color color,
+                                   PixelFormat format) {
+    int size = format == PIXEL_RGBA32 ? 4 : 3;
+    __m128i zero = _mm_setzero_si128();
+    __m128i src = _mm_unpacklo_epi8(_mm_set1_epi32((int)packColor(color)), zero);
+    uint32_t out[4];
+    int k = 0;
+
+    for (; k + 4 <= block->count; k += 4) {
+        const long* index = block->index + k;
+        __m128i d = _mm_set_epi32((int)loadPacked(base + index[3] * size, format),
+                                  (int)loadPacked(base + index[2] * size, format),
+                                  (int)loadPacked(base + index[1] * size, format),
+                                  (int)loadPacked(base + index[0] * size, format));
+
+        // Four coverage bytes, each spread over its pixel's four channels
+        uint32_t coverage;
+        memcpy(&coverage, block->alpha + k, 4);
+        __m128i a = _mm_cvtsi32_si128((int)coverage);
+        a = _mm_unpacklo_epi8(a, a);
+        a = _mm_unpacklo_epi16(a, a);
+
+        __m128i lo = blendLanesSSE2(src, _mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(a, zero));
+        __m128i hi = blendLanesSSE2(src, _mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(a, zero));
+        _mm_storeu_si128((__m128i*)out, _mm_packus_epi16(lo, hi));
+
+        for (int j = 0; j < 4; j++) {
+            storePacked(base + index[j] * size, out[j], format);
+        }
+    }
+
+    blendBlockScalar(base, block, k, color, format);
+}
+
+__attribute__((target("sse2")))
+static void blendBlockSSE2(unsigned char* base, const WuBlock* block, Color color,
+                           PixelFormat format) {
+    if (format == PIXEL_RGBA32) {
+        blendPixelsSSE2(base, block, color, PIXEL_RGBA32);
+    } else {
+        blendPixelsSSE2(base, block, color, PIXEL_RGB24);
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i blendLanesAVX2(__m256i src, __m256i dst, __m256i alpha) {
+    __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(src, alpha), _mm256_mullo_epi16(dst, inverse));
+    t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// The unpacks and the pack work within 128-bit halves, so the pixels come
+// back out in the order they went in
+__attribute__((target("avx2")))
+__attribute__((always_inline))
+static inline void blendPixelsAVX2(unsigned char* base, const WuBlock* block, Color color,
+                                   PixelFormat format) {
+    int size = format == PIXEL_RGBA32 ? 4 : 3;
+    __m256i zero = _mm256_setzero_si256();
+    __m256i src = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)packColor(color)), zero);
+    uint32_t out[8];
+    int k = 0;
+
+    for (; k + 8 <= block->count; k += 8) {
+        const long* index = block->index + k;
+        __m256i d = _mm256_set_epi32((int)loadPacked(base + index[7] * size, format),
+                                     (int)loadPacked(base + index[6] * size, format),
+                                     (int)loadPacked(base + index[5] * size, format),
+                                     (int)loadPacked(base + index[4] * size, format),
+                                     (int)loadPacked(base + index[3] * size, format),
+                                     (int)loadPacked(base + index[2] * size, format),
+                                     (int)loadPacked(base + index[1] * size, format),
+                                     (int)loadPacked(base + index[0] * size, format));
+
+        // Eight coverage bytes, each spread over its pixel's four channels
+        uint64_t coverage;
+        memcpy(&coverage, block->alpha + k, 8);
+        __m128i bytes = _mm_cvtsi64_si128((long long)coverage);
+        bytes = _mm_unpacklo_epi8(bytes, bytes);
+        __m256i a = _mm256_set_m128i(_mm_unpackhi_epi16(bytes, bytes), _mm_unpacklo_epi16(bytes, bytes));
+
+        __m256i lo = blendLanesAVX2(src, _mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(a, zero));
+        __m256i hi = blendLanesAVX2(src, _mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(a, zero));
+        _mm256_storeu_si256((__m256i*)out, _mm256_packus_epi16(lo, hi));
+
+        for (int j = 0; j < 8; j++) {
+            storePacked(base + index[j] * size, out[j], format);
+        }
+    }
+
+    blendBlockScalar(base, block, k, color, format);
+}
+
+__attribute__((target("avx2")))
+static void blendBlockAVX2(unsigned char* base, const WuBlock* block, Color color,
+                           PixelFormat format) {
+    if (format == PIXEL_RGBA32) {
+        blendPixelsAVX2(base, block, color, PIXEL_RGBA32);
+    } else {
+        blendPixelsAVX2(base, block, color, PIXEL_RGB24);
+    }
+}
+
+#endif
+
+static void blendBlock(const Framebuffer* fb, const WuBlock* block, Color color) {
+    unsigned char* base = (unsigned char*)fb->pixels;
+    PixelFormat format = fb->format == PIXEL_RGBA32 ? PIXEL_RGBA32 : PIXEL_RGB24;
+
+#ifdef RASTER_X86_SIMD
+    switch (activeSimdLevel()) {
+    case SIMD_AVX2:
+        blendBlockAVX2(base, block, color, format);
+        return;
+    case SIMD_SSE2:
+        blendBlockSSE2(base, block, color, format);
+        return;
+    case SIMD_SCALAR:
+    default:
+        break;
+    }
+#endif
+    if (format == PIXEL_RGBA32) {
+        blendBlockScalar(base, block, 0, color, PIXEL_RGBA32);
+    } else {
+        blendBlockScalar(base, block, 0, color, PIXEL_RGB24);
+    }
+}
+
+static inline void addCoverage(const Framebuffer* fb, WuBlock* block, long index, unsigned alpha,
+                               Color color) {
+    block->index[block->count] = index;
+    block->alpha[block->count] = (unsigned char)alpha;
+    if (++block->count == WU_BLOCK) {
+        blendBlock(fb, block, color);
+        block->count = 0;
+    }
+}
+
+void rasterizeLineWu(Framebuffer* fb, int x1, int y1, int x2, int y2, int start, Color color) {
+    if (!lineInRange(x1, y1, x2, y2)) {
+        return;
+    }
+
+    LineSteps line;
+    initLineSteps(&line, x1, y1, x2, y2);
+
+    // No channels to blend into: draw the aliased line instead
+    if (fb->format == PIXEL_INDEXED8 || fb->format == PIXEL_MASK1) {
+        int first, last;
+        if (clipLineSteps(&line, 0, 0, fb->width - 1, fb->height - 1, &first, &last)) {
+            first = first > start ? first : start;
+            if (first <= last) {
+                rasterizeLineSteps(fb, &line, first, last, color);
+            }
+        }
+        return;
+    }
+
+    // Beyond FIXED_DDA_MAX_STEPS the fixed-point position may round across
+    // a pixel boundary, so long lines take the bounds-checked loop too
+    int checked = !insideFramebuffer(fb, x1, y1) || !insideFramebuffer(fb, x2, y2) ||
+                  line.major > FIXED_DDA_MAX_STEPS;
+    int first = start;
+    int last = line.major;
+
+    // Both pixels of a step are within one pixel of the Bresenham pixel on
+    // the minor axis, so only steps whose Bresenham pixel lies in the
+    // framebuffer grown by one pixel can show
+    if (checked && !clipLineSteps(&line, -1, -1, fb->width, fb->height, &first, &last)) {
+        return;
+    }
+    if (first < start) {
+        first = start;
+    }
+    if (first > last) {
+        return;
+    }
+
+    // Rounded up, so exact integer positions are never undershot and the
+    // endpoints get full coverage
+    uint64_t increment = line.major
+        ? (((uint64_t)line.minor << 32) + (uint64_t)line.major - 1) / (uint64_t)line.major : 0;
+    uint64_t acc = (uint64_t)first * increment;
+    WuBlock block;
+    block.count = 0;
+
+    if (!checked) {
+        long stepX = line.xMajor ? line.majorSign : line.minorSign;
+        long stepY = (long)(line.xMajor ? line.minorSign : line.majorSign) * fb->stride;
+        long majorStep = line.xMajor ? stepX : stepY;
+        long minorStep = line.xMajor ? stepY : stepX;
+        uint32_t offset = (uint32_t)(acc >> 32);
+        long index = (long)y1 * fb->stride + x1 + first * majorStep + (long)offset * minorStep;
+
+        // Whole blocks of steps, two entries each and no branches. The far
+        // pixel of a step with coverage is at most the end of the line on
+        // the minor axis, so it is inside too. A step without coverage
+        // lists its near pixel twice instead, first at alpha 0; the blend
+        // stores entries in order, so the real store lands last.
+        for (int i = first; i <= last; ) {
+            int steps = last - i + 1 < WU_BLOCK / 2 ? last - i + 1 : WU_BLOCK / 2;
+
+            for (int k = 0; k < 2 * steps; k += 2, i++) {
+                unsigned coverage = (unsigned)(acc >> 24) & 0xFF;
+
+                block.index[k] = coverage ? index + minorStep : index;
+                block.alpha[k] = (unsigned char)coverage;
+                block.index[k + 1] = index;
+                block.alpha[k + 1] = (unsigned char)(255 - coverage);
+
+                acc += increment;
+                uint32_t next = (uint32_t)(acc >> 32);
+                index += majorStep + (long)(next - offset) * minorStep;
+                offset = next;
+            }
+            block.count = 2 * steps;
+            blendBlock(fb, &block, color);
+        }
+        return;
+    } else {
+        int majorStart = line.xMajor ? line.x1 : line.y1;
+        int minorStart = line.xMajor ? line.y1 : line.x1;
+
+        for (int i = first; i <= last; i++, acc += increment) {
+            unsigned coverage = (unsigned)(acc >> 24) & 0xFF;
+            int majorCoord = majorStart + line.majorSign * i;
+            int minorCoord = minorStart + line.minorSign * (int)(acc >> 32);
+
+            for (int side = 0; side <= 1; side++, minorCoord += line.minorSign) {
+                unsigned alpha = side ? coverage : 255 - coverage;
+                int x = line.xMajor ? majorCoord : minorCoord;
+                int y = line.xMajor ? minorCoord : majorCoord;
+
+                if (alpha && insideFramebuffer(fb, x, y)) {
+                    addCoverage(fb, &block, (long)y * fb->stride + x, alpha, color);
+                }
+            }
+        }
+    }
+
+    if (block.count > 0) {
+        blendBlock(fb, &block, color);
+    }
+}
+
+// Xiaolin Wu's Anti-Aliased Line Drawing Algorithm
+void drawLineWu(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    rasterizeLineWu(fb, x1, y1, x2, y2, 0, color);
+}
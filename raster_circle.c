@@ -0,0 +1,386 @@
+#include <stdlib.h>
+#include "raster.h"
+#include "raster_internal.h"
+#include "raster_trace.h"
+
+// Span-based circle engine.
+//
+// The midpoint walk covers one octant. Mirrored eight ways, each of its
+// points (x, y) lands on rows yc +- y at columns xc +- x and on rows
+// yc +- x at columns xc +- y. Instead of plotting those eight pixels (which
+// writes the same pixel twice wherever x == 0 or x == y), the walk records,
+// for every row offset t in [0, radius], the range [inner, outer] of column
+// offsets its outline covers right of the center. For this walk that range
+// is always contiguous, so every mode turns a row into at most two spans:
+//
+//   outline  [xc - outer, xc - inner] and [xc + inner, xc + outer],
+//            one span when inner == 0
+//   filled   [xc - outer, xc + outer]
+//   ring     the filled span minus the filled span of the inner radius
+//
+// on rows yc + t and yc - t (only once for t == 0), so each pixel is
+// written exactly once.
+
+// Row extents kept on the stack; larger circles allocate them
+#define CIRCLE_STACK_ROWS 512
+
+typedef struct {
+    int inner, outer;       // column offsets right of the center
+} CircleRow;
+
+// Final state of the octant walk, for the trace summary
+typedef struct {
+    int steps;
+    int x, y, d;
+} CircleWalk;
+
+static inline void extendRow(CircleRow* rows, int t, int offset) {
+    if (offset < rows[t].inner) {
+        rows[t].inner = offset;
+    }
+    if (offset > rows[t].outer) {
+        rows[t].outer = offset;
+    }
+}
+
+// Midpoint walk filling rows[0..radius]; see rasterizeDDA for the trace
+// parameter. `radius` must be >= 0.
+static inline void walkCircle(CircleRow* rows, int radius, CircleWalk* walk, TraceLevel trace) {
+    int x = 0;
+    int y = radius;
+    int d = 3 - 2 * radius;  // Initial decision parameter
+    int step = 0;
+
+    if (radius == 0) {
+        // A single pixel; the walk below would overshoot to (1, -1)
+        rows[0].inner = 0;
+        rows[0].outer = 0;
+        if (trace >= TRACE_STEPS) {
+            traceEmit(TRACE_STEP, TRACE_CIRCLE_BRESENHAM, 0, 0, 0, d, 0, 0, 0);
+        }
+        walk->steps = 1;
+        walk->x = 0;
+        walk->y = 0;
+        walk->d = d;
+        return;
+    }
+
+    for (int t = 0; t <= radius; t++) {
+        rows[t].inner = radius + 1;
+        rows[t].outer = -1;
+    }
+
+    extendRow(rows, y, x);
+    extendRow(rows, x, y);
+    if (trace >= TRACE_STEPS) {
+        traceEmit(TRACE_STEP, TRACE_CIRCLE_BRESENHAM, step, x, y, d, 0, 0, 0);
+    }
+    step++;
+
+    // Calculate one octant, use symmetry for the others
+    while (x <= y) {
+        x++;
+
+        if (d < 0) {
+            // Select E (East) point
+            d = d + 4 * x + 6;
+        } else {
+            // Select SE (South-East) point
+            y--;
+            d = d + 4 * (x - y) + 10;
+        }
+
+        extendRow(rows, y, x);
+        extendRow(rows, x, y);
+        if (trace >= TRACE_STEPS) {
+            traceEmit(TRACE_STEP, TRACE_CIRCLE_BRESENHAM, step, x, y, d, 0, 0, 0);
+        }
+        step++;
+    }
+
+    walk->steps = step;
+    walk->x = x;
+    walk->y = y;
+    walk->d = d;
+}
+
+// Spans [xc - outer, xc - inner] and [xc + inner, xc + outer] on row y,
+// merged when they touch
+static inline long mirroredSpans(const Framebuffer* fb, int xc, int inner, int outer, int y,
+                                 Color color) {
+    if (inner <= 0) {
+        return clippedSpan(fb, xc - outer, xc + outer, y, color);
+    }
+    return clippedSpan(fb, xc - outer, xc - inner, y, color) +
+           clippedSpan(fb, xc + inner, xc + outer, y, color);
+}
+
+// Spans of one row of a circle that lies wholly inside the framebuffer;
+// nothing when inner > outer
+static inline void rowSpans(Pixel* center, int inner, int outer, Color color) {
+    if (inner <= 0) {
+        fillPixels(center - outer, 2 * outer + 1, color);
+    } else {
+        fillPixels(center - outer, outer - inner + 1, color);
+        fillPixels(center + inner, outer - inner + 1, color);
+    }
+}
+
+static inline long rowPixels(int inner, int outer) {
+    if (inner > outer) {
+        return 0;
+    }
+    return inner <= 0 ? 2L * outer + 1 : 2L * (outer - inner + 1);
+}
+
+// Whole circle on screen, in RGB24 (the row-pointer fast path)
+static inline int circleInside(const Framebuffer* fb, int xc, int yc, int radius) {
+    return fb->format == PIXEL_RGB24 && xc >= radius && xc < fb->width - radius && yc >= radius && yc < fb->height - radius;
+}
+
+static long emitOutline(const Framebuffer* fb, int xc, int yc, const CircleRow* rows, int radius,
+                        Color color) {
+    long pixels = 0;
+
+    if (circleInside(fb, xc, yc, radius)) {
+        // No clipping: walk two row pointers out from the center row
+        Pixel* up = pixelAt(fb, xc, yc);
+        Pixel* down = up;
+
+        rowSpans(up, rows[0].inner, rows[0].outer, color);
+        pixels += rowPixels(rows[0].inner, rows[0].outer);
+        for (int t = 1; t <= radius; t++) {
+            up -= fb->stride;
+            down += fb->stride;
+            rowSpans(up, rows[t].inner, rows[t].outer, color);
+            rowSpans(down, rows[t].inner, rows[t].outer, color);
+            pixels += 2 * rowPixels(rows[t].inner, rows[t].outer);
+        }
+        return pixels;
+    }
+
+    pixels = mirroredSpans(fb, xc, rows[0].inner, rows[0].outer, yc, color);
+    for (int t = 1; t <= radius; t++) {
+        pixels += mirroredSpans(fb, xc, rows[t].inner, rows[t].outer, yc - t, color);
+        pixels += mirroredSpans(fb, xc, rows[t].inner, rows[t].outer, yc + t, color);
+    }
+    return pixels;
+}
+
+// Ring of the disc `rows` minus the disc `hole` (radius holeRadius, or no
+// hole when holeRadius < 0). A plain filled disc is a ring without a hole.
+static long emitRing(const Framebuffer* fb, int xc, int yc, const CircleRow* rows, int radius,
+                     const CircleRow* hole, int holeRadius, Color color) {
+    long pixels = 0;
+
+    if (circleInside(fb, xc, yc, radius)) {
+        Pixel* up = pixelAt(fb, xc, yc);
+        Pixel* down = up;
+        int inner = holeRadius >= 0 ? hole[0].outer + 1 : 0;
+
+        rowSpans(up, inner, rows[0].outer, color);
+        pixels += rowPixels(inner, rows[0].outer);
+        for (int t = 1; t <= radius; t++) {
+            inner = t <= holeRadius ? hole[t].outer + 1 : 0;
+            up -= fb->stride;
+            down += fb->stride;
+            rowSpans(up, inner, rows[t].outer, color);
+            rowSpans(down, inner, rows[t].outer, color);
+            pixels += 2 * rowPixels(inner, rows[t].outer);
+        }
+        return pixels;
+    }
+
+    for (int t = 0; t <= radius; t++) {
+        int inner = t <= holeRadius ? hole[t].outer + 1 : 0;
+
+        pixels += mirroredSpans(fb, xc, inner, rows[t].outer, yc - t, color);
+        if (t > 0) {
+            pixels += mirroredSpans(fb, xc, inner, rows[t].outer, yc + t, color);
+        }
+    }
+    return pixels;
+}
+
+static inline int circleVisible(const Framebuffer* fb, int xc, int yc, int radius) {
+    return (long)xc + radius >= 0 && (long)xc - radius < fb->width &&
+           (long)yc + radius >= 0 && (long)yc - radius < fb->height;
+}
+
+// Row storage for circles up to `radius`: the stack buffer if it is large
+// enough, otherwise a heap block the caller frees
+static CircleRow* circleRows(CircleRow* stack, int radius) {
+    if (radius < CIRCLE_STACK_ROWS) {
+        return stack;
+    }
+    return malloc(sizeof(CircleRow) * ((size_t)radius + 1));
+}
+
+static inline void rasterizeCircle(Framebuffer* fb, int xc, int yc, int radius, Color color,
+                                   TraceLevel trace) {
+    CircleRow stack[CIRCLE_STACK_ROWS];
+    CircleWalk walk;
+
+    if (radius < 0 || radius > CIRCLE_MAX_RADIUS) {
+        return;
+    }
+    if (trace >= TRACE_SUMMARY) {
+        traceEmit(TRACE_BEGIN, TRACE_CIRCLE_BRESENHAM, xc, yc, radius, 3 - 2 * radius, 0, 0, 0);
+    } else if (!circleVisible(fb, xc, yc, radius)) {
+        return;
+    }
+
+    CircleRow* rows = circleRows(stack, radius);
+    if (!rows) {
+        return;
+    }
+    walkCircle(rows, radius, &walk, trace);
+    long pixels = emitOutline(fb, xc, yc, rows, radius, color);
+    if (rows != stack) {
+        free(rows);
+    }
+
+    if (trace >= TRACE_SUMMARY) {
+        traceEmit(TRACE_END, TRACE_CIRCLE_BRESENHAM, walk.steps, (int32_t)pixels, walk.x, walk.y,
+                  walk.d, 0, 0);
+    }
+}
+
+// Bresenham's Circle Drawing Algorithm (Midpoint Circle Algorithm)
+void drawCircleBresenham(Framebuffer* fb, int xc, int yc, int radius, Color color) {
+    if (rasterTraceLevel == TRACE_OFF) {
+        rasterizeCircle(fb, xc, yc, radius, color, TRACE_OFF);
+    } else {
+        rasterizeCircle(fb, xc, yc, radius, color, rasterTraceLevel);
+    }
+}
+
+// Plot 8 symmetrical points of the circle
+void plotCirclePoints(Framebuffer* fb, int xc, int yc, int x, int y, Color color) {
+    setPixel(fb, xc + x, yc + y, color);  // Octant 1
+    setPixel(fb, xc - x, yc + y, color);  // Octant 2
+    setPixel(fb, xc + x, yc - y, color);  // Octant 3
+    setPixel(fb, xc - x, yc - y, color);  // Octant 4
+    setPixel(fb, xc + y, yc + x, color);  // Octant 5
+    setPixel(fb, xc - y, yc + x, color);  // Octant 6
+    setPixel(fb, xc + y, yc - x, color);  // Octant 7
+    setPixel(fb, xc - y, yc - x, color);  // Octant 8
+}
+
+// Row extents of the last circles drawn, reused while the radius repeats
+// (marker batches usually share one size)
+typedef struct {
+    CircleRow stack[CIRCLE_STACK_ROWS];
+    CircleRow* rows;
+    int capacity;           // largest radius `rows` can hold
+    int radius;             // -1 when nothing is cached
+} CircleRowCache;
+
+static void initRowCache(CircleRowCache* cache) {
+    cache->rows = cache->stack;
+    cache->capacity = CIRCLE_STACK_ROWS - 1;
+    cache->radius = -1;
+}
+
+// Rows for `radius`, or NULL if they could not be allocated
+static const CircleRow* cachedRows(CircleRowCache* cache, int radius) {
+    CircleWalk walk;
+
+    if (radius == cache->radius) {
+        return cache->rows;
+    }
+    if (radius > cache->capacity) {
+        CircleRow* rows = malloc(sizeof(CircleRow) * ((size_t)radius + 1));
+        if (!rows) {
+            return NULL;
+        }
+        if (cache->rows != cache->stack) {
+            free(cache->rows);
+        }
+        cache->rows = rows;
+        cache->capacity = radius;
+    }
+    walkCircle(cache->rows, radius, &walk, TRACE_OFF);
+    cache->radius = radius;
+    return cache->rows;
+}
+
+static void freeRowCache(CircleRowCache* cache) {
+    if (cache->rows != cache->stack) {
+        free(cache->rows);
+    }
+}
+
+static long drawCircleCached(Framebuffer* fb, int xc, int yc, int radius, CircleMode mode,
+                             int thickness, Color color, CircleRowCache* outer,
+                             CircleRowCache* hole) {
+    if (radius < 0 || radius > CIRCLE_MAX_RADIUS || !circleVisible(fb, xc, yc, radius)) {
+        return 0;
+    }
+
+    const CircleRow* rows = cachedRows(outer, radius);
+    if (!rows) {
+        return 0;
+    }
+
+    switch (mode) {
+    case CIRCLE_OUTLINE:
+        return emitOutline(fb, xc, yc, rows, radius, color);
+
+    case CIRCLE_FILLED:
+        return emitRing(fb, xc, yc, rows, radius, NULL, -1, color);
+
+    case CIRCLE_RING:
+    default: {
+        int holeRadius = radius - (thickness > 0 ? thickness : 1);
+        const CircleRow* holeRows = NULL;
+
+        if (holeRadius >= 0) {
+            holeRows = cachedRows(hole, holeRadius);
+            if (!holeRows) {
+                return 0;
+            }
+        }
+        return emitRing(fb, xc, yc, rows, radius, holeRows, holeRadius, color);
+    }
+    }
+}
+
+void fillCircle(Framebuffer* fb, int xc, int yc, int radius, Color color) {
+    CircleRowCache cache;
+
+    initRowCache(&cache);
+    drawCircleCached(fb, xc, yc, radius, CIRCLE_FILLED, 0, color, &cache, NULL);
+    freeRowCache(&cache);
+}
+
+void drawRing(Framebuffer* fb, int xc, int yc, int radius, int thickness, Color color) {
+    CircleRowCache outer, hole;
+
+    initRowCache(&outer);
+    initRowCache(&hole);
+    drawCircleCached(fb, xc, yc, radius, CIRCLE_RING, thickness, color, &outer, &hole);
+    freeRowCache(&outer);
+    freeRowCache(&hole);
+}
+
+void drawCircleBatch(Framebuffer* fb, const Circle* circles, size_t count, CircleMode mode,
+                     int thickness, BatchStats* stats) {
+    double start = stats ? batchClock() : 0.0;
+    CircleRowCache outer, hole;
+    size_t pixels = 0;
+
+    initRowCache(&outer);
+    initRowCache(&hole);
+    for (size_t i = 0; i < count; i++) {
+        const Circle* c = &circles[i];
+        pixels += drawCircleCached(fb, c->xc, c->yc, c->radius, mode, thickness, c->color,
+                                   &outer, &hole);
+    }
+    freeRowCache(&outer);
+    freeRowCache(&hole);
+
+    if (stats) {
+        finishBatchPixels(stats, count, pixels, start);
+    }
+}
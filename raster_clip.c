@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include "raster.h"
+#include "raster_internal.h"
+
+// Clipping stage ahead of the line rasterizers.
+//
+// Segments are first classified with Cohen-Sutherland outcodes. Both
+// endpoints inside is the common case and needs no clipping; both beyond
+// the same edge is rejected outright. Everything else is clipped
+// parametrically, Liang-Barsky style, but in the line's own step index
+// rather than in real coordinates: the major axis bounds the step
+// linearly, and the minor axis bounds it through the inverse of
+// Bresenham's rounding (see LineSteps in raster_internal.h). That gives
+// the exact range of visible steps, and the line is entered at the first
+// one with the exact error term.
+
+#define OUT_LEFT   1
+#define OUT_RIGHT  2
+#define OUT_TOP    4
+#define OUT_BOTTOM 8
+
+static inline int outcode(const ClipRect* clip, int x, int y) {
+    int code = 0;
+
+    if (x < clip->left) {
+        code |= OUT_LEFT;
+    } else if (x > clip->right) {
+        code |= OUT_RIGHT;
+    }
+    if (y < clip->top) {
+        code |= OUT_TOP;
+    } else if (y > clip->bottom) {
+        code |= OUT_BOTTOM;
+    }
+    return code;
+}
+
+int clipLine(const ClipRect* clip, int* x1, int* y1, int* x2, int* y2) {
+    if (!lineInRange(*x1, *y1, *x2, *y2)) {
+        return 0;
+    }
+
+    int code1 = outcode(clip, *x1, *y1);
+    int code2 = outcode(clip, *x2, *y2);
+
+    if ((code1 | code2) == 0) {
+        return 1;
+    }
+    if (code1 & code2) {
+        return 0;
+    }
+
+    LineSteps line;
+    int first, last;
+
+    initLineSteps(&line, *x1, *y1, *x2, *y2);
+    if (!clipLineSteps(&line, clip->left, clip->top, clip->right, clip->bottom, &first, &last)) {
+        return 0;
+    }
+    lineStepPoint(&line, first, x1, y1);
+    lineStepPoint(&line, last, x2, y2);
+    return 1;
+}
+
+// `clip` must already lie inside the framebuffer
+static void rasterizeInRect(Framebuffer* fb, int x1, int y1, int x2, int y2, const ClipRect* clip,
+                            Color color) {
+    int code1 = outcode(clip, x1, y1);
+    int code2 = outcode(clip, x2, y2);
+
+    if ((code1 & code2) || !lineInRange(x1, y1, x2, y2)) {
+        return;
+    }
+
+    LineSteps line;
+    int first, last;
+
+    initLineSteps(&line, x1, y1, x2, y2);
+    if ((code1 | code2) == 0) {
+        rasterizeLineSteps(fb, &line, 0, line.major, color);
+    } else if (clipLineSteps(&line, clip->left, clip->top, clip->right, clip->bottom, &first, &last)) {
+        rasterizeLineSteps(fb, &line, first, last, color);
+    }
+}
+
+void rasterizeLineClipped(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    ClipRect viewport = { 0, 0, fb->width - 1, fb->height - 1 };
+
+    rasterizeInRect(fb, x1, y1, x2, y2, &viewport, color);
+}
+
+void drawLineClipped(Framebuffer* fb, int x1, int y1, int x2, int y2, const ClipRect* clip,
+                     Color color) {
+    ClipRect visible = *clip;
+
+    if (visible.left < 0) {
+        visible.left = 0;
+    }
+    if (visible.top < 0) {
+        visible.top = 0;
+    }
+    if (visible.right > fb->width - 1) {
+        visible.right = fb->width - 1;
+    }
+    if (visible.bottom > fb->height - 1) {
+        visible.bottom = fb->height - 1;
+    }
+    if (visible.left > visible.right || visible.top > visible.bottom) {
+        return;
+    }
+
+    rasterizeInRect(fb, x1, y1, x2, y2, &visible, color);
+}
+
+int clipLineDDASteps(const Framebuffer* fb, int x1, int y1, int x2, int y2, int steps,
+                     int* first, int* last) {
+    // Start, delta and size of each axis
+    double start[2] = { x1, y1 };
+    double delta[2] = { (double)x2 - x1, (double)y2 - y1 };
+    double size[2] = { fb->width, fb->height };
+
+    // The float accumulators can be off from the ideal line by one rounding
+    // of each addition (at most half an ulp of the largest coordinate), one
+    // rounding of the increment per step, and one of the start value
+    double largest = fmax(fmax(fabs((double)x1), fabs((double)x2)),
+                          fmax(fabs((double)y1), fabs((double)y2))) + 1.0;
+    double drift = (steps + 3.0) * largest * FLT_EPSILON + 1.0;
+
+    double lo = 0.0;
+    double hi = steps;
+
+    for (int axis = 0; axis < 2; axis++) {
+        // round(v) lands inside when v is in [-0.5, size - 0.5)
+        double enter = -0.5 - drift - start[axis];
+        double leave = size[axis] - 0.5 + drift - start[axis];
+
+        if (delta[axis] == 0.0) {
+            if (enter > 0.0 || leave < 0.0) {
+                return 0;
+            }
+            continue;
+        }
+
+        double t0 = enter * steps / delta[axis];
+        double t1 = leave * steps / delta[axis];
+        if (t0 > t1) {
+            double swap = t0;
+            t0 = t1;
+            t1 = swap;
+        }
+        lo = fmax(lo, ceil(t0));
+        hi = fmin(hi, floor(t1));
+    }
+
+    if (lo > hi) {
+        return 0;
+    }
+    *first = (int)lo;
+    *last = (int)hi;
+    return 1;
+}
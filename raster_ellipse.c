@@ -0,0 +1,486 @@
+#include <stdlib.h>
+#include <math.h>
+#include "raster.h"
+#include "raster_internal.h"
+
+// Span-based ellipse engine.
+//
+// The midpoint walk covers one quadrant in two regions: x steps while the
+// slope is shallow, y steps once it is steep. Mirrored four ways, each of
+// its points (x, y) lands on rows yc +- y at columns xc +- x. As in
+// raster_circle.c the walk records, for every row offset t in [0, ry],
+// the contiguous range [inner, outer] of column offsets its outline covers
+// right of the center, and every row is drawn as at most two spans:
+//
+//   outline  [xc - outer, xc - inner] and [xc + inner, xc + outer]
+//   filled   [xc - outer, xc + outer]
+//
+// Arcs and pies cut those spans with the angular sector. A sector meets
+// any row in at most two intervals of columns, found exactly with integer
+// half-plane tests, so an arc is still drawn span by span and each pixel
+// of the ellipse belongs to exactly one of two complementary sectors.
+
+// Row extents kept on the stack; taller ellipses allocate them
+#define ELLIPSE_STACK_ROWS 512
+
+// Sector directions are unit vectors scaled to this many units
+#define SECTOR_SCALE (1 << 20)
+
+// Beyond any column offset the sector tests see
+#define SECTOR_FAR ((long long)1 << 40)
+
+typedef struct {
+    int inner, outer;       // column offsets right of the center
+} EllipseRow;
+
+// Angular sector: start direction s and end direction e, sweeping
+// counterclockwise (as seen on screen) from s to e
+typedef struct {
+    int full;               // 360 degrees or more: no cut at all
+    int wide;               // more than 180 degrees
+    long long sx, sy;       // mathematical orientation: y up
+    long long ex, ey;
+} Sector;
+
+typedef struct {
+    long long lo, hi;       // column offsets; empty when lo > hi
+} Interval;
+
+static inline void extendRow(EllipseRow* rows, int t, int offset) {
+    if (offset < rows[t].inner) {
+        rows[t].inner = offset;
+    }
+    if (offset > rows[t].outer) {
+        rows[t].outer = offset;
+    }
+}
+
+// Midpoint walk filling rows[0..ry]. The decision parameters are scaled
+// by 4 so the half-pixel midpoints stay integral; radii are at most
+// ELLIPSE_MAX_RADIUS, which keeps every product within 64 bits.
+static void walkEllipse(EllipseRow* rows, int rx, int ry) {
+    if (rx == 0 || ry == 0) {
+        // A line (or a pixel): one span per row
+        for (int t = 0; t <= ry; t++) {
+            rows[t].inner = 0;
+            rows[t].outer = rx;
+        }
+        return;
+    }
+
+    for (int t = 0; t <= ry; t++) {
+        rows[t].inner = rx + 1;
+        rows[t].outer = -1;
+    }
+
+    long long a2 = (long long)rx * rx;
+    long long b2 = (long long)ry * ry;
+    int x = 0;
+    int y = ry;
+    long long dx = 0;                   // 2 * b2 * x
+    long long dy = 2 * a2 * y;          // 2 * a2 * y
+    long long d = 4 * b2 - 4 * a2 * ry + a2;
+
+    // Region 1: the slope is shallower than -1, x steps
+    while (dx < dy) {
+        extendRow(rows, y, x);
+        x++;
+        dx += 2 * b2;
+        if (d < 0) {
+            d += 4 * (dx + b2);
+        } else {
+            y--;
+            dy -= 2 * a2;
+            d += 4 * (dx - dy + b2);
+        }
+    }
+
+    // Region 2: y steps down to the horizontal axis
+    d = b2 * (2LL * x + 1) * (2LL * x + 1) + 4 * a2 * ((long long)y - 1) * ((long long)y - 1) -
+        4 * a2 * b2;
+    while (y >= 0) {
+        extendRow(rows, y, x);
+        y--;
+        dy -= 2 * a2;
+        if (d > 0) {
+            d += 4 * (a2 - dy);
+        } else {
+            x++;
+            dx += 2 * b2;
+            d += 4 * (dx - dy + a2);
+        }
+    }
+
+    // A thin ellipse can reach the axis before x gets to rx
+    extendRow(rows, 0, rx);
+}
+
+// Row storage for an ellipse of height ry: the stack buffer if it is large
+// enough, otherwise a heap block the caller frees
+static EllipseRow* ellipseRows(EllipseRow* stack, int ry) {
+    if (ry < ELLIPSE_STACK_ROWS) {
+        return stack;
+    }
+    return malloc(sizeof(EllipseRow) * ((size_t)ry + 1));
+}
+
+static inline int ellipseVisible(const Framebuffer* fb, int xc, int yc, int rx, int ry) {
+    return (long)xc + rx >= 0 && (long)xc - rx < fb->width &&
+           (long)yc + ry >= 0 && (long)yc - ry < fb->height;
+}
+
+static inline int validRadii(int rx, int ry) {
+    return rx >= 0 && ry >= 0 && rx <= ELLIPSE_MAX_RADIUS && ry <= ELLIPSE_MAX_RADIUS;
+}
+
+static void initSector(Sector* sector, double startDegrees, double sweepDegrees) {
+    const double pi = 3.14159265358979323846;
+    double start = startDegrees * pi / 180.0;
+    double end = (startDegrees + sweepDegrees) * pi / 180.0;
+
+    sector->full = sweepDegrees >= 360.0;
+    sector->wide = sweepDegrees > 180.0;    // and full ones
+    sector->sx = llround(cos(start) * SECTOR_SCALE);
+    sector->sy = llround(sin(start) * SECTOR_SCALE);
+    sector->ex = llround(cos(end) * SECTOR_SCALE);
+    sector->ey = llround(sin(end) * SECTOR_SCALE);
+}
+
+// Columns qx of row qy (y up) whose direction lies in the half-open
+// half-turn [u, u + 180 degrees): cross(u, q) > 0, or q points along u.
+// That set is a half-line, all of the row or none of it.
+static Interval halfTurn(long long ux, long long uy, long long qy) {
+    Interval all = { -SECTOR_FAR, SECTOR_FAR };
+    Interval none = { 1, 0 };
+    long long n = ux * qy;
+
+    if (uy == 0) {
+        if (n != 0) {
+            return n > 0 ? all : none;
+        }
+        // Along the row itself: the side u points to
+        Interval side = { ux > 0 ? 1 : -SECTOR_FAR, ux > 0 ? SECTOR_FAR : -1 };
+        return side;
+    }
+
+    // cross = n - uy * qx; on the boundary qx = n / uy the point counts
+    // when it lies along u rather than against it
+    Interval half;
+    if (uy > 0) {
+        half.lo = -SECTOR_FAR;
+        half.hi = (n % uy == 0 && qy > 0) ? n / uy : floorDiv(n - 1, uy);
+    } else {
+        half.lo = (n % uy == 0 && qy < 0) ? n / uy : floorDiv(n, uy) + 1;
+        half.hi = SECTOR_FAR;
+    }
+    return half;
+}
+
+// Columns of row qy in the sector [s, e) of at most half a turn: in
+// [s, s + 180) but not in [e, e + 180). Never includes the center.
+static Interval narrowSector(long long sx, long long sy, long long ex, long long ey, long long qy) {
+    Interval fromStart = halfTurn(sx, sy, qy);
+    Interval fromEnd = halfTurn(ex, ey, qy);
+    Interval in = fromStart;
+
+    // fromEnd is a half-line, all or none, so removing it leaves one interval
+    if (fromEnd.lo <= fromEnd.hi) {
+        if (fromEnd.lo <= -SECTOR_FAR && fromEnd.hi >= SECTOR_FAR) {
+            in.lo = 1;
+            in.hi = 0;
+        } else if (fromEnd.lo <= -SECTOR_FAR) {
+            in.lo = in.lo > fromEnd.hi + 1 ? in.lo : fromEnd.hi + 1;
+        } else {
+            in.hi = in.hi < fromEnd.lo - 1 ? in.hi : fromEnd.lo - 1;
+        }
+    }
+    return in;
+}
+
+// Column intervals of row qy (y up) inside `sector`, disjoint and in
+// order, leaving out the center; returns how many (0 to 2)
+static int sectorRow(const Sector* sector, long long qy, Interval* out) {
+    Interval row = { -SECTOR_FAR, SECTOR_FAR };
+    int count = 0;
+
+    if (!sector->wide) {
+        row = narrowSector(sector->sx, sector->sy, sector->ex, sector->ey, qy);
+        out[0] = row;
+        return row.lo <= row.hi;
+    }
+
+    // Wider than a half turn: everything outside [e, s + 360)
+    if (!sector->full) {
+        Interval rest = narrowSector(sector->ex, sector->ey, sector->sx, sector->sy, qy);
+        if (rest.lo <= rest.hi) {
+            Interval before = { -SECTOR_FAR, rest.lo - 1 };
+            Interval after = { rest.hi + 1, SECTOR_FAR };
+            if (before.lo <= before.hi) {
+                out[count++] = before;
+            }
+            if (after.lo <= after.hi) {
+                out[count++] = after;
+            }
+            if (qy != 0 || count != 1) {
+                return count;
+            }
+            // On the center row the rest is one side, so one interval
+            // remains and it holds the center
+            row = out[0];
+            count = 0;
+        }
+    }
+    if (qy != 0) {
+        out[0] = row;
+        return 1;
+    }
+
+    // Split at the center
+    if (row.lo < 0) {
+        out[count].lo = row.lo;
+        out[count++].hi = row.hi < -1 ? row.hi : -1;
+    }
+    if (row.hi > 0) {
+        out[count].lo = row.lo > 1 ? row.lo : 1;
+        out[count++].hi = row.hi;
+    }
+    return count;
+}
+
+// Span [xc + lo, xc + hi] of row y cut to the sector intervals
+static long sectorSpan(const Framebuffer* fb, int xc, int lo, int hi, int y,
+                       const Interval* cuts, int cutCount, Color color) {
+    long pixels = 0;
+
+    for (int i = 0; i < cutCount; i++) {
+        long long from = cuts[i].lo > lo ? cuts[i].lo : lo;
+        long long to = cuts[i].hi < hi ? cuts[i].hi : hi;
+        if (from <= to) {
+            pixels += clippedSpan(fb, xc + (int)from, xc + (int)to, y, color);
+        }
+    }
+    return pixels;
+}
+
+// One row of an ellipse at row offset t below (qy = -t) or above (qy = t)
+// the center; `sector` is NULL for the whole ellipse
+static long ellipseRow(const Framebuffer* fb, int xc, int y, long long qy, const EllipseRow* row,
+                       int filled, const Sector* sector, Color color) {
+    Interval cuts[2] = { { -SECTOR_FAR, SECTOR_FAR }, { 1, 0 } };
+    int cutCount = 1;
+    long pixels = 0;
+
+    if ((unsigned)y >= (unsigned)fb->height || row->inner > row->outer) {
+        return 0;
+    }
+    if (sector) {
+        cutCount = sectorRow(sector, qy, cuts);
+
+        // The center has no direction: a pie always has it, an arc (of a
+        // flat ellipse) when it takes the pixels pointing right
+        if (qy == 0 && (row->inner <= 0 || filled) &&
+            (filled || (cutCount > 0 && cuts[cutCount - 1].hi > 0))) {
+            pixels += clippedSpan(fb, xc, xc, y, color);
+        }
+    }
+
+    if (filled || row->inner <= 0) {
+        return pixels + sectorSpan(fb, xc, -row->outer, row->outer, y, cuts, cutCount, color);
+    }
+    return pixels + sectorSpan(fb, xc, -row->outer, -row->inner, y, cuts, cutCount, color) +
+           sectorSpan(fb, xc, row->inner, row->outer, y, cuts, cutCount, color);
+}
+
+// Whole ellipse on screen, in RGB24 (the row-pointer fast path)
+static inline int ellipseInside(const Framebuffer* fb, int xc, int yc, int rx, int ry) {
+    return fb->format == PIXEL_RGB24 && xc >= rx && xc < fb->width - rx && yc >= ry &&
+           yc < fb->height - ry;
+}
+
+// One unclipped row of a whole ellipse around `center`; returns its pixels
+static inline long rowSpans(Pixel* center, const EllipseRow* row, int filled, Color color) {
+    if (row->inner > row->outer) {
+        return 0;
+    }
+    if (filled || row->inner <= 0) {
+        fillPixels(center - row->outer, 2 * row->outer + 1, color);
+        return 2L * row->outer + 1;
+    }
+    fillPixels(center - row->outer, row->outer - row->inner + 1, color);
+    fillPixels(center + row->inner, row->outer - row->inner + 1, color);
+    return 2L * (row->outer - row->inner + 1);
+}
+
+static long emitEllipse(const Framebuffer* fb, int xc, int yc, const EllipseRow* rows, int ry,
+                        int filled, const Sector* sector, Color color) {
+    if (!sector && ellipseInside(fb, xc, yc, rows[0].outer, ry)) {
+        // No clipping and no cut: walk two row pointers out from the center row
+        Pixel* up = pixelAt(fb, xc, yc);
+        Pixel* down = up;
+        long pixels = rowSpans(up, &rows[0], filled, color);
+
+        for (int t = 1; t <= ry; t++) {
+            up -= fb->stride;
+            down += fb->stride;
+            pixels += rowSpans(up, &rows[t], filled, color);
+            pixels += rowSpans(down, &rows[t], filled, color);
+        }
+        return pixels;
+    }
+
+    long pixels = ellipseRow(fb, xc, yc, 0, &rows[0], filled, sector, color);
+
+    for (int t = 1; t <= ry; t++) {
+        pixels += ellipseRow(fb, xc, yc - t, t, &rows[t], filled, sector, color);
+        pixels += ellipseRow(fb, xc, yc + t, -t, &rows[t], filled, sector, color);
+    }
+    return pixels;
+}
+
+// Row extents of the last ellipse walked, reused while the radii repeat
+typedef struct {
+    EllipseRow stack[ELLIPSE_STACK_ROWS];
+    EllipseRow* rows;
+    int capacity;           // largest ry `rows` can hold
+    int rx, ry;             // -1 when nothing is cached
+} EllipseRowCache;
+
+static void initRowCache(EllipseRowCache* cache) {
+    cache->rows = cache->stack;
+    cache->capacity = ELLIPSE_STACK_ROWS - 1;
+    cache->rx = -1;
+    cache->ry = -1;
+}
+
+// Rows for the radii, or NULL if they could not be allocated
+static const EllipseRow* cachedRows(EllipseRowCache* cache, int rx, int ry) {
+    if (rx == cache->rx && ry == cache->ry) {
+        return cache->rows;
+    }
+    if (ry > cache->capacity) {
+        EllipseRow* rows = malloc(sizeof(EllipseRow) * ((size_t)ry + 1));
+        if (!rows) {
+            return NULL;
+        }
+        if (cache->rows != cache->stack) {
+            free(cache->rows);
+        }
+        cache->rows = rows;
+        cache->capacity = ry;
+    }
+    walkEllipse(cache->rows, rx, ry);
+    cache->rx = rx;
+    cache->ry = ry;
+    return cache->rows;
+}
+
+static void freeRowCache(EllipseRowCache* cache) {
+    if (cache->rows != cache->stack) {
+        free(cache->rows);
+    }
+}
+
+static long drawEllipseCached(Framebuffer* fb, int xc, int yc, int rx, int ry, int filled,
+                              const Sector* sector, Color color, EllipseRowCache* cache) {
+    if (!validRadii(rx, ry) || !ellipseVisible(fb, xc, yc, rx, ry)) {
+        return 0;
+    }
+
+    const EllipseRow* rows = cachedRows(cache, rx, ry);
+    if (!rows) {
+        return 0;
+    }
+    return emitEllipse(fb, xc, yc, rows, ry, filled, sector, color);
+}
+
+static void drawOne(Framebuffer* fb, int xc, int yc, int rx, int ry, int filled,
+                    const Sector* sector, Color color) {
+    EllipseRow stack[ELLIPSE_STACK_ROWS];
+
+    if (!validRadii(rx, ry) || !ellipseVisible(fb, xc, yc, rx, ry)) {
+        return;
+    }
+
+    EllipseRow* rows = ellipseRows(stack, ry);
+    if (!rows) {
+        return;
+    }
+    walkEllipse(rows, rx, ry);
+    emitEllipse(fb, xc, yc, rows, ry, filled, sector, color);
+    if (rows != stack) {
+        free(rows);
+    }
+}
+
+void drawEllipse(Framebuffer* fb, int xc, int yc, int rx, int ry, Color color) {
+    drawOne(fb, xc, yc, rx, ry, 0, NULL, color);
+}
+
+void fillEllipse(Framebuffer* fb, int xc, int yc, int rx, int ry, Color color) {
+    drawOne(fb, xc, yc, rx, ry, 1, NULL, color);
+}
+
+void drawEllipseArc(Framebuffer* fb, int xc, int yc, int rx, int ry, double startDegrees,
+                    double sweepDegrees, Color color) {
+    Sector sector;
+
+    if (sweepDegrees <= 0.0) {
+        return;
+    }
+    initSector(&sector, startDegrees, sweepDegrees);
+    drawOne(fb, xc, yc, rx, ry, 0, &sector, color);
+}
+
+void fillEllipsePie(Framebuffer* fb, int xc, int yc, int rx, int ry, double startDegrees,
+                    double sweepDegrees, Color color) {
+    Sector sector;
+
+    if (sweepDegrees <= 0.0) {
+        return;
+    }
+    initSector(&sector, startDegrees, sweepDegrees);
+    drawOne(fb, xc, yc, rx, ry, 1, &sector, color);
+}
+
+void drawEllipseBatch(Framebuffer* fb, const Ellipse* ellipses, size_t count, EllipseMode mode,
+                      BatchStats* stats) {
+    double start = stats ? batchClock() : 0.0;
+    EllipseRowCache cache;
+    size_t pixels = 0;
+
+    initRowCache(&cache);
+    for (size_t i = 0; i < count; i++) {
+        const Ellipse* e = &ellipses[i];
+        pixels += drawEllipseCached(fb, e->xc, e->yc, e->rx, e->ry, mode == ELLIPSE_FILLED, NULL,
+                                    e->color, &cache);
+    }
+    freeRowCache(&cache);
+
+    if (stats) {
+        finishBatchPixels(stats, count, pixels, start);
+    }
+}
+
+void drawArcBatch(Framebuffer* fb, const EllipseArc* arcs, size_t count, EllipseMode mode,
+                  BatchStats* stats) {
+    double start = stats ? batchClock() : 0.0;
+    EllipseRowCache cache;
+    size_t pixels = 0;
+
+    initRowCache(&cache);
+    for (size_t i = 0; i < count; i++) {
+        const EllipseArc* a = &arcs[i];
+        Sector sector;
+
+        if (a->sweep > 0.0) {
+            initSector(&sector, a->start, a->sweep);
+            pixels += drawEllipseCached(fb, a->xc, a->yc, a->rx, a->ry, mode == ELLIPSE_FILLED,
+                                        &sector, a->color, &cache);
+        }
+    }
+    freeRowCache(&cache);
+
+    if (stats) {
+        finishBatchPixels(stats, count, pixels, start);
+    }
+}
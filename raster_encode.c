@@ -0,0 +1,505 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "raster_image.h"
+
+// In-memory QOI and PNG encoders.
+//
+// QOI is the fast one: a single pass over the pixels, with no entropy
+// coder. Line art and flat backgrounds come out as long runs. PNG
+// compresses better and is readable everywhere. Each row gets the PNG
+// filter with the smallest sum of absolute residuals. The filtered rows
+// are then deflated with LZ77 over a hash chain and the fixed Huffman
+// code, which needs no code tables in the stream. Both encoders write
+// into one buffer sized for their worst case, so nothing is reallocated
+// mid-image.
+
+// ---------------------------------------------------------------- QOI
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+
+#define QOI_HEADER_SIZE 14
+#define QOI_MAX_RUN 62
+
+static const unsigned char qoiEnd[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+static unsigned char* putBigEndian32(unsigned char* p, uint32_t value) {
+    p[0] = (unsigned char)(value >> 24);
+    p[1] = (unsigned char)(value >> 16);
+    p[2] = (unsigned char)(value >> 8);
+    p[3] = (unsigned char)value;
+    return p + 4;
+}
+
+static size_t encodeQoi(const Framebuffer* fb, unsigned char** data) {
+    size_t pixels = (size_t)fb->width * (size_t)fb->height;
+    if (pixels > (SIZE_MAX - QOI_HEADER_SIZE - sizeof(qoiEnd)) / 4) {
+        return 0;
+    }
+
+    // Every pixel costs at most an RGB op (4 bytes)
+    unsigned char* out = malloc(QOI_HEADER_SIZE + pixels * 4 + sizeof(qoiEnd));
+    if (!out) {
+        return 0;
+    }
+
+    unsigned char* p = out;
+    memcpy(p, "qoif", 4);
+    p = putBigEndian32(p + 4, (uint32_t)fb->width);
+    p = putBigEndian32(p, (uint32_t)fb->height);
+    *p++ = 3;       // RGB
+    *p++ = 0;       // sRGB with linear alpha
+
+    // Pixels are kept as 0xAARRGGBB. Alpha is always 255, so the zeroed
+    // index never matches by accident.
+    uint32_t index[64] = { 0 };
+    uint32_t previous = 0xFF000000u;
+    int run = 0;
+
+    for (int y = 0; y < fb->height; y++) {
+        const Pixel* row = fb->pixels + (long)y * fb->stride;
+
+        for (int x = 0; x < fb->width; x++) {
+            uint32_t px = 0xFF000000u | (uint32_t)row[x].r << 16 | (uint32_t)row[x].g << 8 | row[x].b;
+
+            if (px == previous) {
+                if (++run == QOI_MAX_RUN) {
+                    *p++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *p++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+
+            int r = row[x].r, g = row[x].g, b = row[x].b;
+            int slot = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+
+            if (index[slot] == px) {
+                *p++ = (unsigned char)(QOI_OP_INDEX | slot);
+            } else {
+                index[slot] = px;
+
+                signed char dr = (signed char)(r - (int)(previous >> 16 & 0xFF));
+                signed char dg = (signed char)(g - (int)(previous >> 8 & 0xFF));
+                signed char db = (signed char)(b - (int)(previous & 0xFF));
+                signed char drg = (signed char)(dr - dg);
+                signed char dbg = (signed char)(db - dg);
+
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *p++ = (unsigned char)(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                    *p++ = (unsigned char)(QOI_OP_LUMA | (dg + 32));
+                    *p++ = (unsigned char)((drg + 8) << 4 | (dbg + 8));
+                } else {
+                    *p++ = QOI_OP_RGB;
+                    *p++ = (unsigned char)r;
+                    *p++ = (unsigned char)g;
+                    *p++ = (unsigned char)b;
+                }
+            }
+            previous = px;
+        }
+    }
+    if (run > 0) {
+        *p++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+    }
+    memcpy(p, qoiEnd, sizeof(qoiEnd));
+    p += sizeof(qoiEnd);
+
+    *data = out;
+    return (size_t)(p - out);
+}
+
+// ---------------------------------------------------------------- PNG
+
+static uint32_t crcTable[256];
+static pthread_once_t crcTableOnce = PTHREAD_ONCE_INIT;
+
+static void buildCrcTable(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crcTable[n] = c;
+    }
+}
+
+static uint32_t updateCrc(uint32_t crc, const unsigned char* p, size_t length) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = crcTable[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t adler32(const unsigned char* p, size_t length) {
+    uint32_t a = 1, b = 0;
+
+    // 5552 bytes is the most that can be summed before b overflows
+    while (length > 0) {
+        size_t block = length < 5552 ? length : 5552;
+        length -= block;
+        while (block--) {
+            a += *p++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return b << 16 | a;
+}
+
+// Chunk around `length` data bytes already at p + 8; returns its end
+static unsigned char* finishChunk(unsigned char* p, const char* type, size_t length) {
+    putBigEndian32(p, (uint32_t)length);
+    memcpy(p + 4, type, 4);
+    uint32_t crc = updateCrc(0, p + 4, length + 4);
+    return putBigEndian32(p + 8 + length, crc);
+}
+
+static inline int paeth(int a, int b, int c) {
+    int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+    return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+}
+
+// Sum of the residuals read as signed bytes
+static unsigned long filterCost(const unsigned char* residuals, size_t bytes) {
+    unsigned long sum = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        sum += (unsigned)abs((signed char)residuals[i]);
+    }
+    return sum;
+}
+
+// Write one row, filtered, to `out` (filter byte first). Tries None, Sub,
+// Up and Paeth and keeps the one with the smallest residuals, the usual
+// heuristic; Average rarely wins on drawings. Each filter is its own
+// loop, so the compiler can vectorize Sub, Up and the costs.
+// `scratch` holds 3 rows.
+static void filterRow(const unsigned char* row, const unsigned char* above, size_t bytes,
+                      unsigned char* scratch, unsigned char* out) {
+    enum { NONE, SUB, UP, AVERAGE, PAETH };
+    unsigned char* sub = scratch;
+    unsigned char* up = scratch + bytes;
+    unsigned char* paethRow = scratch + 2 * bytes;
+    size_t lead = bytes < 3 ? bytes : 3;
+
+    memcpy(sub, row, lead);
+    for (size_t i = 3; i < bytes; i++) {
+        sub[i] = (unsigned char)(row[i] - row[i - 3]);
+    }
+
+    int best = NONE;
+    const unsigned char* bestRow = row;
+    unsigned long bestCost = filterCost(row, bytes);
+    unsigned long cost = filterCost(sub, bytes);
+    if (cost < bestCost) {
+        best = SUB, bestRow = sub, bestCost = cost;
+    }
+
+    if (above) {
+        for (size_t i = 0; i < bytes; i++) {
+            up[i] = (unsigned char)(row[i] - above[i]);
+        }
+        // Paeth predicts `above` in the first pixel, like Up
+        memcpy(paethRow, up, lead);
+        for (size_t i = 3; i < bytes; i++) {
+            paethRow[i] = (unsigned char)(row[i] - paeth(row[i - 3], above[i], above[i - 3]));
+        }
+
+        cost = filterCost(up, bytes);
+        if (cost < bestCost) {
+            best = UP, bestRow = up, bestCost = cost;
+        }
+        cost = filterCost(paethRow, bytes);
+        if (cost < bestCost) {
+            best = PAETH, bestRow = paethRow, bestCost = cost;
+        }
+    }
+
+    out[0] = (unsigned char)best;
+    memcpy(out + 1, bestRow, bytes);
+}
+
+// Deflate bit writer: bits go out least significant first
+typedef struct {
+    unsigned char* p;
+    uint64_t bits;
+    int count;
+} BitWriter;
+
+static inline void putBits(BitWriter* w, uint32_t value, int count) {
+    w->bits |= (uint64_t)value << w->count;
+    w->count += count;
+    while (w->count >= 8) {
+        *w->p++ = (unsigned char)w->bits;
+        w->bits >>= 8;
+        w->count -= 8;
+    }
+}
+
+#define DEFLATE_WINDOW 32768
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_MAX_CHAIN 32
+
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distanceBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distanceExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Fixed Huffman codes, bit-reversed for the LSB-first writer
+static uint16_t literalCode[288];
+static uint8_t literalBits[288];
+static uint16_t distanceCode[30];
+static uint8_t lengthSymbol[DEFLATE_MAX_MATCH + 1];
+static uint8_t distanceSymbolSmall[512];
+static pthread_once_t deflateTablesOnce = PTHREAD_ONCE_INIT;
+
+static uint16_t reverseBits(uint32_t code, int bits) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < bits; i++) {
+        reversed = reversed << 1 | (code >> i & 1);
+    }
+    return (uint16_t)reversed;
+}
+
+static void buildDeflateTables(void) {
+    for (int v = 0; v < 288; v++) {
+        if (v < 144) {
+            literalCode[v] = reverseBits(0x30 + v, 8), literalBits[v] = 8;
+        } else if (v < 256) {
+            literalCode[v] = reverseBits(0x190 + v - 144, 9), literalBits[v] = 9;
+        } else if (v < 280) {
+            literalCode[v] = reverseBits(v - 256, 7), literalBits[v] = 7;
+        } else {
+            literalCode[v] = reverseBits(0xC0 + v - 280, 8), literalBits[v] = 8;
+        }
+    }
+    for (int d = 0; d < 30; d++) {
+        distanceCode[d] = reverseBits(d, 5);
+    }
+    for (int s = 0; s < 29; s++) {
+        int end = s + 1 < 29 ? lengthBase[s + 1] : DEFLATE_MAX_MATCH + 1;
+        for (int length = lengthBase[s]; length < end; length++) {
+            lengthSymbol[length] = (uint8_t)s;
+        }
+    }
+    // Same split as zlib: exact up to 256, then by blocks of 128, which
+    // never straddle a code above 256
+    for (int s = 0; s < 30; s++) {
+        int end = s + 1 < 30 ? distanceBase[s + 1] : DEFLATE_WINDOW + 1;
+        for (int distance = distanceBase[s]; distance < end; distance++) {
+            if (distance <= 256) {
+                distanceSymbolSmall[distance - 1] = (uint8_t)s;
+            } else {
+                distanceSymbolSmall[256 + ((distance - 1) >> 7)] = (uint8_t)s;
+            }
+        }
+    }
+}
+
+static inline int distanceSymbol(int distance) {
+    return distance <= 256 ? distanceSymbolSmall[distance - 1]
+                           : distanceSymbolSmall[256 + ((distance - 1) >> 7)];
+}
+
+static inline void putLiteral(BitWriter* w, int value) {
+    putBits(w, literalCode[value], literalBits[value]);
+}
+
+static inline void putMatch(BitWriter* w, int length, int distance) {
+    int s = lengthSymbol[length];
+    putLiteral(w, 257 + s);
+    putBits(w, (uint32_t)(length - lengthBase[s]), lengthExtra[s]);
+
+    int d = distanceSymbol(distance);
+    putBits(w, distanceCode[d], 5);
+    putBits(w, (uint32_t)(distance - distanceBase[d]), distanceExtra[d]);
+}
+
+static inline uint32_t hash3(const unsigned char* p) {
+    uint32_t v = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16;
+    return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+// zlib stream of `in` as one fixed-Huffman block; returns its end, or NULL
+// if out of memory. `out` has room for the worst case, 9 bits per byte.
+static unsigned char* deflateFixed(const unsigned char* in, size_t length, unsigned char* out) {
+    // Positions are stored + 1 so that 0 means empty
+    uint32_t* head = calloc((size_t)1 << DEFLATE_HASH_BITS, sizeof(uint32_t));
+    uint32_t* chain = malloc(sizeof(uint32_t) * DEFLATE_WINDOW);
+    if (!head || !chain) {
+        free(head);
+        free(chain);
+        return NULL;
+    }
+
+    BitWriter w = { out, 0, 0 };
+    putBits(&w, 0x78, 8);       // CM 8, 32K window
+    putBits(&w, 0x01, 8);       // fastest level, no dictionary
+    putBits(&w, 1, 1);          // final block
+    putBits(&w, 1, 2);          // fixed Huffman
+
+    size_t pos = 0;
+    while (pos < length) {
+        int bestLength = 0;
+        int bestDistance = 0;
+
+        if (pos + DEFLATE_MIN_MATCH <= length) {
+            uint32_t h = hash3(in + pos);
+            uint32_t candidate = head[h];
+            int limit = length - pos < DEFLATE_MAX_MATCH ? (int)(length - pos) : DEFLATE_MAX_MATCH;
+
+            chain[pos & (DEFLATE_WINDOW - 1)] = candidate;
+            head[h] = (uint32_t)pos + 1;
+
+            for (int tries = DEFLATE_MAX_CHAIN; candidate && tries > 0; tries--) {
+                size_t match = candidate - 1;
+                if (pos - match > DEFLATE_WINDOW) {
+                    break;
+                }
+                if (in[match + bestLength] == in[pos + bestLength]) {
+                    int n = 0;
+                    while (n < limit && in[match + n] == in[pos + n]) {
+                        n++;
+                    }
+                    if (n > bestLength) {
+                        bestLength = n;
+                        bestDistance = (int)(pos - match);
+                        if (n == limit) {
+                            break;
+                        }
+                    }
+                }
+                candidate = chain[match & (DEFLATE_WINDOW - 1)];
+            }
+        }
+
+        if (bestLength >= DEFLATE_MIN_MATCH) {
+            putMatch(&w, bestLength, bestDistance);
+            // Index the positions the match covers, so later matches can
+            // start inside it
+            for (size_t end = pos + bestLength, p = pos + 1; p < end; p++) {
+                if (p + DEFLATE_MIN_MATCH <= length) {
+                    uint32_t h = hash3(in + p);
+                    chain[p & (DEFLATE_WINDOW - 1)] = head[h];
+                    head[h] = (uint32_t)p + 1;
+                }
+            }
+            pos += bestLength;
+        } else {
+            putLiteral(&w, in[pos]);
+            pos++;
+        }
+    }
+    putLiteral(&w, 256);        // end of block
+    putBits(&w, 0, 7);          // pad to a byte
+
+    uint32_t adler = adler32(in, length);
+    unsigned char* p = putBigEndian32(w.p, adler);
+
+    free(head);
+    free(chain);
+    return p;
+}
+
+static const unsigned char pngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+static size_t encodePng(const Framebuffer* fb, unsigned char** data) {
+    size_t rowBytes = sizeof(Pixel) * (size_t)fb->width;
+
+    // Chain positions are 32-bit
+    if ((uint64_t)(rowBytes + 1) * (uint64_t)fb->height > UINT32_MAX - DEFLATE_MAX_MATCH) {
+        return 0;
+    }
+    pthread_once(&crcTableOnce, buildCrcTable);
+    pthread_once(&deflateTablesOnce, buildDeflateTables);
+
+    size_t filteredBytes = (rowBytes + 1) * (size_t)fb->height;
+    size_t deflateBound = filteredBytes + filteredBytes / 8 + 16;
+    // Signature, IHDR, IDAT header and CRC, IEND
+    size_t capacity = sizeof(pngSignature) + 25 + 12 + deflateBound + 12;
+
+    unsigned char* filtered = malloc(filteredBytes);
+    unsigned char* scratch = malloc(rowBytes * 3);
+    unsigned char* out = malloc(capacity);
+    if (!filtered || !scratch || !out) {
+        free(filtered);
+        free(scratch);
+        free(out);
+        return 0;
+    }
+
+    for (int y = 0; y < fb->height; y++) {
+        const unsigned char* row = (const unsigned char*)(fb->pixels + (long)y * fb->stride);
+        const unsigned char* above = y > 0 ? row - sizeof(Pixel) * (size_t)fb->stride : NULL;
+        filterRow(row, above, rowBytes, scratch, filtered + (rowBytes + 1) * (size_t)y);
+    }
+
+    unsigned char* p = out;
+    memcpy(p, pngSignature, sizeof(pngSignature));
+    p += sizeof(pngSignature);
+
+    unsigned char* ihdr = p + 8;
+    putBigEndian32(ihdr, (uint32_t)fb->width);
+    putBigEndian32(ihdr + 4, (uint32_t)fb->height);
+    ihdr[8] = 8;        // bits per channel
+    ihdr[9] = 2;        // truecolor
+    ihdr[10] = 0;       // deflate
+    ihdr[11] = 0;       // adaptive filtering
+    ihdr[12] = 0;       // not interlaced
+    p = finishChunk(p, "IHDR", 13);
+
+    unsigned char* end = deflateFixed(filtered, filteredBytes, p + 8);
+    free(filtered);
+    free(scratch);
+    if (!end) {
+        free(out);
+        return 0;
+    }
+    p = finishChunk(p, "IDAT", (size_t)(end - (p + 8)));
+    p = finishChunk(p, "IEND", 0);
+
+    *data = out;
+    return (size_t)(p - out);
+}
+
+size_t encodeFramebuffer(const Framebuffer* fb, ImageFormat format, unsigned char** data) {
+    if (fb->format != PIXEL_RGB24 || fb->width <= 0 || fb->height <= 0) {
+        return 0;
+    }
+
+    switch (format) {
+    case IMAGE_QOI:
+        return encodeQoi(fb, data);
+    case IMAGE_PNG:
+        return encodePng(fb, data);
+    default:
+        return 0;
+    }
+}
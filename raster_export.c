@@ -0,0 +1,217 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "raster_export.h"
+#include "raster_pool.h"
+
+// A frame slot: a private copy of the pixels plus where they go
+typedef struct {
+    Pixel* pixels;
+    size_t capacity;        // pixels allocated
+    Framebuffer fb;
+    char* path;
+    ImageFormat format;
+} ExportFrame;
+
+struct ImageExporter {
+    int threadCount;
+    pthread_t* threads;
+
+    int slotCount;
+    ExportFrame* slots;
+
+    // Free slots form a stack and queued ones a FIFO ring, both of slot
+    // indices. Everything below is guarded by `lock`.
+    int* freeSlots;
+    int freeCount;
+    int* queue;
+    int queueHead;
+    int queueCount;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;        // a frame was queued, or shutdown
+    pthread_cond_t space;       // a slot was freed
+    pthread_cond_t idle;        // the last frame in flight was written
+    int inFlight;               // queued or being encoded
+    int failures;
+    int shutdown;
+};
+
+static void* exportWorker(void* arg) {
+    ImageExporter* exporter = arg;
+
+    pthread_mutex_lock(&exporter->lock);
+    for (;;) {
+        while (exporter->queueCount == 0 && !exporter->shutdown) {
+            pthread_cond_wait(&exporter->work, &exporter->lock);
+        }
+        if (exporter->queueCount == 0) {
+            break;
+        }
+
+        int slot = exporter->queue[exporter->queueHead];
+        exporter->queueHead = (exporter->queueHead + 1) % exporter->slotCount;
+        exporter->queueCount--;
+        pthread_mutex_unlock(&exporter->lock);
+
+        ExportFrame* frame = &exporter->slots[slot];
+        int ok = saveFramebuffer(&frame->fb, frame->path, frame->format);
+
+        pthread_mutex_lock(&exporter->lock);
+        free(frame->path);
+        frame->path = NULL;
+        exporter->failures += !ok;
+        exporter->freeSlots[exporter->freeCount++] = slot;
+        pthread_cond_signal(&exporter->space);
+        if (--exporter->inFlight == 0) {
+            pthread_cond_broadcast(&exporter->idle);
+        }
+    }
+    pthread_mutex_unlock(&exporter->lock);
+    return NULL;
+}
+
+ImageExporter* createImageExporter(int threads, int queueDepth) {
+    ImageExporter* exporter = calloc(1, sizeof(ImageExporter));
+    if (!exporter) {
+        return NULL;
+    }
+
+    exporter->threadCount = threads > 0 ? threads : cpuCount();
+    exporter->slotCount = exporter->threadCount + (queueDepth > 0 ? queueDepth : 1);
+    exporter->threads = malloc(sizeof(pthread_t) * (size_t)exporter->threadCount);
+    exporter->slots = calloc((size_t)exporter->slotCount, sizeof(ExportFrame));
+    exporter->freeSlots = malloc(sizeof(int) * (size_t)exporter->slotCount);
+    exporter->queue = malloc(sizeof(int) * (size_t)exporter->slotCount);
+    if (!exporter->threads || !exporter->slots || !exporter->freeSlots || !exporter->queue) {
+        free(exporter->threads);
+        free(exporter->slots);
+        free(exporter->freeSlots);
+        free(exporter->queue);
+        free(exporter);
+        return NULL;
+    }
+
+    for (int i = 0; i < exporter->slotCount; i++) {
+        exporter->freeSlots[i] = exporter->slotCount - 1 - i;
+    }
+    exporter->freeCount = exporter->slotCount;
+
+    pthread_mutex_init(&exporter->lock, NULL);
+    pthread_cond_init(&exporter->work, NULL);
+    pthread_cond_init(&exporter->space, NULL);
+    pthread_cond_init(&exporter->idle, NULL);
+
+    int started = 0;
+    while (started < exporter->threadCount &&
+           pthread_create(&exporter->threads[started], NULL, exportWorker, exporter) == 0) {
+        started++;
+    }
+    if (started == 0) {
+        exporter->threadCount = 0;
+        destroyImageExporter(exporter);
+        return NULL;
+    }
+    exporter->threadCount = started;
+    return exporter;
+}
+
+int exportFramebuffer(ImageExporter* exporter, const Framebuffer* fb, const char* path,
+                      ImageFormat format) {
+    if (fb->format != PIXEL_RGB24 || fb->width <= 0 || fb->height <= 0) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&exporter->lock);
+    while (exporter->freeCount == 0) {
+        pthread_cond_wait(&exporter->space, &exporter->lock);
+    }
+    int slot = exporter->freeSlots[--exporter->freeCount];
+    pthread_mutex_unlock(&exporter->lock);
+
+    // The slot is ours until it is queued, so the copy runs unlocked
+    ExportFrame* frame = &exporter->slots[slot];
+    size_t pixels = (size_t)fb->width * (size_t)fb->height;
+    size_t pathLength = strlen(path) + 1;
+    int ok = 1;
+
+    if (frame->capacity < pixels) {
+        Pixel* grown = realloc(frame->pixels, sizeof(Pixel) * pixels);
+        if (grown) {
+            frame->pixels = grown;
+            frame->capacity = pixels;
+        } else {
+            ok = 0;
+        }
+    }
+    frame->path = ok ? malloc(pathLength) : NULL;
+    if (!frame->path) {
+        pthread_mutex_lock(&exporter->lock);
+        exporter->freeSlots[exporter->freeCount++] = slot;
+        pthread_cond_signal(&exporter->space);
+        pthread_mutex_unlock(&exporter->lock);
+        return 0;
+    }
+
+    memcpy(frame->path, path, pathLength);
+    frame->format = format;
+    initFramebuffer(&frame->fb, frame->pixels, fb->width, fb->height);
+    if (fb->stride == fb->width) {
+        memcpy(frame->pixels, fb->pixels, sizeof(Pixel) * pixels);
+    } else {
+        for (int y = 0; y < fb->height; y++) {
+            memcpy(frame->pixels + (long)y * fb->width, fb->pixels + (long)y * fb->stride,
+                   sizeof(Pixel) * (size_t)fb->width);
+        }
+    }
+
+    pthread_mutex_lock(&exporter->lock);
+    exporter->queue[(exporter->queueHead + exporter->queueCount) % exporter->slotCount] = slot;
+    exporter->queueCount++;
+    exporter->inFlight++;
+    pthread_cond_signal(&exporter->work);
+    pthread_mutex_unlock(&exporter->lock);
+    return 1;
+}
+
+int finishImageExports(ImageExporter* exporter) {
+    pthread_mutex_lock(&exporter->lock);
+    while (exporter->inFlight > 0) {
+        pthread_cond_wait(&exporter->idle, &exporter->lock);
+    }
+    int failures = exporter->failures;
+    exporter->failures = 0;
+    pthread_mutex_unlock(&exporter->lock);
+    return failures;
+}
+
+void destroyImageExporter(ImageExporter* exporter) {
+    if (!exporter) {
+        return;
+    }
+
+    // Workers drain the queue before they see the shutdown
+    pthread_mutex_lock(&exporter->lock);
+    exporter->shutdown = 1;
+    pthread_cond_broadcast(&exporter->work);
+    pthread_mutex_unlock(&exporter->lock);
+    for (int i = 0; i < exporter->threadCount; i++) {
+        pthread_join(exporter->threads[i], NULL);
+    }
+
+    for (int i = 0; i < exporter->slotCount; i++) {
+        free(exporter->slots[i].pixels);
+        free(exporter->slots[i].path);
+    }
+    pthread_mutex_destroy(&exporter->lock);
+    pthread_cond_destroy(&exporter->work);
+    pthread_cond_destroy(&exporter->space);
+    pthread_cond_destroy(&exporter->idle);
+    free(exporter->threads);
+    free(exporter->slots);
+    free(exporter->freeSlots);
+    free(exporter->queue);
+    free(exporter);
+}
@@ -0,0 +1,37 @@
+#ifndef RASTER_EXPORT_H
+#define RASTER_EXPORT_H
+
+#include "raster_image.h"
+
+// Background image export.
+//
+// exportFramebuffer copies a finished frame into one of the exporter's
+// frame slots and returns. Encoder threads then encode and write it in
+// the background. While they do, the caller can clear and draw the next
+// frame. There are a fixed number of slots, so the queue is bounded: when
+// every slot is full, exportFramebuffer waits for an encoder to finish a
+// frame instead of buffering without limit. The slot buffers are reused
+// from frame to frame.
+
+typedef struct ImageExporter ImageExporter;
+
+// Start `threads` encoder threads (<= 0: one per CPU) with room for
+// `queueDepth` frames waiting on top of the ones being encoded (at least
+// 1). Returns NULL on failure.
+ImageExporter* createImageExporter(int threads, int queueDepth);
+
+// Queue a copy of the RGB24 framebuffer `fb` to be written to `path`.
+// Blocks while the queue is full. Returns 0 without queueing anything if
+// `fb` is not RGB24 or the copy cannot be allocated; errors while
+// encoding or writing are counted by finishImageExports.
+int exportFramebuffer(ImageExporter* exporter, const Framebuffer* fb, const char* path,
+                      ImageFormat format);
+
+// Wait until every queued frame is written. Returns the number of frames
+// that could not be written since the previous call.
+int finishImageExports(ImageExporter* exporter);
+
+// Finish the queued frames, then stop the threads
+void destroyImageExporter(ImageExporter* exporter);
+
+#endif
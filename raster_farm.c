@@ -0,0 +1,127 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "raster_farm.h"
+#include "raster_internal.h"
+#include "raster_pool.h"
+
+// Longest frame file name
+#define FARM_PATH_MAX 4096
+
+struct FrameFarm {
+    ThreadPool* pool;
+    Framebuffer** frames;       // one per pool worker
+    int threads;
+};
+
+// State of one renderFrames call, shared by all tasks
+typedef struct {
+    FrameFarm* farm;
+    FrameFunction draw;
+    void* arg;
+    const char* path;
+    ImageFormat format;
+    pthread_mutex_t lock;
+    int failed;
+} FarmRun;
+
+FrameFarm* createFrameFarm(int threads, int width, int height) {
+    FrameFarm* farm = calloc(1, sizeof(FrameFarm));
+    if (!farm) {
+        return NULL;
+    }
+
+    farm->pool = createThreadPool(threads);
+    if (farm->pool) {
+        farm->threads = threadPoolSize(farm->pool);
+        farm->frames = calloc((size_t)farm->threads, sizeof(Framebuffer*));
+    }
+    if (!farm->frames) {
+        destroyFrameFarm(farm);
+        return NULL;
+    }
+
+    for (int i = 0; i < farm->threads; i++) {
+        farm->frames[i] = createFramebuffer(width, height, PIXEL_RGB24);
+        if (!farm->frames[i]) {
+            destroyFrameFarm(farm);
+            return NULL;
+        }
+    }
+    return farm;
+}
+
+void destroyFrameFarm(FrameFarm* farm) {
+    if (!farm) {
+        return;
+    }
+    destroyThreadPool(farm->pool);
+    if (farm->frames) {
+        for (int i = 0; i < farm->threads; i++) {
+            destroyFramebuffer(farm->frames[i]);
+        }
+    }
+    free(farm->frames);
+    free(farm);
+}
+
+int frameFarmThreads(const FrameFarm* farm) {
+    return farm->threads;
+}
+
+int frameFilePath(char* buffer, size_t size, const char* path, int frame) {
+    const char* slash = strrchr(path, '/');
+    const char* dot = strrchr(path, '.');
+    if (!dot || (slash && dot < slash)) {
+        dot = path + strlen(path);
+    }
+
+    int length = snprintf(buffer, size, "%.*s%06d%s", (int)(dot - path), path, frame, dot);
+    return length >= 0 && (size_t)length < size;
+}
+
+// Draw one frame and write it from the same thread. Every core already
+// draws, so the encoder runs where the pixels are still in cache instead
+// of behind a copy to separate encoder threads.
+static void renderFrame(int frame, int worker, void* arg) {
+    FarmRun* run = arg;
+    Framebuffer* fb = run->farm->frames[worker];
+    char path[FARM_PATH_MAX];
+
+    run->draw(fb, frame, run->arg);
+    if (!frameFilePath(path, sizeof(path), run->path, frame) ||
+        !saveFramebuffer(fb, path, run->format)) {
+        pthread_mutex_lock(&run->lock);
+        run->failed++;
+        pthread_mutex_unlock(&run->lock);
+    }
+}
+
+int renderFrames(FrameFarm* farm, int count, FrameFunction draw, void* arg, const char* path,
+                 ImageFormat format, FarmStats* stats) {
+    double start = stats ? batchClock() : 0.0;
+    FarmRun run;
+
+    run.farm = farm;
+    run.draw = draw;
+    run.arg = arg;
+    run.path = path;
+    run.format = format;
+    run.failed = 0;
+    pthread_mutex_init(&run.lock, NULL);
+
+    threadPoolRun(farm->pool, count, renderFrame, &run);
+    int failed = run.failed;
+    pthread_mutex_destroy(&run.lock);
+
+    if (stats) {
+        stats->frames = count > 0 ? (size_t)count : 0;
+        stats->failed = (size_t)failed;
+        stats->seconds = batchClock() - start;
+        stats->framesPerSecond = stats->seconds > 0.0 ? stats->frames / stats->seconds : 0.0;
+    }
+    return failed;
+}
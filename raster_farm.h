@@ -0,0 +1,51 @@
+#ifndef RASTER_FARM_H
+#define RASTER_FARM_H
+
+#include "raster_image.h"
+
+// Render farm: many independent frames (an animation, a parameter sweep)
+// drawn across all cores and written as image files.
+//
+// A FrameFarm keeps a thread pool and one framebuffer per worker thread,
+// allocated once and reused for every frame that thread draws, so a run
+// of any length allocates no frame memory. Each worker writes a frame as
+// soon as it is drawn and moves on to the next one, so finished frames
+// stream to disk while the others are drawn, and memory stays at one
+// framebuffer per thread however many frames there are.
+
+typedef struct FrameFarm FrameFarm;
+
+// Draw frame number `frame` into `fb`. Called from several threads at once,
+// for different frames, so it must not write shared state. `fb` still
+// holds whatever frame the thread drew last: clear it first.
+typedef void (*FrameFunction)(Framebuffer* fb, int frame, void* arg);
+
+typedef struct {
+    size_t frames;          // frames drawn
+    size_t failed;          // frames that could not be written
+    double seconds;
+    double framesPerSecond;
+} FarmStats;
+
+// Farm for width x height RGB24 frames on `threads` threads (<= 0: one
+// per CPU). Returns NULL on failure.
+FrameFarm* createFrameFarm(int threads, int width, int height);
+
+void destroyFrameFarm(FrameFarm* farm);
+
+int frameFarmThreads(const FrameFarm* farm);
+
+// Write the name of frame `frame` into `buffer`: `path` with the frame
+// number, zero-padded to 6 digits, inserted before its extension
+// ("out/fan.png", 42 -> "out/fan000042.png"). Returns 0 if it does not fit.
+int frameFilePath(char* buffer, size_t size, const char* path, int frame);
+
+// Draw frames 0 to count - 1 with `draw` and write each one to its
+// frameFilePath in `format` (the compressed formats are encoded on the
+// drawing thread). Frames are drawn in no particular order. Returns once
+// every file is written, with the number of frames that failed (0 on
+// success). `stats` may be NULL.
+int renderFrames(FrameFarm* farm, int count, FrameFunction draw, void* arg, const char* path,
+                 ImageFormat format, FarmStats* stats);
+
+#endif
@@ -0,0 +1,291 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "raster.h"
+#include "raster_internal.h"
+
+// Framebuffer storage and the format-generic pixel paths.
+//
+// The line kernels are written against RGB24 pixel pointers. Framebuffers
+// in the other formats reach the same pixel positions through a pixel
+// index (y * stride + x), which every format can turn into a byte or bit
+// address, so the stepping logic is shared and only the final store
+// differs. Each store loop below is instantiated once per format with a
+// constant format argument, the same trick the kernels use for tracing.
+
+// Row alignment of framebuffers from createFramebuffer, in bytes
+#define FRAMEBUFFER_ALIGNMENT 64
+
+// Pixels per FRAMEBUFFER_ALIGNMENT-aligned block of each format. RGB24 rows
+// of 64 pixels are 192 bytes, the first multiple of both 3 and 64.
+static const int alignmentPixels[] = { 64, 16, 64, 512 };
+
+void initFramebuffer(Framebuffer* fb, Pixel* pixels, int width, int height) {
+    initFramebufferFormat(fb, pixels, width, height, width, PIXEL_RGB24);
+}
+
+void initFramebufferFormat(Framebuffer* fb, void* pixels, int width, int height, int stride,
+                           PixelFormat format) {
+    fb->pixels = pixels;
+    fb->width = width;
+    fb->height = height;
+    fb->stride = stride;
+    fb->format = format;
+}
+
+static size_t rowBytesFor(int stride, PixelFormat format) {
+    switch (format) {
+    case PIXEL_RGBA32:
+        return (size_t)stride * 4;
+    case PIXEL_INDEXED8:
+        return (size_t)stride;
+    case PIXEL_MASK1:
+        return (size_t)stride / 8;
+    case PIXEL_RGB24:
+    default:
+        return (size_t)stride * sizeof(Pixel);
+    }
+}
+
+size_t framebufferRowBytes(const Framebuffer* fb) {
+    return rowBytesFor(fb->stride, fb->format);
+}
+
+Framebuffer* createFramebuffer(int width, int height, PixelFormat format) {
+    if (width <= 0 || height <= 0 || (unsigned)format > PIXEL_MASK1) {
+        return NULL;
+    }
+
+    int align = alignmentPixels[format];
+    if (width > INT_MAX - align) {
+        return NULL;
+    }
+
+    int stride = (width + align - 1) / align * align;
+    size_t rowBytes = rowBytesFor(stride, format);
+
+    // Pixel indices (y * stride + x) must fit a long
+    if ((size_t)height > SIZE_MAX / rowBytes || (long)height > LONG_MAX / stride) {
+        return NULL;
+    }
+
+    Framebuffer* fb = malloc(sizeof(Framebuffer));
+    void* pixels = NULL;
+    if (!fb || posix_memalign(&pixels, FRAMEBUFFER_ALIGNMENT, rowBytes * (size_t)height) != 0) {
+        free(fb);
+        return NULL;
+    }
+
+    initFramebufferFormat(fb, pixels, width, height, stride, format);
+    return fb;
+}
+
+void destroyFramebuffer(Framebuffer* fb) {
+    if (fb) {
+        free(fb->pixels);
+        free(fb);
+    }
+}
+
+static inline unsigned char* rowAt(const Framebuffer* fb, int y) {
+    return (unsigned char*)fb->pixels + (long)y * (long)framebufferRowBytes(fb);
+}
+
+// Fill `bytes` bytes with copies of the first `unit` bytes, which the caller
+// has written. The filled prefix doubles on every copy, so a row takes a
+// few large memcpy calls, which the C library runs with its widest vector
+// stores.
+static void repeatPrefix(unsigned char* p, size_t unit, size_t bytes) {
+    for (size_t filled = unit; filled < bytes; filled *= 2) {
+        memcpy(p + filled, p, filled < bytes - filled ? filled : bytes - filled);
+    }
+}
+
+// Set or clear bits [x0, x1] of a 1-bit row
+static void fillBits(unsigned char* row, int x0, int x1, int set) {
+    int first = x0 >> 3;
+    int last = x1 >> 3;
+    unsigned char head = (unsigned char)(0xFF >> (x0 & 7));
+    unsigned char tail = (unsigned char)(0xFF << (7 - (x1 & 7)));
+
+    if (first == last) {
+        head &= tail;
+        row[first] = set ? row[first] | head : row[first] & ~head;
+        return;
+    }
+    row[first] = set ? row[first] | head : row[first] & ~head;
+    memset(row + first + 1, set ? 0xFF : 0x00, (size_t)(last - first - 1));
+    row[last] = set ? row[last] | tail : row[last] & ~tail;
+}
+
+// The bytes `color` is stored as: 3 for RGB24, 4 for RGBA32, 1 otherwise
+static int encodeColor(PixelFormat format, Color color, unsigned char* bytes) {
+    switch (format) {
+    case PIXEL_RGBA32:
+        bytes[0] = COLOR_R(color);
+        bytes[1] = COLOR_G(color);
+        bytes[2] = COLOR_B(color);
+        bytes[3] = 0xFF;
+        return 4;
+    case PIXEL_INDEXED8:
+        bytes[0] = (unsigned char)color;
+        return 1;
+    case PIXEL_MASK1:
+        bytes[0] = color != COLOR_BLACK;
+        return 1;
+    case PIXEL_RGB24:
+    default:
+        bytes[0] = COLOR_R(color);
+        bytes[1] = COLOR_G(color);
+        bytes[2] = COLOR_B(color);
+        return 3;
+    }
+}
+
+void fillSpanFormat(const Framebuffer* fb, int x0, int x1, int y, Color color) {
+    unsigned char* row = rowAt(fb, y);
+    unsigned char value[4];
+    int size = encodeColor(fb->format, color, value);
+    size_t count = (size_t)(x1 - x0 + 1);
+
+    switch (fb->format) {
+    case PIXEL_MASK1:
+        fillBits(row, x0, x1, value[0]);
+        break;
+    case PIXEL_INDEXED8:
+        memset(row + x0, value[0], count);
+        break;
+    default:
+        memcpy(row + (size_t)x0 * size, value, (size_t)size);
+        repeatPrefix(row + (size_t)x0 * size, (size_t)size, count * size);
+        break;
+    }
+}
+
+void clearFramebuffer(Framebuffer* fb, Color color) {
+    if (fb->width <= 0 || fb->height <= 0) {
+        return;
+    }
+
+    unsigned char value[4];
+    int size = encodeColor(fb->format, color, value);
+
+    if (fb->format == PIXEL_MASK1) {
+        for (int y = 0; y < fb->height; y++) {
+            fillBits(rowAt(fb, y), 0, fb->width - 1, value[0]);
+        }
+        return;
+    }
+
+    // Fill the first row, then copy it down. Only `width` pixels of each
+    // row are touched, since the padding up to the stride may belong to
+    // another view of the same storage.
+    unsigned char* first = rowAt(fb, 0);
+    size_t used = rowBytesFor(fb->width, fb->format);
+
+    if (size == 1 || (size == 3 && value[0] == value[1] && value[1] == value[2])) {
+        memset(first, value[0], used);
+    } else {
+        memcpy(first, value, (size_t)size);
+        repeatPrefix(first, (size_t)size, used);
+    }
+    for (int y = 1; y < fb->height; y++) {
+        memcpy(rowAt(fb, y), first, used);
+    }
+}
+
+// Store one encoded pixel at pixel index `index`
+static inline void storeIndex(unsigned char* base, long index, const unsigned char* value,
+                              PixelFormat format) {
+    switch (format) {
+    case PIXEL_RGBA32:
+        memcpy(base + index * 4, value, 4);
+        break;
+    case PIXEL_INDEXED8:
+        base[index] = value[0];
+        break;
+    case PIXEL_MASK1: {
+        unsigned char bit = (unsigned char)(0x80 >> (index & 7));
+        base[index >> 3] = value[0] ? base[index >> 3] | bit : base[index >> 3] & ~bit;
+        break;
+    }
+    case PIXEL_RGB24:
+    default:
+        memcpy(base + index * 3, value, 3);
+        break;
+    }
+}
+
+void setPixel(Framebuffer* fb, int x, int y, Color color) {
+    if (!insideFramebuffer(fb, x, y)) {
+        return;
+    }
+    if (fb->format == PIXEL_RGB24) {
+        writePixel(pixelAt(fb, x, y), color);
+        return;
+    }
+
+    unsigned char value[4];
+    encodeColor(fb->format, color, value);
+    storeIndex((unsigned char*)fb->pixels, (long)y * fb->stride + x, value, fb->format);
+}
+
+// stepLineCursor on pixel indices; `format` is a constant at every call
+static inline void stepIndices(const Framebuffer* fb, const LineCursor* cursor, int count,
+                               const unsigned char* value, PixelFormat format) {
+    // Locals, because the byte stores may alias *cursor
+    unsigned char* base = (unsigned char*)fb->pixels;
+    long index = cursor->pixel;
+    int64_t remainder = cursor->remainder;
+    int64_t twoMajor = cursor->twoMajor;
+    int64_t twoMinor = cursor->twoMinor;
+    long majorStep = cursor->majorStep;
+    long minorStep = cursor->minorStep;
+
+    for (int i = count; ; ) {
+        storeIndex(base, index, value, format);
+        if (--i == 0) {
+            break;
+        }
+
+        index += majorStep;
+        remainder += twoMinor;
+        if (remainder >= twoMajor) {
+            remainder -= twoMajor;
+            index += minorStep;
+        }
+    }
+}
+
+void stepLineCursorFormat(const Framebuffer* fb, const LineCursor* cursor, int count, Color color) {
+    unsigned char value[4];
+
+    encodeColor(fb->format, color, value);
+    switch (fb->format) {
+    case PIXEL_RGBA32:
+        stepIndices(fb, cursor, count, value, PIXEL_RGBA32);
+        break;
+    case PIXEL_INDEXED8:
+        stepIndices(fb, cursor, count, value, PIXEL_INDEXED8);
+        break;
+    case PIXEL_MASK1:
+        stepIndices(fb, cursor, count, value, PIXEL_MASK1);
+        break;
+    case PIXEL_RGB24:
+    default:
+        stepLineCursor(fb, cursor, count, color);
+        break;
+    }
+}
+
+void fillColumnFormat(const Framebuffer* fb, int x, int y0, int y1, Color color) {
+    unsigned char value[4];
+    unsigned char* base = (unsigned char*)fb->pixels;
+
+    encodeColor(fb->format, color, value);
+    for (long index = (long)y0 * fb->stride + x; y0 <= y1; y0++, index += fb->stride) {
+        storeIndex(base, index, value, fb->format);
+    }
+}
@@ -0,0 +1,195 @@
+#define _POSIX_C_SOURCE 200112L
+#define _FILE_OFFSET_BITS 64
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "raster_image.h"
+
+// Gather buffer for framebuffers whose rows are not contiguous
+#define IMAGE_CHUNK_BYTES (1 << 20)
+
+// Longest header either format produces
+#define IMAGE_HEADER_MAX 96
+
+struct MappedImage {
+    Framebuffer fb;
+    void* map;
+    size_t size;
+    int fd;
+};
+
+// Header for a width x height image; returns its length
+static int formatHeader(char* header, int width, int height, ImageFormat format) {
+    if (format == IMAGE_PAM) {
+        return snprintf(header, IMAGE_HEADER_MAX,
+                        "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 3\nMAXVAL 255\nTUPLTYPE RGB\nENDHDR\n",
+                        width, height);
+    }
+    return snprintf(header, IMAGE_HEADER_MAX, "P6\n%d %d\n255\n", width, height);
+}
+
+ImageFormat imageFormatForPath(const char* path) {
+    const char* dot = strrchr(path, '.');
+
+    if (dot && strcmp(dot, ".pam") == 0) {
+        return IMAGE_PAM;
+    }
+    if (dot && strcmp(dot, ".qoi") == 0) {
+        return IMAGE_QOI;
+    }
+    if (dot && strcmp(dot, ".png") == 0) {
+        return IMAGE_PNG;
+    }
+    return IMAGE_PPM;
+}
+
+static int writeEncoded(const Framebuffer* fb, FILE* out, ImageFormat format) {
+    unsigned char* data;
+    size_t size = encodeFramebuffer(fb, format, &data);
+    if (size == 0) {
+        return 0;
+    }
+
+    int ok = fwrite(data, 1, size, out) == size;
+    free(data);
+    return ok;
+}
+
+int writeFramebuffer(const Framebuffer* fb, FILE* out, ImageFormat format) {
+    if (fb->format != PIXEL_RGB24) {
+        return 0;
+    }
+    if (format == IMAGE_QOI || format == IMAGE_PNG) {
+        return writeEncoded(fb, out, format);
+    }
+
+    char header[IMAGE_HEADER_MAX];
+    int headerLength = formatHeader(header, fb->width, fb->height, format);
+    size_t rowBytes = sizeof(Pixel) * (size_t)fb->width;
+
+    if (fwrite(header, 1, (size_t)headerLength, out) != (size_t)headerLength) {
+        return 0;
+    }
+    if (fb->width <= 0 || fb->height <= 0) {
+        return 1;
+    }
+
+    // Contiguous rows: the whole image in one call
+    if (fb->stride == fb->width) {
+        size_t bytes = rowBytes * (size_t)fb->height;
+        return fwrite(fb->pixels, 1, bytes, out) == bytes;
+    }
+
+    // Otherwise copy as many rows as fit into one chunk per write, so a
+    // narrow view of a wide canvas still costs few calls. Rows longer than
+    // a chunk are written straight from the framebuffer.
+    int rowsPerChunk = rowBytes < IMAGE_CHUNK_BYTES ? (int)(IMAGE_CHUNK_BYTES / rowBytes) : 1;
+    unsigned char* chunk = rowsPerChunk > 1 ? malloc(rowBytes * (size_t)rowsPerChunk) : NULL;
+
+    if (!chunk) {
+        for (int y = 0; y < fb->height; y++) {
+            if (fwrite(fb->pixels + (long)y * fb->stride, 1, rowBytes, out) != rowBytes) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    int ok = 1;
+    for (int y = 0; y < fb->height && ok; y += rowsPerChunk) {
+        int rows = fb->height - y < rowsPerChunk ? fb->height - y : rowsPerChunk;
+
+        for (int i = 0; i < rows; i++) {
+            memcpy(chunk + rowBytes * (size_t)i, fb->pixels + (long)(y + i) * fb->stride, rowBytes);
+        }
+        ok = fwrite(chunk, 1, rowBytes * (size_t)rows, out) == rowBytes * (size_t)rows;
+    }
+    free(chunk);
+    return ok;
+}
+
+int saveFramebuffer(const Framebuffer* fb, const char* path, ImageFormat format) {
+    FILE* out = fopen(path, "wb");
+    if (!out) {
+        return 0;
+    }
+
+    int ok = writeFramebuffer(fb, out, format);
+    if (fclose(out) != 0) {
+        ok = 0;
+    }
+    return ok;
+}
+
+MappedImage* createMappedImage(const char* path, int width, int height, ImageFormat format) {
+    char header[IMAGE_HEADER_MAX];
+
+    if ((format != IMAGE_PPM && format != IMAGE_PAM) || width <= 0 || height <= 0 ||
+        (uint64_t)width * (uint64_t)height > (SIZE_MAX - IMAGE_HEADER_MAX) / sizeof(Pixel)) {
+        return NULL;
+    }
+
+    int headerLength = formatHeader(header, width, height, format);
+    size_t size = (size_t)headerLength + sizeof(Pixel) * (size_t)width * (size_t)height;
+
+    MappedImage* image = malloc(sizeof(MappedImage));
+    if (!image) {
+        return NULL;
+    }
+
+    // Create the file if it is new, so a failure below knows whether to
+    // remove it; an existing one is truncated instead
+    int created = 1;
+    image->fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (image->fd < 0 && errno == EEXIST) {
+        created = 0;
+        image->fd = open(path, O_RDWR | O_TRUNC);
+    }
+    if (image->fd < 0) {
+        free(image);
+        return NULL;
+    }
+
+    // The file grows zero-filled (black pixels), usually without using any
+    // disk until rows are drawn
+    image->map = MAP_FAILED;
+    if (ftruncate(image->fd, (off_t)size) == 0) {
+        image->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, image->fd, 0);
+    }
+    if (image->map == MAP_FAILED) {
+        // Do not leave an empty or half-sized image behind
+        close(image->fd);
+        if (created) {
+            unlink(path);
+        }
+        free(image);
+        return NULL;
+    }
+
+    image->size = size;
+    memcpy(image->map, header, (size_t)headerLength);
+    initFramebuffer(&image->fb, (Pixel*)((unsigned char*)image->map + headerLength), width, height);
+    return image;
+}
+
+Framebuffer* mappedFramebuffer(MappedImage* image) {
+    return &image->fb;
+}
+
+int syncMappedImage(MappedImage* image) {
+    return msync(image->map, image->size, MS_SYNC) == 0;
+}
+
+void closeMappedImage(MappedImage* image) {
+    if (!image) {
+        return;
+    }
+    munmap(image->map, image->size);
+    close(image->fd);
+    free(image);
+}
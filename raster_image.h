@@ -0,0 +1,63 @@
+#ifndef RASTER_IMAGE_H
+#define RASTER_IMAGE_H
+
+#include <stdio.h>
+#include "raster.h"
+
+// Image output for framebuffers.
+//
+// Pixel is laid out exactly as the binary PPM and RGB PAM formats store
+// it, so writing an image is the header plus the pixel rows as they are:
+// a single fwrite when the rows are contiguous, otherwise rows gathered
+// into large chunks. A MappedImage goes one step further and puts the
+// framebuffer inside a memory-mapped image file, so drawing is saving and
+// nothing is copied at all.
+//
+// QOI and PNG are compressed (raster_encode.c). The image is encoded in
+// memory and then written with one fwrite. To keep encoding off the
+// drawing thread, queue frames on an ImageExporter (raster_export.h).
+
+typedef enum {
+    IMAGE_PPM,      // binary PPM (P6)
+    IMAGE_PAM,      // PAM (P7) with TUPLTYPE RGB
+    IMAGE_QOI,      // QOI, RGB channels
+    IMAGE_PNG       // 8-bit RGB PNG
+} ImageFormat;
+
+// Format named by the extension of `path` (.pam, .qoi, .png); PPM otherwise
+ImageFormat imageFormatForPath(const char* path);
+
+// Encode `fb` as a QOI or PNG file in memory. On success *data is a new
+// block the caller frees and the file size is returned; returns 0 for
+// other formats, framebuffers that are not RGB24, or out of memory.
+size_t encodeFramebuffer(const Framebuffer* fb, ImageFormat format, unsigned char** data);
+
+// Write the RGB24 framebuffer `fb` to `out`; returns 0 on a write error or
+// if `fb` is in another pixel format
+int writeFramebuffer(const Framebuffer* fb, FILE* out, ImageFormat format);
+
+// Write `fb` to a new file at `path`; returns 0 if it could not be written
+int saveFramebuffer(const Framebuffer* fb, const char* path, ImageFormat format);
+
+typedef struct MappedImage MappedImage;
+
+// Create (or truncate) the image file at `path`, sized for a width x height
+// image, and map it. The file holds a valid image from the start; the
+// pixels are whatever the returned framebuffer is drawn with, and are
+// initially black. Only PPM and PAM can be mapped. Returns NULL for the
+// compressed formats or if the file cannot be created or mapped. A file
+// this call created is then removed again; an existing file is left
+// truncated.
+MappedImage* createMappedImage(const char* path, int width, int height, ImageFormat format);
+
+// Framebuffer whose pixels are the mapped file's pixel data
+Framebuffer* mappedFramebuffer(MappedImage* image);
+
+// Flush the pixels drawn so far to the file; returns 0 on failure
+int syncMappedImage(MappedImage* image);
+
+// Unmap and close. Pixels drawn before this call end up in the file
+// without a sync; sync first to find out whether they made it to disk.
+void closeMappedImage(MappedImage* image);
+
+#endif
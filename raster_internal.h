@@ -0,0 +1,269 @@
+#ifndef RASTER_INTERNAL_H
+#define RASTER_INTERNAL_H
+
+#include <string.h>
+#include "raster.h"
+
+// Longest line the 32.32 DDA rasterizes exactly. The start bias (2^-32)
+// plus the truncation of each increment must stay below half a step of the
+// minor axis, 1/(2*steps), or a pixel could round the other way.
+#define FIXED_DDA_MAX_STEPS 46340
+
+// Start value of the 32.32 minor-axis accumulator: just under 0.5, so the
+// integer part rounds to nearest with ties toward the start point
+#define FIXED_DDA_BIAS 0x7FFFFFFFu
+
+// Pixel-level helpers shared by the rasterizer translation units.
+// None of these bounds-check; callers must have clipped already.
+// pixelAt, writePixel and fillPixels address RGB24 pixels only; kernels
+// using them send other formats down the generic paths in
+// raster_framebuffer.c.
+
+static inline Pixel* pixelAt(const Framebuffer* fb, int x, int y) {
+    return fb->pixels + (long)y * fb->stride + x;
+}
+
+static inline void writePixel(Pixel* p, Color color) {
+    p->r = COLOR_R(color);
+    p->g = COLOR_G(color);
+    p->b = COLOR_B(color);
+}
+
+static inline int insideFramebuffer(const Framebuffer* fb, int x, int y) {
+    return (unsigned)x < (unsigned)fb->width && (unsigned)y < (unsigned)fb->height;
+}
+
+// Whether a line's endpoints are all within LINE_MAX_COORD; the kernels
+// draw nothing for lines that are not
+static inline int lineInRange(int x1, int y1, int x2, int y2) {
+    unsigned limit = 2u * LINE_MAX_COORD;
+    return (unsigned)x1 + LINE_MAX_COORD <= limit && (unsigned)y1 + LINE_MAX_COORD <= limit &&
+           (unsigned)x2 + LINE_MAX_COORD <= limit && (unsigned)y2 + LINE_MAX_COORD <= limit;
+}
+
+static inline int insideClipRect(const ClipRect* clip, int x, int y) {
+    return x >= clip->left && x <= clip->right && y >= clip->top && y <= clip->bottom;
+}
+
+// Fill `count` pixels from p. Short runs are stored directly, gray runs
+// are a plain memset, and other colors are written four pixels (12 bytes)
+// per copy.
+static inline void fillPixels(Pixel* pixels, int count, Color color) {
+    unsigned char* p = (unsigned char*)pixels;
+    unsigned char r = COLOR_R(color), g = COLOR_G(color), b = COLOR_B(color);
+
+    if (count <= 4) {
+        for (; count > 0; count--, p += 3) {
+            p[0] = r;
+            p[1] = g;
+            p[2] = b;
+        }
+        return;
+    }
+    if (r == g && g == b) {
+        memset(p, r, (size_t)count * sizeof(Pixel));
+        return;
+    }
+
+    unsigned char pattern[12] = { r, g, b, r, g, b, r, g, b, r, g, b };
+    for (; count >= 4; count -= 4, p += 12) {
+        memcpy(p, pattern, 12);
+    }
+    for (; count > 0; count--, p += 3) {
+        p[0] = r;
+        p[1] = g;
+        p[2] = b;
+    }
+}
+
+// fillSpan for framebuffers that are not RGB24 (raster_framebuffer.c)
+void fillSpanFormat(const Framebuffer* fb, int x0, int x1, int y, Color color);
+
+// Fill pixels [x0, x1] of row y, in any format
+static inline void fillSpan(const Framebuffer* fb, int x0, int x1, int y, Color color) {
+    if (fb->format == PIXEL_RGB24) {
+        fillPixels(pixelAt(fb, x0, y), x1 - x0 + 1, color);
+    } else {
+        fillSpanFormat(fb, x0, x1, y, color);
+    }
+}
+
+// Fill [x0, x1] of row y, clipped to the framebuffer; returns the number
+// of pixels written
+static inline long clippedSpan(const Framebuffer* fb, int x0, int x1, int y, Color color) {
+    if ((unsigned)y >= (unsigned)fb->height) {
+        return 0;
+    }
+    if (x0 < 0) {
+        x0 = 0;
+    }
+    if (x1 > fb->width - 1) {
+        x1 = fb->width - 1;
+    }
+    if (x0 > x1) {
+        return 0;
+    }
+    fillSpan(fb, x0, x1, y, color);
+    return x1 - x0 + 1;
+}
+
+// fillColumn for framebuffers that are not RGB24 (raster_framebuffer.c)
+void fillColumnFormat(const Framebuffer* fb, int x, int y0, int y1, Color color);
+
+// Fill pixels [y0, y1] of column x, in any format
+static inline void fillColumn(const Framebuffer* fb, int x, int y0, int y1, Color color) {
+    if (fb->format != PIXEL_RGB24) {
+        fillColumnFormat(fb, x, y0, y1, color);
+        return;
+    }
+
+    Pixel* p = pixelAt(fb, x, y0);
+    for (int y = y0; y <= y1; y++, p += fb->stride) {
+        writePixel(p, color);
+    }
+}
+
+// Bresenham line indexed by step along its major axis. Pixel i (0..major)
+// sits at major offset i and minor offset
+//
+//     floor((2 * i * minor + major - 1) / (2 * major))
+//
+// which is round(i * minor / major) with ties toward the start, the choice
+// drawLineBresenham makes. Because the error term at any step follows from
+// that formula directly, a line can be entered at an arbitrary step (the
+// first pixel inside a tile or clip rectangle) and still plot exactly the
+// pixels of the unclipped line.
+typedef struct {
+    int x1, y1;
+    int xMajor;             // 1 if x is the major axis
+    int major, minor;       // |delta| along each axis
+    int majorSign, minorSign;
+} LineSteps;
+
+void initLineSteps(LineSteps* line, int x1, int y1, int x2, int y2);
+
+// Pixel plotted at step i
+void lineStepPoint(const LineSteps* line, int i, int* x, int* y);
+
+// Range of steps whose pixels fall inside [left, right] x [top, bottom];
+// returns 0 if the line misses the rectangle
+int clipLineSteps(const LineSteps* line, int left, int top, int right, int bottom,
+                  int* first, int* last);
+
+// Bresenham error state of a line positioned at one of its steps
+typedef struct {
+    long pixel;                 // index into fb->pixels
+    int64_t remainder;          // error term, in [0, twoMajor)
+    int64_t twoMajor, twoMinor;
+    long majorStep, minorStep;  // pixel index deltas
+} LineCursor;
+
+void seekLineSteps(const Framebuffer* fb, const LineSteps* line, int first, LineCursor* cursor);
+
+// Plot `count` pixels from the cursor; all of them must be inside the
+// framebuffer
+static inline void stepLineCursor(const Framebuffer* fb, const LineCursor* cursor, int count, Color color) {
+    // Locals, because the byte stores in writePixel may alias *cursor
+    Pixel* p = fb->pixels + cursor->pixel;
+    int64_t remainder = cursor->remainder;
+    int64_t twoMajor = cursor->twoMajor;
+    int64_t twoMinor = cursor->twoMinor;
+    long majorStep = cursor->majorStep;
+    long minorStep = cursor->minorStep;
+
+    for (int i = count; ; ) {
+        writePixel(p, color);
+        if (--i == 0) {
+            break;
+        }
+
+        p += majorStep;
+        remainder += twoMinor;
+        if (remainder >= twoMajor) {
+            remainder -= twoMajor;
+            p += minorStep;
+        }
+    }
+}
+
+// stepLineCursor for framebuffers that are not RGB24 (raster_framebuffer.c)
+void stepLineCursorFormat(const Framebuffer* fb, const LineCursor* cursor, int count, Color color);
+
+// Plot steps [first, last], in any format; every one of them must be
+// inside the framebuffer
+void rasterizeLineSteps(Framebuffer* fb, const LineSteps* line, int first, int last, Color color);
+
+// Untraced Bresenham line clipped to the framebuffer (raster_clip.c)
+void rasterizeLineClipped(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Steps [first, last] of a float DDA line outside of which no pixel can
+// land in the framebuffer; returns 0 if the whole line is off-screen.
+// Float rounding is allowed for, so pixels in the range still need
+// bounds checks.
+int clipLineDDASteps(const Framebuffer* fb, int x1, int y1, int x2, int y2, int steps,
+                     int* first, int* last);
+
+// Monotonic clock used for BatchStats, in seconds
+double batchClock(void);
+
+// Pixels a line steps through, including off-screen ones; 0 for a line
+// beyond LINE_MAX_COORD, which is not drawn
+size_t lineStepCount(int x1, int y1, int x2, int y2);
+
+// Fill in BatchStats for a batch that started at batchClock() == start.
+// The clock is read before the pixels are counted.
+void finishBatchStats(BatchStats* stats, const Segment* segments, size_t count, double start);
+
+// Fill in BatchStats for a batch of `count` items (segments, circles, ...)
+// that touched `pixels` pixels and started at batchClock() == start
+void finishBatchPixels(BatchStats* stats, size_t count, size_t pixels, double start);
+
+// Untraced per-pixel kernels from raster.c, used as fallbacks by the
+// vectorized and run-based variants
+void rasterizeLineDDAScalar(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Float DDA line that only plots the pixels inside `clip`; the pixels it
+// does plot are those of drawLineDDA
+void rasterizeLineDDAClipped(Framebuffer* fb, int x1, int y1, int x2, int y2, const ClipRect* clip,
+                             Color color);
+void rasterizeLineFixedScalar(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+void rasterizeLineBresenhamScalar(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Vectorized fixed-point DDA from raster_simd.c (never traces)
+void rasterizeLineFixedSimd(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Untraced run-slice Bresenham from raster_runslice.c
+void rasterizeLineRunSlice(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Anti-aliased Wu line from raster_aa.c, drawn from step `start` (0 or 1)
+// on; line strips pass 1 to leave out the vertex they already drew
+void rasterizeLineWu(Framebuffer* fb, int x1, int y1, int x2, int y2, int start, Color color);
+
+// a / b rounded toward negative infinity (b != 0)
+static inline long long floorDiv(long long a, long long b) {
+    long long q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// Little-endian integers of the scene and segment file formats
+static inline uint32_t readLittle32(const unsigned char* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline uint64_t readLittle64(const unsigned char* p) {
+    return (uint64_t)readLittle32(p) | (uint64_t)readLittle32(p + 4) << 32;
+}
+
+static inline void writeLittle32(unsigned char* p, uint32_t value) {
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+}
+
+static inline void writeLittle64(unsigned char* p, uint64_t value) {
+    writeLittle32(p, (uint32_t)value);
+    writeLittle32(p + 4, (uint32_t)(value >> 32));
+}
+
+#endif
@@ -0,0 +1,164 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "raster.h"
+#include "raster_internal.h"
+
+// Point markers: solid dots of all pixels with dx*dx + dy*dy <= r*r.
+//
+// A dot is symmetric about its center row, so its shape is the half-width
+// of each row offset 0..r. Those masks are computed once for every radius
+// up to MARKER_CACHE_RADIUS and kept in one table; stamping a marker is
+// then one lookup and one row copy per row. The copies come from a row of
+// 2r + 1 pixels already in the marker color, which a batch only rebuilds
+// when the color changes.
+
+// Largest radius with a cached mask; bigger markers compute theirs per call
+#define MARKER_CACHE_RADIUS 63
+
+// Masks of radius 0, 1, ... stored back to back; radius r starts at
+// r * (r + 1) / 2 and has r + 1 entries
+static int32_t markerMasks[(MARKER_CACHE_RADIUS + 1) * (MARKER_CACHE_RADIUS + 2) / 2];
+static pthread_once_t markerMasksOnce = PTHREAD_ONCE_INIT;
+
+// Half-widths of every row of a radius-r dot. The width only shrinks
+// from row to row, so it is found by stepping down instead of a square
+// root.
+static void computeMarkerMask(int radius, int32_t* halfWidth) {
+    int64_t r2 = (int64_t)radius * radius;
+    int64_t w = radius;
+
+    for (int64_t dy = 0; dy <= radius; dy++) {
+        while (w * w + dy * dy > r2) {
+            w--;
+        }
+        halfWidth[dy] = (int32_t)w;
+    }
+}
+
+static void buildMarkerMasks(void) {
+    for (int r = 0; r <= MARKER_CACHE_RADIUS; r++) {
+        computeMarkerMask(r, markerMasks + r * (r + 1) / 2);
+    }
+}
+
+// Mask of `radius`, from the cache or else computed into a new heap block
+// the caller frees (NULL if out of memory)
+static const int32_t* markerMask(int radius) {
+    if (radius <= MARKER_CACHE_RADIUS) {
+        pthread_once(&markerMasksOnce, buildMarkerMasks);
+        return markerMasks + radius * (radius + 1) / 2;
+    }
+
+    int32_t* mask = malloc(sizeof(int32_t) * ((size_t)radius + 1));
+    if (mask) {
+        computeMarkerMask(radius, mask);
+    }
+    return mask;
+}
+
+static void releaseMarkerMask(const int32_t* mask, int radius) {
+    if (radius > MARKER_CACHE_RADIUS) {
+        free((void*)mask);
+    }
+}
+
+// Row `dy` of a marker: [x - w, x + w] clipped to the framebuffer, copied
+// from the RGB24 `row` (centered on row[radius]) or filled when there is
+// no row
+static inline long stampRow(const Framebuffer* fb, int x, int y, int w, int radius,
+                            const Pixel* row, Color color) {
+    if ((unsigned)y >= (unsigned)fb->height) {
+        return 0;
+    }
+
+    int x0 = x - w > 0 ? x - w : 0;
+    int x1 = x + w < fb->width - 1 ? x + w : fb->width - 1;
+    if (x0 > x1) {
+        return 0;
+    }
+
+    if (row) {
+        memcpy(pixelAt(fb, x0, y), row + radius + (x0 - x), sizeof(Pixel) * (size_t)(x1 - x0 + 1));
+    } else {
+        fillSpan(fb, x0, x1, y, color);
+    }
+    return x1 - x0 + 1;
+}
+
+static long stampMarker(const Framebuffer* fb, int x, int y, int radius, const int32_t* mask,
+                        const Pixel* row, Color color) {
+    if ((long)x + radius < 0 || (long)x - radius >= fb->width ||
+        (long)y + radius < 0 || (long)y - radius >= fb->height) {
+        return 0;
+    }
+
+    long pixels = stampRow(fb, x, y, mask[0], radius, row, color);
+    for (int dy = 1; dy <= radius; dy++) {
+        pixels += stampRow(fb, x, y - dy, mask[dy], radius, row, color);
+        pixels += stampRow(fb, x, y + dy, mask[dy], radius, row, color);
+    }
+    return pixels;
+}
+
+static void fillMarkerRow(Pixel* row, int radius, Color color) {
+    for (int i = 0; i <= 2 * radius; i++) {
+        writePixel(&row[i], color);
+    }
+}
+
+void drawMarker(Framebuffer* fb, int x, int y, int radius, Color color) {
+    if (radius < 0 || radius > MARKER_MAX_RADIUS) {
+        return;
+    }
+
+    const int32_t* mask = markerMask(radius);
+    if (!mask) {
+        return;
+    }
+
+    if (radius <= MARKER_CACHE_RADIUS && fb->format == PIXEL_RGB24) {
+        Pixel row[2 * MARKER_CACHE_RADIUS + 1];
+
+        fillMarkerRow(row, radius, color);
+        stampMarker(fb, x, y, radius, mask, row, color);
+    } else {
+        stampMarker(fb, x, y, radius, mask, NULL, color);
+    }
+    releaseMarkerMask(mask, radius);
+}
+
+void drawMarkerBatch(Framebuffer* fb, const Marker* markers, size_t count, int radius,
+                     BatchStats* stats) {
+    double start = stats ? batchClock() : 0.0;
+    size_t pixels = 0;
+    const int32_t* mask = radius >= 0 && radius <= MARKER_MAX_RADIUS ? markerMask(radius) : NULL;
+
+    if (mask) {
+        // Row copies are for RGB24; large markers are mostly long spans,
+        // which fillSpan already writes in 12-byte chunks
+        Pixel row[2 * MARKER_CACHE_RADIUS + 1];
+        const Pixel* source = radius <= MARKER_CACHE_RADIUS && fb->format == PIXEL_RGB24 ? row : NULL;
+        Color rowColor = 0;
+
+        if (source) {
+            fillMarkerRow(row, radius, rowColor);
+        }
+        for (size_t i = 0; i < count; i++) {
+            const Marker* m = &markers[i];
+
+            if (source && m->color != rowColor) {
+                rowColor = m->color;
+                fillMarkerRow(row, radius, rowColor);
+            }
+            pixels += stampMarker(fb, m->x, m->y, radius, mask, source, m->color);
+        }
+        releaseMarkerMask(mask, radius);
+    }
+
+    if (stats) {
+        finishBatchPixels(stats, count, pixels, start);
+    }
+}
@@ -0,0 +1,303 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "raster.h"
+#include "raster_internal.h"
+
+// Scanline polygon fill.
+//
+// A pixel is inside when its center is. Edges are half-open, as for the
+// stroke pieces in raster_stroke.c: an edge crosses rows [top, bottom),
+// and a crossing at x starts or ends the pixels at column ceil(x). Two
+// polygons that share an edge therefore meet without a gap or an overlap.
+//
+// Each edge is stepped down the rows the way drawLineDDA steps a line: x
+// advances by the constant increment dx / dy per row. The increment is
+// held exactly, as an integer part plus a remainder in units of 1 / dy,
+// so no rounding builds up along an edge of any length and both polygons
+// on an edge agree on every crossing.
+//
+// The edges are bucketed by the first row they cross (the edge table).
+// Going down the rows, edges join and leave the active edge list, which
+// is kept sorted by crossing column and read left to right by the fill
+// rule into spans. From one row to the next the list is nearly sorted,
+// so an insertion sort keeps it in order. A contour that goes down once
+// and up once, which every convex polygon does, crosses each row exactly
+// twice. It is filled by walking its two sides, without an edge table.
+
+typedef struct {
+    int first, last;        // rows [first, last) to fill, clipped to the framebuffer
+    int winding;            // +1 where the contour goes down, -1 up
+    int column;             // first pixel right of the crossing, on the current row
+    long long x, rem;       // crossing at x + rem / dy, 0 <= rem < dy
+    long long step, carry;  // increment dx / dy = step + carry / dy
+    long long dy;
+} PolygonEdge;
+
+// One side of a contour that goes down once and up once: its edges from
+// the top vertex to the bottom one, taken forward or backward through the
+// points
+typedef struct {
+    const Point* points;
+    size_t count;
+    size_t vertex;          // upper end of the current edge
+    int direction;          // 1 forward, -1 backward
+    PolygonEdge edge;
+} ContourSide;
+
+// Set up the edge from a to b at its first visible row. Returns 0 for
+// horizontal edges and edges with no rows on the framebuffer.
+static int initEdge(PolygonEdge* edge, const Point* a, const Point* b, int height) {
+    if (a->y == b->y) {
+        return 0;
+    }
+    edge->winding = 1;
+    if (a->y > b->y) {
+        const Point* swap = a;
+        a = b;
+        b = swap;
+        edge->winding = -1;
+    }
+
+    edge->first = a->y < 0 ? 0 : a->y;
+    edge->last = b->y > height ? height : b->y;
+    if (edge->first >= edge->last) {
+        return 0;
+    }
+
+    long long dx = (long long)b->x - a->x;
+    long long dy = (long long)b->y - a->y;
+    long long offset = (long long)(edge->first - a->y) * dx;
+    long long whole = floorDiv(offset, dy);
+
+    edge->dy = dy;
+    edge->step = floorDiv(dx, dy);
+    edge->carry = dx - edge->step * dy;
+    edge->x = a->x + whole;
+    edge->rem = offset - whole * dy;
+    return 1;
+}
+
+// Column of the first pixel center at or right of the crossing, clamped
+// to [0, width]
+static inline int edgeColumn(const PolygonEdge* edge, int width) {
+    long long column = edge->x + (edge->rem > 0);
+    return column < 0 ? 0 : column > width ? width : (int)column;
+}
+
+// The carry comes on a data-dependent pattern of rows, so it is added
+// without a branch to mispredict
+static inline void stepEdge(PolygonEdge* edge) {
+    long long rem = edge->rem + edge->carry;
+    long long carried = rem >= edge->dy;
+
+    edge->x += edge->step + carried;
+    edge->rem = rem - (edge->dy & -carried);
+}
+
+static int validPoints(const Point* points, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (points[i].x < -POLYGON_MAX_COORD || points[i].x > POLYGON_MAX_COORD ||
+            points[i].y < -POLYGON_MAX_COORD || points[i].y > POLYGON_MAX_COORD) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// How many times the contour switches between going down and going up,
+// ignoring horizontal edges
+static int directionChanges(const Point* points, size_t count) {
+    int changes = 0, first = 0, last = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const Point* a = &points[i];
+        const Point* b = &points[i + 1 == count ? 0 : i + 1];
+        int direction = (b->y > a->y) - (b->y < a->y);
+        if (direction == 0) {
+            continue;
+        }
+        if (first == 0) {
+            first = direction;
+        } else if (direction != last) {
+            changes++;
+        }
+        last = direction;
+    }
+    return changes + (last != first);
+}
+
+// Make side->edge the edge that crosses row y. Rows are asked for in
+// order, so this only moves on down the side.
+static void sideEdge(ContourSide* side, int y, int height) {
+    while (side->edge.last <= y) {
+        size_t next = side->direction > 0
+            ? (side->vertex + 1 == side->count ? 0 : side->vertex + 1)
+            : (side->vertex == 0 ? side->count - 1 : side->vertex - 1);
+        const Point* a = &side->points[side->vertex];
+
+        side->vertex = next;
+        if (!initEdge(&side->edge, a, &side->points[next], height)) {
+            side->edge.last = INT_MIN;
+        }
+    }
+}
+
+// Fast path for a contour that goes down once and up once: one crossing
+// on each side per row, so every row is a single span
+static void fillMonotone(Framebuffer* fb, const Point* points, size_t count, Color color) {
+    size_t top = 0;
+    int bottom = points[0].y;
+
+    for (size_t i = 1; i < count; i++) {
+        if (points[i].y < points[top].y) {
+            top = i;
+        }
+        if (points[i].y > bottom) {
+            bottom = points[i].y;
+        }
+    }
+
+    ContourSide sides[2];
+    memset(sides, 0, sizeof(sides));
+    for (int s = 0; s < 2; s++) {
+        sides[s].points = points;
+        sides[s].count = count;
+        sides[s].vertex = top;
+        sides[s].direction = s == 0 ? 1 : -1;
+        sides[s].edge.last = INT_MIN;
+    }
+
+    int first = points[top].y < 0 ? 0 : points[top].y;
+    int last = bottom > fb->height ? fb->height : bottom;
+    for (int y = first; y < last; y++) {
+        sideEdge(&sides[0], y, fb->height);
+        sideEdge(&sides[1], y, fb->height);
+
+        int x0 = edgeColumn(&sides[0].edge, fb->width);
+        int x1 = edgeColumn(&sides[1].edge, fb->width);
+        if (x0 > x1) {
+            int swap = x0;
+            x0 = x1;
+            x1 = swap;
+        }
+        if (x0 < x1) {
+            fillSpan(fb, x0, x1 - 1, y, color);
+        }
+        stepEdge(&sides[0].edge);
+        stepEdge(&sides[1].edge);
+    }
+}
+
+// Spans of one row from the active edges, sorted by column
+static void fillActiveRow(Framebuffer* fb, PolygonEdge** active, size_t count, int y,
+                          FillRule rule, Color color) {
+    int winding = 0, start = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        int wasInside = rule == FILL_NONZERO ? winding != 0 : winding & 1;
+        winding += active[i]->winding;
+        int inside = rule == FILL_NONZERO ? winding != 0 : winding & 1;
+
+        if (inside && !wasInside) {
+            start = active[i]->column;
+        } else if (wasInside && !inside && start < active[i]->column) {
+            fillSpan(fb, start, active[i]->column - 1, y, color);
+        }
+    }
+}
+
+// The general path: edge table and active edge list over all contours
+static void fillEdgeTable(Framebuffer* fb, const Point* points, const size_t* counts,
+                          size_t contours, size_t total, FillRule rule, Color color) {
+    PolygonEdge* edges = malloc(total * (sizeof(PolygonEdge) + 2 * sizeof(PolygonEdge*)));
+    if (!edges) {
+        return;
+    }
+    PolygonEdge** table = (PolygonEdge**)(edges + total);
+    PolygonEdge** active = table + total;
+
+    size_t count = 0;
+    int top = fb->height, bottom = 0;
+    for (size_t c = 0; c < contours; points += counts[c], c++) {
+        size_t n = counts[c];
+        for (size_t i = 0; n >= 3 && i < n; i++) {
+            PolygonEdge* edge = &edges[count];
+            if (initEdge(edge, &points[i], &points[i + 1 == n ? 0 : i + 1], fb->height)) {
+                top = edge->first < top ? edge->first : top;
+                bottom = edge->last > bottom ? edge->last : bottom;
+                count++;
+            }
+        }
+    }
+
+    // Bucket the edges by first row (a counting sort)
+    size_t rows = count ? (size_t)(bottom - top) : 0;
+    size_t* start = count ? calloc(rows + 1, sizeof(size_t)) : NULL;
+    if (!start) {
+        free(edges);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        start[edges[i].first - top + 1]++;
+    }
+    for (size_t r = 0; r < rows; r++) {
+        start[r + 1] += start[r];
+    }
+    for (size_t i = 0; i < count; i++) {
+        table[start[edges[i].first - top]++] = &edges[i];
+    }
+
+    // start[r] now ends the edges that join on row top + r
+    size_t next = 0, activeCount = 0;
+    for (int y = top; y < bottom; y++) {
+        for (; next < start[y - top]; next++) {
+            active[activeCount++] = table[next];
+        }
+
+        for (size_t i = 0; i < activeCount; i++) {
+            PolygonEdge* edge = active[i];
+            size_t j = i;
+            edge->column = edgeColumn(edge, fb->width);
+            for (; j > 0 && active[j - 1]->column > edge->column; j--) {
+                active[j] = active[j - 1];
+            }
+            active[j] = edge;
+        }
+        fillActiveRow(fb, active, activeCount, y, rule, color);
+
+        // On to the next row, without the edges that end on this one
+        size_t kept = 0;
+        for (size_t i = 0; i < activeCount; i++) {
+            if (active[i]->last > y + 1) {
+                stepEdge(active[i]);
+                active[kept++] = active[i];
+            }
+        }
+        activeCount = kept;
+    }
+
+    free(start);
+    free(edges);
+}
+
+void fillPolygonContours(Framebuffer* fb, const Point* points, const size_t* counts,
+                         size_t contours, FillRule rule, Color color) {
+    size_t total = 0;
+    for (size_t c = 0; c < contours; c++) {
+        total += counts[c];
+    }
+    if (total == 0 || fb->width <= 0 || fb->height <= 0 || !validPoints(points, total)) {
+        return;
+    }
+
+    if (contours == 1 && counts[0] >= 3 && directionChanges(points, counts[0]) == 2) {
+        fillMonotone(fb, points, counts[0], color);
+        return;
+    }
+    fillEdgeTable(fb, points, counts, contours, total, rule, color);
+}
+
+void fillPolygon(Framebuffer* fb, const Point* points, size_t count, FillRule rule, Color color) {
+    fillPolygonContours(fb, points, &count, 1, rule, color);
+}
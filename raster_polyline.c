@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include "raster.h"
+#include "raster_internal.h"
+
+// Connected line strips.
+//
+// Segment i of a strip ends on the vertex where segment i + 1 starts, and
+// a Bresenham line always plots both of its endpoints. Drawn as separate
+// lines, every inner vertex is plotted twice: wasted work, and wrong for
+// anything that blends instead of overwriting. Here each segment after
+// the first starts at its step 1, so the strip plots exactly the pixels of
+// the separate lines, with each shared vertex plotted once.
+//
+// The segments of a trace are mostly short and on screen. Those skip the
+// clip and the division in seekLineSteps: step 0 is the vertex itself,
+// with the error term at its starting value. Each vertex is bounds-checked
+// once, as the end of one segment and the start of the next.
+
+// Cursor at step `start` (0 or 1) of the line from (x1, y1) to (x2, y2),
+// which begins inside the framebuffer; returns the line's last step
+static inline int startLineCursor(const Framebuffer* fb, int x1, int y1, int x2, int y2, int start,
+                                  LineCursor* cursor) {
+    int dx = abs(x2 - x1);
+    int dy = abs(y2 - y1);
+    long stepX = x2 < x1 ? -1 : 1;
+    long stepY = y2 < y1 ? -(long)fb->stride : fb->stride;
+    int xMajor = dx >= dy;
+    int major = xMajor ? dx : dy;
+
+    cursor->pixel = (long)y1 * fb->stride + x1;
+    cursor->remainder = major ? major - 1 : 0;
+    cursor->twoMajor = 2 * (int64_t)major;
+    cursor->twoMinor = 2 * (int64_t)(xMajor ? dy : dx);
+    cursor->majorStep = xMajor ? stepX : stepY;
+    cursor->minorStep = xMajor ? stepY : stepX;
+
+    if (start) {
+        cursor->pixel += cursor->majorStep;
+        cursor->remainder += cursor->twoMinor;
+        if (cursor->remainder >= cursor->twoMajor) {
+            cursor->remainder -= cursor->twoMajor;
+            cursor->pixel += cursor->minorStep;
+        }
+    }
+    return major;
+}
+
+// Bresenham strip; returns the pixels stepped, including off-screen ones.
+// Callers pass a constant `rgb24` so the RGB24 loop inlines its stores.
+static inline size_t drawStripBresenham(Framebuffer* fb, const Point* points, size_t count,
+                                        Color color, int rgb24) {
+    size_t stepped = 0;
+    int fromInside = count > 0 && insideFramebuffer(fb, points[0].x, points[0].y);
+
+    for (size_t i = count > 1 ? 1 : 0; i < count; i++) {
+        const Point* from = &points[i > 0 ? i - 1 : 0];
+        const Point* to = &points[i];
+        int start = i > 1;      // the first segment also plots its start vertex
+        int toInside = insideFramebuffer(fb, to->x, to->y);
+        LineCursor cursor;
+        int first = start;
+        int last;
+
+        if (!lineInRange(from->x, from->y, to->x, to->y)) {
+            fromInside = toInside;
+            continue;
+        }
+        if (fromInside && toInside) {
+            last = startLineCursor(fb, from->x, from->y, to->x, to->y, start, &cursor);
+            stepped += (size_t)(last - start + 1);
+        } else {
+            LineSteps line;
+            initLineSteps(&line, from->x, from->y, to->x, to->y);
+            last = line.major;
+            stepped += (size_t)(last - start + 1);
+            if (!clipLineSteps(&line, 0, 0, fb->width - 1, fb->height - 1, &first, &last)) {
+                fromInside = toInside;
+                continue;
+            }
+            if (first < start) {
+                first = start;
+            }
+            if (first <= last) {
+                seekLineSteps(fb, &line, first, &cursor);
+            }
+        }
+        fromInside = toInside;
+        if (first > last) {
+            continue;           // repeated vertex
+        }
+
+        if (rgb24) {
+            stepLineCursor(fb, &cursor, last - first + 1, color);
+        } else {
+            stepLineCursorFormat(fb, &cursor, last - first + 1, color);
+        }
+    }
+    return stepped;
+}
+
+// Pixels a strip steps through, for the kernels that do not count them.
+// Segments beyond LINE_MAX_COORD are not drawn, so they step nothing.
+static size_t stripSteps(const Point* points, size_t count) {
+    size_t stepped = count > 0;
+
+    for (size_t i = 1; i < count; i++) {
+        if (!lineInRange(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y)) {
+            continue;
+        }
+        int dx = abs(points[i].x - points[i - 1].x);
+        int dy = abs(points[i].y - points[i - 1].y);
+        stepped += (size_t)(dx > dy ? dx : dy);
+    }
+    return stepped;
+}
+
+void drawPolyline(Framebuffer* fb, const Point* points, size_t count, Color color,
+                  LineAlgorithm algorithm, BatchStats* stats) {
+    double start = stats ? batchClock() : 0.0;
+    size_t stepped = 0;
+
+    switch (algorithm) {
+    case LINE_WU:
+        if (count == 1) {
+            rasterizeLineWu(fb, points[0].x, points[0].y, points[0].x, points[0].y, 0, color);
+        }
+        for (size_t i = 1; i < count; i++) {
+            rasterizeLineWu(fb, points[i - 1].x, points[i - 1].y, points[i].x, points[i].y,
+                            i > 1, color);
+        }
+        if (stats) {
+            stepped = stripSteps(points, count);
+        }
+        break;
+    case LINE_DDA:
+        if (count == 1) {
+            rasterizeLineDDAScalar(fb, points[0].x, points[0].y, points[0].x, points[0].y, color);
+        }
+        for (size_t i = 1; i < count; i++) {
+            rasterizeLineDDAScalar(fb, points[i - 1].x, points[i - 1].y, points[i].x, points[i].y,
+                                   color);
+        }
+        if (stats) {
+            stepped = stripSteps(points, count);
+        }
+        break;
+    case LINE_BRESENHAM:
+    case LINE_DDA_FIXED:
+    case LINE_DDA_SIMD:
+    case LINE_RUN_SLICE:
+    default:
+        if (fb->format == PIXEL_RGB24) {
+            stepped = drawStripBresenham(fb, points, count, color, 1);
+        } else {
+            stepped = drawStripBresenham(fb, points, count, color, 0);
+        }
+        break;
+    }
+
+    if (stats) {
+        finishBatchPixels(stats, count > 1 ? count - 1 : 0, stepped, start);
+    }
+}
@@ -0,0 +1,230 @@
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "raster_pool.h"
+
+// Task indices queued for one worker. All tasks of a run are queued before
+// the workers wake up and nothing is added while they run, so a worker that
+// finds every queue empty is done.
+typedef struct {
+    pthread_mutex_t lock;
+    int* tasks;
+    int head;           // next task to steal
+    int tail;           // one past the next task the owner takes
+    int capacity;
+} WorkQueue;
+
+typedef struct {
+    ThreadPool* pool;
+    int index;
+    pthread_t thread;
+    WorkQueue queue;
+} Worker;
+
+struct ThreadPool {
+    int size;
+    Worker* workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;       // a new run (or shutdown) is available
+    pthread_cond_t finished;    // the last worker left the current run
+    unsigned generation;        // bumped once per run
+    int running;                // workers still busy with the current run
+    int shutdown;
+
+    PoolTask task;
+    void* arg;
+};
+
+int cpuCount(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+static int popBack(WorkQueue* queue, int* task) {
+    int found = 0;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->tail > queue->head) {
+        *task = queue->tasks[--queue->tail];
+        found = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+static int popFront(WorkQueue* queue, int* task) {
+    int found = 0;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->tail > queue->head) {
+        *task = queue->tasks[queue->head++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+static int stealTask(ThreadPool* pool, int thief, int* task) {
+    for (int k = 1; k < pool->size; k++) {
+        if (popFront(&pool->workers[(thief + k) % pool->size].queue, task)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void drainQueues(ThreadPool* pool, int self) {
+    int task;
+
+    while (popBack(&pool->workers[self].queue, &task) || stealTask(pool, self, &task)) {
+        pool->task(task, self, pool->arg);
+    }
+}
+
+static void* workerMain(void* data) {
+    Worker* worker = data;
+    ThreadPool* pool = worker->pool;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        drainQueues(pool, worker->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) {
+            pthread_cond_signal(&pool->finished);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool* createThreadPool(int threads) {
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) {
+        return NULL;
+    }
+
+    pool->size = threads > 0 ? threads : cpuCount();
+    pool->workers = calloc((size_t)pool->size, sizeof(Worker));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+
+    for (int i = 0; i < pool->size; i++) {
+        Worker* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        pthread_mutex_init(&worker->queue.lock, NULL);
+
+        if (pthread_create(&worker->thread, NULL, workerMain, worker) != 0) {
+            // Keep the threads that did start
+            pthread_mutex_destroy(&worker->queue.lock);
+            pool->size = i;
+            break;
+        }
+    }
+
+    if (pool->size == 0) {
+        destroyThreadPool(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+int threadPoolSize(const ThreadPool* pool) {
+    return pool->size;
+}
+
+static int reserveQueue(WorkQueue* queue, int capacity) {
+    if (queue->capacity >= capacity) {
+        return 1;
+    }
+
+    int* tasks = realloc(queue->tasks, sizeof(int) * (size_t)capacity);
+    if (!tasks) {
+        return 0;
+    }
+    queue->tasks = tasks;
+    queue->capacity = capacity;
+    return 1;
+}
+
+void threadPoolRun(ThreadPool* pool, int count, PoolTask task, void* arg) {
+    if (count <= 0) {
+        return;
+    }
+
+    // Workers are idle between runs, so the queues can be filled unlocked
+    int perWorker = (count + pool->size - 1) / pool->size;
+    for (int w = 0; w < pool->size; w++) {
+        WorkQueue* queue = &pool->workers[w].queue;
+        queue->head = 0;
+        queue->tail = 0;
+        if (!reserveQueue(queue, perWorker)) {
+            // Out of memory: do the work on the calling thread instead
+            for (int i = 0; i < count; i++) {
+                task(i, 0, arg);
+            }
+            return;
+        }
+    }
+
+    // Round-robin, so neighbouring tasks (and their cache lines) start out
+    // on different workers
+    for (int i = 0; i < count; i++) {
+        WorkQueue* queue = &pool->workers[i % pool->size].queue;
+        queue->tasks[queue->tail++] = i;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->running = pool->size;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->finished, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void destroyThreadPool(ThreadPool* pool) {
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->size; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+        pthread_mutex_destroy(&pool->workers[i].queue.lock);
+        free(pool->workers[i].queue.tasks);
+    }
+
+    pthread_cond_destroy(&pool->finished);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
@@ -0,0 +1,30 @@
+#ifndef RASTER_POOL_H
+#define RASTER_POOL_H
+
+// Fixed set of worker threads that run indexed tasks in parallel.
+//
+// threadPoolRun hands out task indices 0..count-1 round-robin to per-worker
+// queues. Each worker drains its own queue from the back and, once empty,
+// steals from the front of the others, so uneven tasks (a tile crossed by
+// thousands of lines next to an empty one) still balance out.
+
+typedef struct ThreadPool ThreadPool;
+
+typedef void (*PoolTask)(int index, int worker, void* arg);
+
+// threads <= 0 means one per online CPU; returns NULL on failure
+ThreadPool* createThreadPool(int threads);
+
+int threadPoolSize(const ThreadPool* pool);
+
+// Run task(i, worker, arg) for every i in [0, count) and wait for all of
+// them. `worker` is the index of the thread running the task, for per-thread
+// scratch data. Not reentrant: one run per pool at a time.
+void threadPoolRun(ThreadPool* pool, int count, PoolTask task, void* arg);
+
+void destroyThreadPool(ThreadPool* pool);
+
+// Number of online CPUs (at least 1)
+int cpuCount(void);
+
+#endif
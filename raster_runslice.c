@@ -0,0 +1,154 @@
+#include <stdlib.h>
+#include "raster.h"
+#include "raster_internal.h"
+#include "raster_trace.h"
+
+// Run-slice Bresenham.
+//
+// Measured along the major axis from the start point, Bresenham puts pixel
+// i at minor offset round(i * minor / major) with ties toward the start.
+// The pixels sharing minor offset j therefore end at
+//
+//     last(j) = floor((2j + 1) * major / (2 * minor))
+//
+// so each run's length falls out of one integer division. Stepping j by one
+// adds the constant major/minor to the quotient plus a carry from the
+// remainder, which is the classic run-length slice error term. Each run is
+// then one span fill (horizontal for x-major lines, vertical otherwise),
+// clipped once per run instead of once per pixel.
+
+// Below this average run length the per-run setup costs more than it saves,
+// so untraced calls hand the line to the per-pixel kernel instead. The same
+// goes for steep lines: a vertical run still touches one pixel per row.
+#define RUN_SLICE_MIN_RUN 4
+
+static inline void fillRun(Framebuffer* fb, int xMajor, int minorCoord, int from, int to, Color color) {
+    int lo = from < to ? from : to;
+    int hi = from < to ? to : from;
+    int majorLimit = xMajor ? fb->width : fb->height;
+    int minorLimit = xMajor ? fb->height : fb->width;
+
+    if (minorCoord < 0 || minorCoord >= minorLimit || hi < 0 || lo >= majorLimit) {
+        return;
+    }
+    if (lo < 0) {
+        lo = 0;
+    }
+    if (hi >= majorLimit) {
+        hi = majorLimit - 1;
+    }
+
+    if (xMajor) {
+        fillSpan(fb, lo, hi, minorCoord, color);
+    } else {
+        fillColumn(fb, minorCoord, lo, hi, color);
+    }
+}
+
+static inline void rasterizeRunSliceKernel(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color,
+                                           TraceLevel trace) {
+    if (!lineInRange(x1, y1, x2, y2)) {
+        return;
+    }
+
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+    int xMajor = abs(dx) >= abs(dy);
+    int major = xMajor ? abs(dx) : abs(dy);
+    int minor = xMajor ? abs(dy) : abs(dx);
+    int majorSign = (xMajor ? dx : dy) < 0 ? -1 : 1;
+    int minorSign = (xMajor ? dy : dx) < 0 ? -1 : 1;
+    int majorStart = xMajor ? x1 : y1;
+    int minorStart = xMajor ? y1 : x1;
+
+    if (trace == TRACE_OFF && (!xMajor || (minor > 0 && major / minor < RUN_SLICE_MIN_RUN))) {
+        rasterizeLineBresenhamScalar(fb, x1, y1, x2, y2, color);
+        return;
+    }
+
+    if (trace >= TRACE_SUMMARY) {
+        traceEmit(TRACE_BEGIN, TRACE_LINE_RUN_SLICE, x1, y1, x2, y2, 0, 0, 0);
+    }
+
+    // Axis-aligned lines are a single run
+    if (minor == 0) {
+        fillRun(fb, xMajor, minorStart, majorStart, majorStart + majorSign * major, color);
+        if (trace >= TRACE_STEPS) {
+            traceEmit(TRACE_STEP, TRACE_LINE_RUN_SLICE, 0, x1, y1, major + 1, 0, 0, 0);
+        }
+        if (trace >= TRACE_SUMMARY) {
+            traceEmit(TRACE_END, TRACE_LINE_RUN_SLICE, 1, major + 1, x2, y2, major + 1, 0, 0);
+        }
+        return;
+    }
+
+    // Untraced lines that leave the framebuffer only walk the runs between
+    // their first and last visible pixels
+    int firstRun = 0;
+    int lastRun = minor;
+    if (trace == TRACE_OFF && !(insideFramebuffer(fb, x1, y1) && insideFramebuffer(fb, x2, y2))) {
+        LineSteps line;
+        int firstStep, lastStep, x, y;
+
+        initLineSteps(&line, x1, y1, x2, y2);
+        if (!clipLineSteps(&line, 0, 0, fb->width - 1, fb->height - 1, &firstStep, &lastStep)) {
+            return;
+        }
+        lineStepPoint(&line, firstStep, &x, &y);
+        firstRun = minorSign * ((xMajor ? y : x) - minorStart);
+        lineStepPoint(&line, lastStep, &x, &y);
+        lastRun = minorSign * ((xMajor ? y : x) - minorStart);
+    }
+
+    // 64-bit so 2 * major cannot overflow
+    int64_t denominator = 2 * (int64_t)minor;
+    int64_t runStep = major / minor;
+    int64_t remainderStep = 2 * (int64_t)(major % minor);
+    int64_t last = (2 * (int64_t)firstRun + 1) * major / denominator;
+    int64_t remainder = (2 * (int64_t)firstRun + 1) * major % denominator;
+    int64_t first = firstRun == 0 ? 0 : (2 * (int64_t)firstRun - 1) * major / denominator + 1;
+    int runLength = 0;
+    int runX = x1, runY = y1;
+
+    for (int j = firstRun; j <= lastRun; j++) {
+        if (j == minor) {
+            last = major;
+        }
+
+        int minorCoord = minorStart + minorSign * j;
+        int from = majorStart + majorSign * (int)first;
+        fillRun(fb, xMajor, minorCoord, from, majorStart + majorSign * (int)last, color);
+
+        runLength = (int)(last - first + 1);
+        runX = xMajor ? from : minorCoord;
+        runY = xMajor ? minorCoord : from;
+        if (trace >= TRACE_STEPS) {
+            traceEmit(TRACE_STEP, TRACE_LINE_RUN_SLICE, j, runX, runY, runLength, 0, 0, 0);
+        }
+
+        first = last + 1;
+        last += runStep;
+        remainder += remainderStep;
+        if (remainder >= denominator) {
+            last++;
+            remainder -= denominator;
+        }
+    }
+
+    if (trace >= TRACE_SUMMARY) {
+        traceEmit(TRACE_END, TRACE_LINE_RUN_SLICE, minor + 1, major + 1, runX, runY, runLength, 0, 0);
+    }
+}
+
+void rasterizeLineRunSlice(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    rasterizeRunSliceKernel(fb, x1, y1, x2, y2, color, TRACE_OFF);
+}
+
+// Run-Slice Bresenham Line Drawing Algorithm
+void drawLineRunSlice(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    if (rasterTraceLevel == TRACE_OFF) {
+        rasterizeRunSliceKernel(fb, x1, y1, x2, y2, color, TRACE_OFF);
+    } else {
+        rasterizeRunSliceKernel(fb, x1, y1, x2, y2, color, rasterTraceLevel);
+    }
+}
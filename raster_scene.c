@@ -0,0 +1,281 @@
+#include <stdlib.h>
+#include "raster.h"
+#include "raster_internal.h"
+#include "raster_scene.h"
+
+// Items are redrawn into a region clipped to it, with pixels identical to
+// drawing them whole. Bresenham-type lines go through drawLineClipped and
+// float DDA lines through a clip test per pixel. Wu lines and markers are
+// drawn into a view of the region with shifted coordinates, which moves
+// their integer and fixed-point arithmetic without changing it.
+
+#define SCENE_INITIAL_ITEMS 64
+
+typedef enum {
+    ITEM_LINE,
+    ITEM_MARKER
+} SceneItemKind;
+
+typedef struct {
+    SceneItemKind kind;
+    LineAlgorithm algorithm;    // lines
+    int x1, y1, x2, y2;         // lines; markers use x1, y1
+    int radius;                 // markers
+    Color color;
+    ClipRect bounds;            // pixels the item can touch, within the canvas
+} SceneItem;
+
+struct Scene {
+    Framebuffer* fb;
+    Color background;
+    SceneItem* items;
+    size_t count;
+    size_t capacity;
+    ClipRect damage[SCENE_MAX_DAMAGE];
+    int damageCount;
+};
+
+static int emptyRect(const ClipRect* rect) {
+    return rect->left > rect->right || rect->top > rect->bottom;
+}
+
+static int rectsTouch(const ClipRect* a, const ClipRect* b) {
+    return a->left <= b->right + 1 && b->left <= a->right + 1 &&
+           a->top <= b->bottom + 1 && b->top <= a->bottom + 1;
+}
+
+static int rectsOverlap(const ClipRect* a, const ClipRect* b) {
+    return a->left <= b->right && b->left <= a->right && a->top <= b->bottom && b->top <= a->bottom;
+}
+
+static ClipRect rectUnion(const ClipRect* a, const ClipRect* b) {
+    ClipRect rect = {
+        a->left < b->left ? a->left : b->left,
+        a->top < b->top ? a->top : b->top,
+        a->right > b->right ? a->right : b->right,
+        a->bottom > b->bottom ? a->bottom : b->bottom
+    };
+    return rect;
+}
+
+static long rectArea(const ClipRect* rect) {
+    return (long)(rect->right - rect->left + 1) * (rect->bottom - rect->top + 1);
+}
+
+// Add `rect` to a list of at most SCENE_MAX_DAMAGE disjoint rectangles,
+// merging it with every rectangle it touches. A full list merges it into
+// the one that grows least.
+static void addRect(ClipRect* rects, int* count, ClipRect rect) {
+    if (emptyRect(&rect)) {
+        return;
+    }
+
+    for (int i = 0; i < *count; ) {
+        if (rectsTouch(&rects[i], &rect)) {
+            rect = rectUnion(&rects[i], &rect);
+            rects[i] = rects[--*count];
+            i = 0;      // the grown rectangle may touch earlier ones now
+        } else {
+            i++;
+        }
+    }
+
+    if (*count == SCENE_MAX_DAMAGE) {
+        int best = 0;
+        long bestGrowth = 0;
+        for (int i = 0; i < *count; i++) {
+            ClipRect merged = rectUnion(&rects[i], &rect);
+            long growth = rectArea(&merged) - rectArea(&rects[i]);
+            if (i == 0 || growth < bestGrowth) {
+                best = i;
+                bestGrowth = growth;
+            }
+        }
+        rect = rectUnion(&rects[best], &rect);
+        rects[best] = rects[--*count];
+        addRect(rects, count, rect);
+        return;
+    }
+    rects[(*count)++] = rect;
+}
+
+// `rect` limited to the canvas
+static ClipRect canvasRect(const Scene* scene, int left, int top, int right, int bottom) {
+    ClipRect rect = {
+        left < 0 ? 0 : left,
+        top < 0 ? 0 : top,
+        right > scene->fb->width - 1 ? scene->fb->width - 1 : right,
+        bottom > scene->fb->height - 1 ? scene->fb->height - 1 : bottom
+    };
+    return rect;
+}
+
+// View of `region` whose pixel (0, 0) is the region's top-left corner
+static void regionView(const Scene* scene, const ClipRect* region, Framebuffer* view) {
+    initFramebufferFormat(view, pixelAt(scene->fb, region->left, region->top),
+                          region->right - region->left + 1, region->bottom - region->top + 1,
+                          scene->fb->stride, PIXEL_RGB24);
+}
+
+// Draw the part of `item` inside `region`, which lies within the canvas
+static void drawItem(Scene* scene, const SceneItem* item, const ClipRect* region) {
+    Framebuffer view;
+
+    if (item->kind == ITEM_MARKER) {
+        regionView(scene, region, &view);
+        drawMarker(&view, item->x1 - region->left, item->y1 - region->top, item->radius, item->color);
+        return;
+    }
+
+    switch (item->algorithm) {
+    case LINE_WU:
+        regionView(scene, region, &view);
+        rasterizeLineWu(&view, item->x1 - region->left, item->y1 - region->top,
+                        item->x2 - region->left, item->y2 - region->top, 0, item->color);
+        break;
+    case LINE_DDA:
+        rasterizeLineDDAClipped(scene->fb, item->x1, item->y1, item->x2, item->y2, region, item->color);
+        break;
+    default:
+        drawLineClipped(scene->fb, item->x1, item->y1, item->x2, item->y2, region, item->color);
+        break;
+    }
+}
+
+// Clear `region` and draw every item that overlaps it, in order
+static void redrawRegion(Scene* scene, const ClipRect* region) {
+    for (int y = region->top; y <= region->bottom; y++) {
+        fillSpan(scene->fb, region->left, region->right, y, scene->background);
+    }
+
+    for (size_t i = 0; i < scene->count; i++) {
+        const SceneItem* item = &scene->items[i];
+        if (!emptyRect(&item->bounds) && rectsOverlap(&item->bounds, region)) {
+            drawItem(scene, item, region);
+        }
+    }
+    addRect(scene->damage, &scene->damageCount, *region);
+}
+
+// Append `item` and draw it on top; returns 0 or -1
+static int addItem(Scene* scene, const SceneItem* item) {
+    if (scene->count == scene->capacity) {
+        size_t capacity = scene->capacity ? 2 * scene->capacity : SCENE_INITIAL_ITEMS;
+        SceneItem* items = realloc(scene->items, sizeof(SceneItem) * capacity);
+        if (!items) {
+            return -1;
+        }
+        scene->items = items;
+        scene->capacity = capacity;
+    }
+
+    scene->items[scene->count++] = *item;
+    if (!emptyRect(&item->bounds)) {
+        drawItem(scene, item, &item->bounds);
+        addRect(scene->damage, &scene->damageCount, item->bounds);
+    }
+    return 0;
+}
+
+Scene* createScene(int width, int height, Color background) {
+    Scene* scene = calloc(1, sizeof(Scene));
+    if (!scene) {
+        return NULL;
+    }
+
+    scene->fb = createFramebuffer(width, height, PIXEL_RGB24);
+    if (!scene->fb) {
+        free(scene);
+        return NULL;
+    }
+    scene->background = background;
+    sceneClear(scene);
+    return scene;
+}
+
+void destroyScene(Scene* scene) {
+    if (!scene) {
+        return;
+    }
+    destroyFramebuffer(scene->fb);
+    free(scene->items);
+    free(scene);
+}
+
+const Framebuffer* sceneFramebuffer(const Scene* scene) {
+    return scene->fb;
+}
+
+size_t sceneItemCount(const Scene* scene) {
+    return scene->count;
+}
+
+int sceneAddLine(Scene* scene, int x1, int y1, int x2, int y2, Color color,
+                 LineAlgorithm algorithm) {
+    // Every algorithm stays within the box of the endpoints (Wu's second
+    // pixel never passes the end of the minor axis), but accumulated float
+    // error could round a long DDA line one pixel past it
+    int margin = algorithm == LINE_DDA;
+    SceneItem item;
+
+    item.kind = ITEM_LINE;
+    item.algorithm = algorithm;
+    item.x1 = x1;
+    item.y1 = y1;
+    item.x2 = x2;
+    item.y2 = y2;
+    item.radius = 0;
+    item.color = color;
+    item.bounds = canvasRect(scene, (x1 < x2 ? x1 : x2) - margin, (y1 < y2 ? y1 : y2) - margin,
+                             (x1 > x2 ? x1 : x2) + margin, (y1 > y2 ? y1 : y2) + margin);
+    return addItem(scene, &item);
+}
+
+int sceneAddMarker(Scene* scene, int x, int y, int radius, Color color) {
+    SceneItem item;
+
+    item.kind = ITEM_MARKER;
+    item.algorithm = LINE_BRESENHAM;
+    item.x1 = item.x2 = x;
+    item.y1 = item.y2 = y;
+    item.radius = radius;
+    item.color = color;
+    item.bounds = canvasRect(scene, x - radius, y - radius, x + radius, y + radius);
+    return addItem(scene, &item);
+}
+
+void sceneRemoveLast(Scene* scene, size_t count) {
+    ClipRect regions[SCENE_MAX_DAMAGE];
+    int regionCount = 0;
+
+    if (count > scene->count) {
+        count = scene->count;
+    }
+    for (size_t i = scene->count - count; i < scene->count; i++) {
+        addRect(regions, &regionCount, scene->items[i].bounds);
+    }
+    scene->count -= count;
+
+    for (int i = 0; i < regionCount; i++) {
+        redrawRegion(scene, &regions[i]);
+    }
+}
+
+void sceneClear(Scene* scene) {
+    ClipRect all = { 0, 0, scene->fb->width - 1, scene->fb->height - 1 };
+
+    scene->count = 0;
+    clearFramebuffer(scene->fb, scene->background);
+    scene->damageCount = 0;
+    addRect(scene->damage, &scene->damageCount, all);
+}
+
+int takeSceneDamage(Scene* scene, ClipRect rects[SCENE_MAX_DAMAGE]) {
+    int count = scene->damageCount;
+
+    for (int i = 0; i < count; i++) {
+        rects[i] = scene->damage[i];
+    }
+    scene->damageCount = 0;
+    return count;
+}
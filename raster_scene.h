@@ -0,0 +1,54 @@
+#ifndef RASTER_SCENE_H
+#define RASTER_SCENE_H
+
+#include "raster.h"
+
+// Retained scene with damage tracking, for interactive front ends.
+//
+// The scene keeps its lines and markers in drawing order, together with
+// the RGB24 framebuffer they are rasterized into. A new item is drawn on
+// top right away. Removing items clears the area they covered and
+// re-rasterizes only the remaining items that overlap it, clipped to that
+// area, so the framebuffer always equals a full redraw of the scene.
+// Every change also records the pixel rectangles it touched; a front end
+// takes them with takeSceneDamage and uploads just those regions.
+
+// Most rectangles takeSceneDamage hands out; nearby and overlapping
+// changes are merged to stay within it
+#define SCENE_MAX_DAMAGE 16
+
+typedef struct Scene Scene;
+
+// Empty scene of `width` x `height` pixels on a `background` canvas, which
+// starts out entirely damaged. Returns NULL on failure.
+Scene* createScene(int width, int height, Color background);
+
+void destroyScene(Scene* scene);
+
+// The framebuffer the scene is rasterized into. Read it, but draw through
+// the scene: anything drawn directly is lost where the scene redraws.
+const Framebuffer* sceneFramebuffer(const Scene* scene);
+
+size_t sceneItemCount(const Scene* scene);
+
+// Add a line on top of the scene and draw it. LINE_DDA and LINE_WU keep
+// their own pixels; the other algorithms all plot the Bresenham pixels.
+// Returns 0, or -1 if out of memory (the scene is unchanged).
+int sceneAddLine(Scene* scene, int x1, int y1, int x2, int y2, Color color,
+                 LineAlgorithm algorithm);
+
+// Add a drawMarker dot on top of the scene and draw it; returns 0 or -1
+int sceneAddMarker(Scene* scene, int x, int y, int radius, Color color);
+
+// Remove the `count` most recently added items (all of them if there are
+// fewer) and redraw the area they covered
+void sceneRemoveLast(Scene* scene, size_t count);
+
+// Remove every item and clear the canvas
+void sceneClear(Scene* scene);
+
+// Copy the rectangles changed since the last call into `rects` and forget
+// them; returns how many there are (0 if nothing changed)
+int takeSceneDamage(Scene* scene, ClipRect rects[SCENE_MAX_DAMAGE]);
+
+#endif
@@ -0,0 +1,585 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "raster.h"
+#include "raster_internal.h"
+#include "raster_scenefile.h"
+
+#define SCENE_MAGIC "RSCN"
+#define SCENE_VERSION 1
+#define SCENE_HEADER_BYTES 16
+
+// Most whitespace-separated words on one text line
+#define SCENE_MAX_WORDS 6
+
+// Commands collected before a batch call
+#define SCENE_BATCH 4096
+
+struct SceneReader {
+    FILE* in;
+    int binary;
+    int width, height;
+    Color color;
+    long line;              // text: line of the last command
+    long offset;            // binary: file offset of the next command
+    size_t start, end;      // unread bytes are buffer[start, end)
+    int eof;
+    char error[160];
+    unsigned char buffer[SCENE_READ_CHUNK];
+};
+
+// Text command names, in SceneOp order, and their argument counts
+static const char* const opNames[] = { "clear", "algorithm", "line", "circle", "disc", "ring", "marker" };
+static const int opArguments[] = { 0, 1, 4, 3, 3, 4, 3 };
+static const int binaryArguments[] = { 1, 1, 4, 3, 3, 4, 3 };
+
+// Text names of the line algorithms, in LineAlgorithm order
+static const char* const algorithmNames[] = {
+    "bresenham", "dda", "dda-fixed", "dda-simd", "run-slice", "wu"
+};
+
+// Move the unread bytes to the front and read more after them; returns
+// the number of bytes added (0 at the end of the input or on an error)
+static size_t fillBuffer(SceneReader* reader) {
+    if (reader->eof) {
+        return 0;
+    }
+    if (reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->end == sizeof(reader->buffer)) {
+        return 0;   // full; not the end of the input
+    }
+
+    size_t added = fread(reader->buffer + reader->end, 1, sizeof(reader->buffer) - reader->end, reader->in);
+    if (added == 0) {
+        reader->eof = 1;
+    }
+    reader->end += added;
+    return added;
+}
+
+// Make `count` bytes available at buffer[start]; returns 0 if the input
+// ends first
+static int requireBytes(SceneReader* reader, size_t count) {
+    while (reader->end - reader->start < count) {
+        if (fillBuffer(reader) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------- text
+
+// Next line, without its newline; returns 0 at the end of the input and -1
+// if a line does not fit the buffer
+static int nextTextLine(SceneReader* reader, char** text) {
+    unsigned char* newline;
+
+    for (;;) {
+        newline = memchr(reader->buffer + reader->start, '\n', reader->end - reader->start);
+        if (newline) {
+            break;
+        }
+        if (reader->start == 0 && reader->end == sizeof(reader->buffer)) {
+            return -1;
+        }
+        if (fillBuffer(reader) == 0) {
+            if (reader->start == reader->end) {
+                return 0;
+            }
+            // Last line without a newline: there is always room for one
+            // terminator, since a full buffer was caught above
+            newline = reader->buffer + reader->end;
+            break;
+        }
+    }
+
+    char* line = (char*)reader->buffer + reader->start;
+    size_t length = (size_t)((char*)newline - line);
+    reader->start += length + (newline < reader->buffer + reader->end);
+    reader->line++;
+
+    line[length] = '\0';
+    *text = line;
+    return 1;
+}
+
+// Split `line` into words in place; returns the count, or -1 if there are
+// too many
+static int splitWords(char* line, char** words) {
+    int count = 0;
+
+    for (char* p = line; ; ) {
+        while (*p == ' ' || *p == '\t' || *p == '\r') {
+            p++;
+        }
+        if (*p == '\0') {
+            return count;
+        }
+        if (count == SCENE_MAX_WORDS) {
+            return -1;
+        }
+        words[count++] = p;
+        while (*p && *p != ' ' && *p != '\t' && *p != '\r') {
+            p++;
+        }
+        if (*p) {
+            *p++ = '\0';
+        }
+    }
+}
+
+static int parseInt(const char* word, int* value) {
+    char* end;
+    errno = 0;
+    long parsed = strtol(word, &end, 10);
+    if (errno != 0 || end == word || *end != '\0' || parsed < -2147483647L - 1 || parsed > 2147483647L) {
+        return 0;
+    }
+    *value = (int)parsed;
+    return 1;
+}
+
+// "#RRGGBB", or three words r g b
+static int parseColor(char** words, int count, Color* color) {
+    if (count == 1 && words[0][0] == '#' && strlen(words[0]) == 7) {
+        char* end;
+        unsigned long value = strtoul(words[0] + 1, &end, 16);
+        if (*end == '\0') {
+            *color = (Color)value;
+            return 1;
+        }
+    } else if (count == 3) {
+        int r, g, b;
+        if (parseInt(words[0], &r) && parseInt(words[1], &g) && parseInt(words[2], &b) &&
+            (unsigned)r <= 255 && (unsigned)g <= 255 && (unsigned)b <= 255) {
+            *color = COLOR_RGB(r, g, b);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Line endpoints beyond LINE_MAX_COORD and radii beyond what the circle
+// and marker functions draw are errors, not shapes that silently vanish.
+// Returns the index of the first argument out of range, or -1.
+static int argumentOutOfRange(const SceneCommand* command) {
+    switch (command->op) {
+    case SCENE_LINE:
+        for (int i = 0; i < 4; i++) {
+            if (command->v[i] < -LINE_MAX_COORD || command->v[i] > LINE_MAX_COORD) {
+                return i;
+            }
+        }
+        return -1;
+    case SCENE_CIRCLE:
+    case SCENE_DISC:
+    case SCENE_RING:
+        return command->v[2] >= 0 && command->v[2] <= CIRCLE_MAX_RADIUS ? -1 : 2;
+    case SCENE_MARKER:
+        return command->v[2] >= 0 && command->v[2] <= MARKER_MAX_RADIUS ? -1 : 2;
+    default:
+        return -1;
+    }
+}
+
+// What the argument argumentOutOfRange finds is called in the error
+static const char* argumentName(const SceneCommand* command) {
+    return command->op == SCENE_LINE ? "coordinate" : "radius";
+}
+
+static int readTextCommand(SceneReader* reader, SceneCommand* command) {
+    char* line;
+    char* words[SCENE_MAX_WORDS];
+    int status;
+
+    while ((status = nextTextLine(reader, &line)) > 0) {
+        line += strspn(line, " \t\r");
+        if (*line == '#') {
+            continue;       // comment
+        }
+        int count = splitWords(line, words);
+        if (count == 0) {
+            continue;
+        }
+        if (count < 0) {
+            snprintf(reader->error, sizeof(reader->error), "line %ld: too many words", reader->line);
+            return -1;
+        }
+
+        if (strcmp(words[0], "color") == 0) {
+            if (!parseColor(words + 1, count - 1, &reader->color)) {
+                snprintf(reader->error, sizeof(reader->error),
+                         "line %ld: expected color #RRGGBB or color r g b", reader->line);
+                return -1;
+            }
+            continue;
+        }
+
+        int op = 0;
+        while (op < (int)(sizeof(opNames) / sizeof(opNames[0])) && strcmp(words[0], opNames[op]) != 0) {
+            op++;
+        }
+        if (op == (int)(sizeof(opNames) / sizeof(opNames[0]))) {
+            snprintf(reader->error, sizeof(reader->error), "line %ld: unknown command '%.32s'",
+                     reader->line, words[0]);
+            return -1;
+        }
+        if (count - 1 != opArguments[op]) {
+            snprintf(reader->error, sizeof(reader->error), "line %ld: %s takes %d arguments",
+                     reader->line, opNames[op], opArguments[op]);
+            return -1;
+        }
+
+        command->op = (SceneOp)op;
+        command->color = reader->color;
+        if (op == SCENE_ALGORITHM) {
+            int algorithm = 0;
+            while (algorithm <= LINE_WU && strcmp(words[1], algorithmNames[algorithm]) != 0) {
+                algorithm++;
+            }
+            if (algorithm > LINE_WU) {
+                snprintf(reader->error, sizeof(reader->error), "line %ld: unknown algorithm '%.32s'",
+                         reader->line, words[1]);
+                return -1;
+            }
+            command->v[0] = algorithm;
+            return 1;
+        }
+        for (int i = 0; i < opArguments[op]; i++) {
+            if (!parseInt(words[i + 1], &command->v[i])) {
+                snprintf(reader->error, sizeof(reader->error), "line %ld: '%.32s' is not an integer",
+                         reader->line, words[i + 1]);
+                return -1;
+            }
+        }
+        int bad = argumentOutOfRange(command);
+        if (bad >= 0) {
+            snprintf(reader->error, sizeof(reader->error), "line %ld: %s %d out of range",
+                     reader->line, argumentName(command), command->v[bad]);
+            return -1;
+        }
+        return 1;
+    }
+
+    if (status < 0) {
+        snprintf(reader->error, sizeof(reader->error), "line %ld: longer than %d bytes",
+                 reader->line + 1, SCENE_READ_CHUNK - 1);
+        return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------- binary
+
+static int readBinaryCommand(SceneReader* reader, SceneCommand* command) {
+    for (;;) {
+        if (!requireBytes(reader, 1)) {
+            return 0;
+        }
+
+        int opcode = reader->buffer[reader->start];
+        int op = opcode - 1;
+        int arguments = opcode == SCENE_OP_COLOR ? 1
+                      : op >= 0 && op <= SCENE_MARKER ? binaryArguments[op] : -1;
+        if (arguments < 0) {
+            snprintf(reader->error, sizeof(reader->error), "offset %ld: unknown opcode %d",
+                     reader->offset, opcode);
+            return -1;
+        }
+        if (!requireBytes(reader, 1 + 4 * (size_t)arguments)) {
+            snprintf(reader->error, sizeof(reader->error), "offset %ld: file ends inside a command",
+                     reader->offset);
+            return -1;
+        }
+
+        const unsigned char* p = reader->buffer + reader->start + 1;
+        reader->start += 1 + 4 * (size_t)arguments;
+        reader->offset += 1 + 4L * arguments;
+
+        if (opcode == SCENE_OP_COLOR) {
+            reader->color = (Color)readLittle32(p) & 0xFFFFFF;
+            continue;
+        }
+
+        command->op = (SceneOp)op;
+        command->color = reader->color;
+        for (int i = 0; i < arguments; i++) {
+            command->v[i] = (int32_t)readLittle32(p + 4 * i);
+        }
+        if (op == SCENE_CLEAR) {
+            command->color = (Color)command->v[0] & 0xFFFFFF;
+        }
+        if (op == SCENE_ALGORITHM && (unsigned)command->v[0] > LINE_WU) {
+            snprintf(reader->error, sizeof(reader->error), "offset %ld: unknown algorithm %d",
+                     reader->offset - 5, command->v[0]);
+            return -1;
+        }
+        int bad = argumentOutOfRange(command);
+        if (bad >= 0) {
+            snprintf(reader->error, sizeof(reader->error), "offset %ld: %s %d out of range",
+                     reader->offset - 1 - 4L * arguments, argumentName(command), command->v[bad]);
+            return -1;
+        }
+        return 1;
+    }
+}
+
+// ---------------------------------------------------------------- reader
+
+SceneReader* openSceneReader(FILE* in, const char** error) {
+    const char* ignored;
+    SceneReader* reader = malloc(sizeof(SceneReader));
+    error = error ? error : &ignored;
+    if (!reader) {
+        *error = "out of memory";
+        return NULL;
+    }
+
+    reader->in = in;
+    reader->color = COLOR_BLACK;
+    reader->line = 0;
+    reader->offset = SCENE_HEADER_BYTES;
+    reader->start = reader->end = 0;
+    reader->eof = 0;
+    reader->error[0] = '\0';
+
+    requireBytes(reader, SCENE_HEADER_BYTES);
+    reader->binary = reader->end >= 4 && memcmp(reader->buffer, SCENE_MAGIC, 4) == 0;
+
+    if (reader->binary) {
+        const unsigned char* p = reader->buffer;
+        if (reader->end < SCENE_HEADER_BYTES || p[4] != SCENE_VERSION) {
+            *error = "unsupported binary scene header";
+            free(reader);
+            return NULL;
+        }
+        reader->width = (int32_t)readLittle32(p + 8);
+        reader->height = (int32_t)readLittle32(p + 12);
+        reader->start = SCENE_HEADER_BYTES;
+    } else {
+        // The first command must be the canvas size
+        char* line;
+        char* words[SCENE_MAX_WORDS];
+        int count = 0;
+        int status;
+
+        while ((status = nextTextLine(reader, &line)) > 0) {
+            line += strspn(line, " \t\r");
+            if (*line != '#' && (count = splitWords(line, words)) != 0) {
+                break;
+            }
+        }
+        if (status <= 0 || count != 3 || strcmp(words[0], "canvas") != 0 ||
+            !parseInt(words[1], &reader->width) || !parseInt(words[2], &reader->height)) {
+            *error = "a scene starts with: canvas <width> <height>";
+            free(reader);
+            return NULL;
+        }
+    }
+
+    if (reader->width <= 0 || reader->height <= 0 ||
+        reader->width > SCENE_MAX_CANVAS || reader->height > SCENE_MAX_CANVAS) {
+        *error = "canvas size out of range";
+        free(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+void closeSceneReader(SceneReader* reader) {
+    free(reader);
+}
+
+void sceneCanvasSize(const SceneReader* reader, int* width, int* height) {
+    *width = reader->width;
+    *height = reader->height;
+}
+
+int sceneReaderIsBinary(const SceneReader* reader) {
+    return reader->binary;
+}
+
+int readSceneCommand(SceneReader* reader, SceneCommand* command) {
+    int status = reader->binary ? readBinaryCommand(reader, command) : readTextCommand(reader, command);
+
+    if (status == 0 && ferror(reader->in)) {
+        snprintf(reader->error, sizeof(reader->error), "read error");
+        return -1;
+    }
+    return status;
+}
+
+const char* sceneReaderError(const SceneReader* reader) {
+    return reader->error;
+}
+
+// ---------------------------------------------------------------- drawing
+
+// Commands waiting for one batch call. Only one kind is pending at a
+// time, so batches are drawn in file order.
+typedef struct {
+    Framebuffer* fb;
+    SceneStats* stats;
+    SceneOp pending;            // SCENE_LINE, SCENE_CIRCLE/DISC/RING or SCENE_MARKER
+    size_t count;
+    LineAlgorithm algorithm;
+    int thickness;              // rings
+    int radius;                 // markers
+    union {
+        Segment segments[SCENE_BATCH];
+        Circle circles[SCENE_BATCH];
+        Marker markers[SCENE_BATCH];
+    } batch;
+} SceneBatch;
+
+static void flushBatch(SceneBatch* batch) {
+    if (batch->count == 0) {
+        return;
+    }
+
+    switch (batch->pending) {
+    case SCENE_LINE:
+        drawLineBatch(batch->fb, batch->batch.segments, batch->count, batch->algorithm, NULL);
+        batch->stats->lines += batch->count;
+        break;
+    case SCENE_CIRCLE:
+    case SCENE_DISC:
+    case SCENE_RING:
+        drawCircleBatch(batch->fb, batch->batch.circles, batch->count,
+                        batch->pending == SCENE_CIRCLE ? CIRCLE_OUTLINE :
+                        batch->pending == SCENE_DISC ? CIRCLE_FILLED : CIRCLE_RING,
+                        batch->thickness, NULL);
+        batch->stats->circles += batch->count;
+        break;
+    case SCENE_MARKER:
+    default:
+        drawMarkerBatch(batch->fb, batch->batch.markers, batch->count, batch->radius, NULL);
+        batch->stats->markers += batch->count;
+        break;
+    }
+    batch->count = 0;
+}
+
+// Make `op` the pending kind, drawing what is pending if it cannot share
+// a batch with it
+static void startBatch(SceneBatch* batch, SceneOp op, int thickness, int radius) {
+    if (batch->count > 0 &&
+        (batch->pending != op || batch->count == SCENE_BATCH ||
+         (op == SCENE_RING && batch->thickness != thickness) ||
+         (op == SCENE_MARKER && batch->radius != radius))) {
+        flushBatch(batch);
+    }
+    batch->pending = op;
+    batch->thickness = thickness;
+    batch->radius = radius;
+}
+
+int drawSceneFile(SceneReader* reader, Framebuffer* fb, SceneStats* stats) {
+    SceneStats ignored;
+    double start = batchClock();
+    SceneCommand command;
+    int status;
+
+    stats = stats ? stats : &ignored;
+    memset(stats, 0, sizeof(SceneStats));
+
+    SceneBatch* batch = malloc(sizeof(SceneBatch));
+    if (!batch) {
+        snprintf(reader->error, sizeof(reader->error), "out of memory");
+        return 0;
+    }
+    batch->fb = fb;
+    batch->stats = stats;
+    batch->pending = SCENE_LINE;
+    batch->count = 0;
+    batch->algorithm = LINE_BRESENHAM;
+    batch->thickness = 0;
+    batch->radius = 0;
+
+    while ((status = readSceneCommand(reader, &command)) > 0) {
+        const int* v = command.v;
+        stats->commands++;
+
+        switch (command.op) {
+        case SCENE_CLEAR:
+            flushBatch(batch);
+            clearFramebuffer(fb, command.color);
+            break;
+        case SCENE_ALGORITHM:
+            if (batch->pending == SCENE_LINE) {
+                flushBatch(batch);
+            }
+            batch->algorithm = (LineAlgorithm)v[0];
+            break;
+        case SCENE_LINE: {
+            startBatch(batch, SCENE_LINE, 0, 0);
+            Segment* s = &batch->batch.segments[batch->count++];
+            s->x1 = v[0];
+            s->y1 = v[1];
+            s->x2 = v[2];
+            s->y2 = v[3];
+            s->color = command.color;
+            break;
+        }
+        case SCENE_CIRCLE:
+        case SCENE_DISC:
+        case SCENE_RING: {
+            startBatch(batch, command.op, command.op == SCENE_RING ? v[3] : 0, 0);
+            Circle* c = &batch->batch.circles[batch->count++];
+            c->xc = v[0];
+            c->yc = v[1];
+            c->radius = v[2];
+            c->color = command.color;
+            break;
+        }
+        case SCENE_MARKER:
+        default: {
+            startBatch(batch, SCENE_MARKER, 0, v[2]);
+            Marker* m = &batch->batch.markers[batch->count++];
+            m->x = v[0];
+            m->y = v[1];
+            m->color = command.color;
+            break;
+        }
+        }
+    }
+    flushBatch(batch);
+    free(batch);
+
+    stats->seconds = batchClock() - start;
+    return status == 0;
+}
+
+// ---------------------------------------------------------------- writing
+
+int writeSceneHeader(FILE* out, int width, int height) {
+    unsigned char header[SCENE_HEADER_BYTES] = { 'R', 'S', 'C', 'N', SCENE_VERSION, 0, 0, 0 };
+
+    writeLittle32(header + 8, (uint32_t)width);
+    writeLittle32(header + 12, (uint32_t)height);
+    return fwrite(header, 1, sizeof(header), out) == sizeof(header);
+}
+
+int writeSceneCommand(FILE* out, const SceneCommand* command, Color* color) {
+    unsigned char record[5 + 1 + 4 * 4];    // color change, opcode, arguments
+    size_t size = 0;
+    int op = (int)command->op;
+
+    if (op != SCENE_CLEAR && op != SCENE_ALGORITHM && command->color != *color) {
+        record[size++] = SCENE_OP_COLOR;
+        writeLittle32(record + size, command->color);
+        size += 4;
+        *color = command->color;
+    }
+
+    record[size++] = (unsigned char)(op + 1);
+    for (int i = 0; i < binaryArguments[op]; i++, size += 4) {
+        writeLittle32(record + size, op == SCENE_CLEAR ? command->color : (uint32_t)command->v[i]);
+    }
+    return fwrite(record, 1, size, out) == size;
+}
@@ -0,0 +1,100 @@
+#ifndef RASTER_SCENEFILE_H
+#define RASTER_SCENEFILE_H
+
+#include <stdio.h>
+#include "raster.h"
+
+// Scene files: drawing commands streamed from disk.
+//
+// A scene file gives its canvas size, then a list of drawing commands. The
+// reader pulls the input through a fixed buffer one chunk at a time and
+// hands out one command per call, so a file of any size is rendered in
+// constant memory. There are two encodings, told apart by their first
+// bytes.
+//
+// Text, one command per line; lines starting with '#' are comments:
+//
+//     canvas 800 600                  (first command, required)
+//     color #RRGGBB | color r g b     (color of the commands after it; black at first)
+//     clear                           (fill the canvas with the current color)
+//     algorithm bresenham | dda | dda-fixed | dda-simd | run-slice | wu
+//     line x1 y1 x2 y2
+//     circle xc yc radius             (outline)
+//     disc xc yc radius
+//     ring xc yc radius thickness
+//     marker x y radius
+//
+// Line coordinates run from -LINE_MAX_COORD to LINE_MAX_COORD, and radii
+// from 0 to CIRCLE_MAX_RADIUS (MARKER_MAX_RADIUS for markers); others are
+// reported as errors.
+//
+// Binary: the 4 bytes "RSCN", a version byte (1), 3 zero bytes, then the
+// canvas width and height. Each command that follows is an opcode byte
+// (SceneOp + 1, or SCENE_OP_COLOR) and its arguments. Every integer is
+// 32-bit little-endian; colors are 0xRRGGBB.
+
+typedef enum {
+    SCENE_CLEAR,        // color
+    SCENE_ALGORITHM,    // v[0]: the LineAlgorithm of the lines after it
+    SCENE_LINE,         // v: x1, y1, x2, y2
+    SCENE_CIRCLE,       // v: xc, yc, radius
+    SCENE_DISC,         // v: xc, yc, radius
+    SCENE_RING,         // v: xc, yc, radius, thickness
+    SCENE_MARKER        // v: x, y, radius
+} SceneOp;
+
+// Binary opcode of a color change, which the reader applies itself
+#define SCENE_OP_COLOR 0x80
+
+// Bytes the reader pulls in at a time; also the longest text line
+#define SCENE_READ_CHUNK 65536
+
+// Largest canvas side a scene file may ask for
+#define SCENE_MAX_CANVAS 65536
+
+typedef struct {
+    SceneOp op;
+    int v[4];
+    Color color;        // current color, for every command
+} SceneCommand;
+
+typedef struct SceneReader SceneReader;
+
+// Start reading a scene from `in` (not closed by the reader) and read its
+// canvas size. Returns NULL if the input is not a scene file or memory
+// runs out; *error, if given, then points at a static message.
+SceneReader* openSceneReader(FILE* in, const char** error);
+
+void closeSceneReader(SceneReader* reader);
+
+void sceneCanvasSize(const SceneReader* reader, int* width, int* height);
+
+// Whether the input is the binary encoding
+int sceneReaderIsBinary(const SceneReader* reader);
+
+// Read the next command: returns 1, or 0 at the end of the file, or -1 on
+// a malformed command or read error (see sceneReaderError)
+int readSceneCommand(SceneReader* reader, SceneCommand* command);
+
+// What went wrong, with the line (text) or byte offset (binary)
+const char* sceneReaderError(const SceneReader* reader);
+
+typedef struct {
+    size_t commands;
+    size_t lines, circles, markers;
+    double seconds;
+} SceneStats;
+
+// Draw every remaining command of `reader` into `fb` (normally the canvas
+// size). Consecutive lines, circles and markers are drawn as batches, in
+// file order. Returns 1, or 0 if the file is malformed; the commands
+// before the error are drawn. `stats` may be NULL.
+int drawSceneFile(SceneReader* reader, Framebuffer* fb, SceneStats* stats);
+
+// Binary encoding: write the header, then each command. `color` holds the
+// color written last and starts out as COLOR_BLACK; a color change is only
+// written when a command needs it. Return 0 on a write error.
+int writeSceneHeader(FILE* out, int width, int height);
+int writeSceneCommand(FILE* out, const SceneCommand* command, Color* color);
+
+#endif
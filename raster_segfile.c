@@ -0,0 +1,291 @@
+#define _POSIX_C_SOURCE 200112L
+#define _FILE_OFFSET_BITS 64
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "raster_internal.h"
+#include "raster_segfile.h"
+
+#define SEGMENT_FILE_VERSION 1
+#define SEGMENT_COLUMNS 5
+
+// Columns are padded to a multiple of this many elements (64 bytes)
+#define SEGMENT_STRIDE_ALIGN 16
+
+// Elements per column a new writer starts with; doubled as it fills
+#define SEGMENT_WRITER_INITIAL 4096
+
+struct SegmentFile {
+    void* map;
+    size_t size;
+    int width, height;
+    LineAlgorithm algorithm;
+    Color background;
+    SegmentColumns columns;
+};
+
+struct SegmentWriter {
+    int fd;
+    unsigned char* map;
+    size_t stride;          // elements per column in the current mapping
+    size_t count;
+    unsigned char header[SEGMENT_FILE_HEADER];
+};
+
+// The columns are used in place, so they must be in host byte order
+static int littleEndianHost(void) {
+    const uint32_t one = 1;
+    return *(const unsigned char*)&one == 1;
+}
+
+// File size for columns of `stride` elements, or 0 if it does not fit
+static size_t segmentFileSize(uint64_t stride) {
+    if (stride > (SIZE_MAX - SEGMENT_FILE_HEADER) / (SEGMENT_COLUMNS * sizeof(int32_t))) {
+        return 0;
+    }
+    return SEGMENT_FILE_HEADER + (size_t)stride * SEGMENT_COLUMNS * sizeof(int32_t);
+}
+
+static unsigned char* columnAt(unsigned char* map, size_t stride, int column) {
+    return map + SEGMENT_FILE_HEADER + stride * sizeof(int32_t) * (size_t)column;
+}
+
+SegmentFile* openSegmentFile(const char* path, const char** error) {
+    const char* ignored;
+    if (!error) {
+        error = &ignored;
+    }
+    if (!littleEndianHost()) {
+        *error = "segment files are only mapped on little-endian hosts";
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        *error = "cannot open the file";
+        return NULL;
+    }
+
+    struct stat info;
+    unsigned char header[SEGMENT_FILE_HEADER];
+    if (fstat(fd, &info) != 0 || info.st_size < SEGMENT_FILE_HEADER ||
+        read(fd, header, SEGMENT_FILE_HEADER) != SEGMENT_FILE_HEADER ||
+        memcmp(header, SEGMENT_FILE_MAGIC, 4) != 0) {
+        *error = "not a segment file";
+        close(fd);
+        return NULL;
+    }
+
+    int32_t width = (int32_t)readLittle32(header + 8);
+    int32_t height = (int32_t)readLittle32(header + 12);
+    uint32_t algorithm = readLittle32(header + 16);
+    uint64_t count = readLittle64(header + 24);
+    uint64_t stride = readLittle64(header + 32);
+    size_t size = segmentFileSize(stride);
+
+    if (readLittle32(header + 4) != SEGMENT_FILE_VERSION) {
+        *error = "unsupported segment file version";
+    } else if (width <= 0 || height <= 0 || width > SEGMENT_MAX_CANVAS || height > SEGMENT_MAX_CANVAS) {
+        *error = "canvas size out of range";
+    } else if (algorithm > LINE_WU) {
+        *error = "unknown line algorithm";
+    } else if (stride % SEGMENT_STRIDE_ALIGN != 0 || count > stride || size == 0 ||
+               (uint64_t)info.st_size < size) {
+        *error = "segment file is truncated or corrupt";
+    } else {
+        *error = NULL;
+    }
+    if (*error) {
+        close(fd);
+        return NULL;
+    }
+
+    SegmentFile* file = malloc(sizeof(SegmentFile));
+    if (!file) {
+        *error = "out of memory";
+        close(fd);
+        return NULL;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    file->map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (file->map == MAP_FAILED) {
+        *error = "cannot map the file";
+        free(file);
+        return NULL;
+    }
+#ifdef POSIX_MADV_SEQUENTIAL
+    // Each column is read front to back: ask for aggressive read-ahead
+    posix_madvise(file->map, size, POSIX_MADV_SEQUENTIAL);
+#endif
+
+    file->size = size;
+    file->width = width;
+    file->height = height;
+    file->algorithm = (LineAlgorithm)algorithm;
+    file->background = (Color)readLittle32(header + 20) & 0xFFFFFF;
+    file->columns.x1 = (const int32_t*)columnAt(file->map, stride, 0);
+    file->columns.y1 = (const int32_t*)columnAt(file->map, stride, 1);
+    file->columns.x2 = (const int32_t*)columnAt(file->map, stride, 2);
+    file->columns.y2 = (const int32_t*)columnAt(file->map, stride, 3);
+    file->columns.color = (const Color*)columnAt(file->map, stride, 4);
+    file->columns.count = (size_t)count;
+    return file;
+}
+
+void closeSegmentFile(SegmentFile* file) {
+    if (!file) {
+        return;
+    }
+    munmap(file->map, file->size);
+    free(file);
+}
+
+const SegmentColumns* segmentFileColumns(const SegmentFile* file) {
+    return &file->columns;
+}
+
+void segmentFileCanvas(const SegmentFile* file, int* width, int* height) {
+    *width = file->width;
+    *height = file->height;
+}
+
+Color segmentFileBackground(const SegmentFile* file) {
+    return file->background;
+}
+
+LineAlgorithm segmentFileAlgorithm(const SegmentFile* file) {
+    return file->algorithm;
+}
+
+// Resize the file for columns of `stride` elements and map it again,
+// moving the columns to their new offsets. Returns 0 on failure, leaving
+// the writer unmapped.
+static int remapWriter(SegmentWriter* writer, size_t stride) {
+    size_t oldSize = segmentFileSize(writer->stride);
+    size_t size = segmentFileSize(stride);
+    size_t used = writer->count * sizeof(int32_t);
+
+    if (size == 0) {
+        munmap(writer->map, oldSize);
+        writer->map = NULL;
+        return 0;
+    }
+
+    // Packing moves columns down, so it runs before the file shrinks
+    if (stride < writer->stride) {
+        for (int c = 1; c < SEGMENT_COLUMNS; c++) {
+            memmove(columnAt(writer->map, stride, c), columnAt(writer->map, writer->stride, c), used);
+        }
+    }
+    munmap(writer->map, oldSize);
+    writer->map = NULL;
+    if (ftruncate(writer->fd, (off_t)size) != 0) {
+        return 0;
+    }
+
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, writer->fd, 0);
+    if (map == MAP_FAILED) {
+        return 0;
+    }
+    writer->map = map;
+
+    // Growing moves columns up, the last one first
+    if (stride > writer->stride) {
+        for (int c = SEGMENT_COLUMNS - 1; c > 0; c--) {
+            memmove(columnAt(writer->map, stride, c), columnAt(writer->map, writer->stride, c), used);
+        }
+    }
+    writer->stride = stride;
+    return 1;
+}
+
+SegmentWriter* createSegmentWriter(const char* path, int width, int height,
+                                   LineAlgorithm algorithm, Color background) {
+    if (!littleEndianHost() || width <= 0 || height <= 0 ||
+        width > SEGMENT_MAX_CANVAS || height > SEGMENT_MAX_CANVAS) {
+        return NULL;
+    }
+
+    SegmentWriter* writer = calloc(1, sizeof(SegmentWriter));
+    if (!writer) {
+        return NULL;
+    }
+    memcpy(writer->header, SEGMENT_FILE_MAGIC, 4);
+    writeLittle32(writer->header + 4, SEGMENT_FILE_VERSION);
+    writeLittle32(writer->header + 8, (uint32_t)width);
+    writeLittle32(writer->header + 12, (uint32_t)height);
+    writeLittle32(writer->header + 16, (uint32_t)algorithm);
+    writeLittle32(writer->header + 20, background & 0xFFFFFF);
+
+    writer->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0) {
+        free(writer);
+        return NULL;
+    }
+
+    // Until it is finished the file has no valid header, so a writer that
+    // never finishes leaves a file openSegmentFile rejects
+    size_t size = segmentFileSize(SEGMENT_WRITER_INITIAL);
+    void* map = MAP_FAILED;
+    if (ftruncate(writer->fd, (off_t)size) == 0) {
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, writer->fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        close(writer->fd);
+        free(writer);
+        return NULL;
+    }
+    writer->map = map;
+    writer->stride = SEGMENT_WRITER_INITIAL;
+    return writer;
+}
+
+int writeSegment(SegmentWriter* writer, const Segment* segment) {
+    if (!writer->map) {
+        return 0;
+    }
+    if (writer->count == writer->stride && !remapWriter(writer, 2 * writer->stride)) {
+        return 0;
+    }
+
+    int32_t* x1 = (int32_t*)columnAt(writer->map, writer->stride, 0);
+    int32_t* y1 = (int32_t*)columnAt(writer->map, writer->stride, 1);
+    int32_t* x2 = (int32_t*)columnAt(writer->map, writer->stride, 2);
+    int32_t* y2 = (int32_t*)columnAt(writer->map, writer->stride, 3);
+    Color* color = (Color*)columnAt(writer->map, writer->stride, 4);
+    size_t i = writer->count++;
+
+    x1[i] = segment->x1;
+    y1[i] = segment->y1;
+    x2[i] = segment->x2;
+    y2[i] = segment->y2;
+    color[i] = segment->color & 0xFFFFFF;
+    return 1;
+}
+
+int finishSegmentWriter(SegmentWriter* writer) {
+    size_t stride = (writer->count + SEGMENT_STRIDE_ALIGN - 1) / SEGMENT_STRIDE_ALIGN *
+                    SEGMENT_STRIDE_ALIGN;
+    int ok = writer->map != NULL && remapWriter(writer, stride);
+
+    if (ok) {
+        writeLittle64(writer->header + 24, writer->count);
+        writeLittle64(writer->header + 32, writer->stride);
+        memcpy(writer->map, writer->header, SEGMENT_FILE_HEADER);
+        munmap(writer->map, segmentFileSize(writer->stride));
+    } else if (writer->map) {
+        munmap(writer->map, segmentFileSize(writer->stride));
+    }
+    if (close(writer->fd) != 0) {
+        ok = 0;
+    }
+    free(writer);
+    return ok;
+}
@@ -0,0 +1,73 @@
+#ifndef RASTER_SEGFILE_H
+#define RASTER_SEGFILE_H
+
+#include "raster.h"
+
+// Segment files: line segments in a fixed binary layout that is drawn
+// straight from a memory mapping.
+//
+// The file is a 64-byte header followed by five columns of 32-bit
+// little-endian integers: x1[], y1[], x2[], y2[] and color[] (0xRRGGBB).
+// Every column starts on a 64-byte boundary and holds `stride` elements,
+// of which the first `count` are segments. Opening a file maps it and
+// points a SegmentColumns at the columns, so there is no parse step and
+// no copy: drawLineColumns reads the endpoints from the page cache.
+// Nor are the endpoints checked on opening. The line kernels skip every
+// segment with an endpoint beyond LINE_MAX_COORD (raster.h) themselves,
+// so any file is safe to draw.
+//
+// Header (all fields little-endian):
+//
+//     offset  0   "RSEG"
+//             4   version (1)
+//             8   canvas width, height
+//            16   line algorithm (LineAlgorithm)
+//            20   background color
+//            24   count (64-bit)
+//            32   stride (64-bit, a multiple of 16)
+//            40   zero up to offset 64
+//
+// Column c (x1 = 0 ... color = 4) starts at 64 + 4 * stride * c.
+
+#define SEGMENT_FILE_MAGIC "RSEG"
+#define SEGMENT_FILE_HEADER 64
+
+// Largest canvas side a segment file may ask for
+#define SEGMENT_MAX_CANVAS 65536
+
+typedef struct SegmentFile SegmentFile;
+
+// Map the segment file at `path` read-only and check its header. Returns
+// NULL if it cannot be opened or is not a valid segment file (or the host
+// is big-endian); *error, if given, then points at a static message.
+SegmentFile* openSegmentFile(const char* path, const char** error);
+
+// Unmap; the columns are invalid afterwards
+void closeSegmentFile(SegmentFile* file);
+
+// The segments, pointing into the mapping
+const SegmentColumns* segmentFileColumns(const SegmentFile* file);
+
+void segmentFileCanvas(const SegmentFile* file, int* width, int* height);
+
+// What the canvas is cleared to before drawing, and the algorithm to draw with
+Color segmentFileBackground(const SegmentFile* file);
+LineAlgorithm segmentFileAlgorithm(const SegmentFile* file);
+
+typedef struct SegmentWriter SegmentWriter;
+
+// Create (or truncate) a segment file at `path` and map it for writing.
+// The segment count need not be known: the columns are spaced out as the
+// file grows and packed together by finishSegmentWriter. Returns NULL on
+// failure.
+SegmentWriter* createSegmentWriter(const char* path, int width, int height,
+                                   LineAlgorithm algorithm, Color background);
+
+// Append one segment; returns 0 if the file could not grow
+int writeSegment(SegmentWriter* writer, const Segment* segment);
+
+// Pack the columns, write the header and close. Returns 0 if the file
+// could not be finished. Frees the writer either way.
+int finishSegmentWriter(SegmentWriter* writer);
+
+#endif
@@ -0,0 +1,233 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "raster.h"
+#include "raster_internal.h"
+#include "raster_trace.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define RASTER_X86_SIMD 1
+#endif
+
+// Vectorized fixed-point DDA.
+//
+// Pixel i of a line sits at major offset i and minor offset
+// floor(bias + i * increment) in 32.32 fixed point, so a block of steps can
+// be produced at once: each lane keeps its own accumulator split into
+// 32-bit low/high words and advances by lanes * increment per iteration,
+// with the carry out of the low word detected by an unsigned compare. The
+// high words are the minor offsets; one multiply-add turns them into pixel
+// indices, which are then stored through scalar 3-byte writes (there is no
+// byte scatter before AVX-512). The result is bit-identical to
+// drawLineDDAFixed and therefore to drawLineBresenham.
+
+// Lines shorter than this are not worth the vector setup
+#define SIMD_MIN_STEPS 16
+
+// Level in use. Pool workers read it while drawing, so it is set once
+// through pthread_once and accessed atomically after that.
+static int simdLevel = SIMD_SCALAR;
+static pthread_once_t simdLevelOnce = PTHREAD_ONCE_INIT;
+
+SimdLevel detectSimdLevel(void) {
+#ifdef RASTER_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SIMD_SSE2;
+    }
+#endif
+    return SIMD_SCALAR;
+}
+
+static void initSimdLevel(void) {
+    __atomic_store_n(&simdLevel, (int)detectSimdLevel(), __ATOMIC_RELAXED);
+}
+
+SimdLevel activeSimdLevel(void) {
+    pthread_once(&simdLevelOnce, initSimdLevel);
+    return (SimdLevel)__atomic_load_n(&simdLevel, __ATOMIC_RELAXED);
+}
+
+void setSimdLevel(SimdLevel level) {
+    SimdLevel supported = detectSimdLevel();
+
+    // After the detection, so a first activeSimdLevel cannot overwrite it
+    pthread_once(&simdLevelOnce, initSimdLevel);
+    __atomic_store_n(&simdLevel, (int)(level < supported ? level : supported), __ATOMIC_RELAXED);
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SIMD_AVX2:
+        return "avx2";
+    case SIMD_SSE2:
+        return "sse2";
+    case SIMD_SCALAR:
+    default:
+        return "scalar";
+    }
+}
+
+// Scalar tail shared by the vector kernels: steps [first, last]
+static inline void writeFixedSteps(Pixel* base, int first, int last, uint64_t increment,
+                                   long majorStep, long minorStep, Color color) {
+    uint64_t acc = FIXED_DDA_BIAS + (uint64_t)first * increment;
+
+    for (int i = first; i <= last; i++) {
+        writePixel(base + i * majorStep + (long)(acc >> 32) * minorStep, color);
+        acc += increment;
+    }
+}
+
+#ifdef RASTER_X86_SIMD
+
+__attribute__((target("sse2")))
+static inline __m128i mulloEpi32SSE2(__m128i a, __m128i b) {
+    // SSE2 only multiplies even lanes into 64-bit results; do odd lanes
+    // separately and interleave the low halves back together
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+__attribute__((target("sse2")))
+static void stepFixedSSE2(Pixel* base, int steps, uint64_t increment,
+                          long majorStep, long minorStep, Color color) {
+    uint32_t lo[4], hi[4], major[4];
+    for (int k = 0; k < 4; k++) {
+        uint64_t acc = FIXED_DDA_BIAS + (uint64_t)k * increment;
+        lo[k] = (uint32_t)acc;
+        hi[k] = (uint32_t)(acc >> 32);
+        major[k] = (uint32_t)(k * majorStep);
+    }
+
+    uint64_t blockIncrement = 4 * increment;
+    __m128i vLo = _mm_loadu_si128((const __m128i*)lo);
+    __m128i vHi = _mm_loadu_si128((const __m128i*)hi);
+    __m128i vMajor = _mm_loadu_si128((const __m128i*)major);
+    __m128i incLo = _mm_set1_epi32((int)(uint32_t)blockIncrement);
+    __m128i incHi = _mm_set1_epi32((int)(uint32_t)(blockIncrement >> 32));
+    __m128i incMajor = _mm_set1_epi32((int)(4 * majorStep));
+    __m128i vMinorStep = _mm_set1_epi32((int)minorStep);
+    __m128i sign = _mm_set1_epi32((int)0x80000000u);
+
+    int32_t index[4];
+    int i = 0;
+
+    for (; i + 3 <= steps; i += 4) {
+        _mm_storeu_si128((__m128i*)index, _mm_add_epi32(vMajor, mulloEpi32SSE2(vHi, vMinorStep)));
+        writePixel(base + index[0], color);
+        writePixel(base + index[1], color);
+        writePixel(base + index[2], color);
+        writePixel(base + index[3], color);
+
+        // Unsigned old > new means the low word wrapped; the mask is -1
+        __m128i next = _mm_add_epi32(vLo, incLo);
+        __m128i carry = _mm_cmpgt_epi32(_mm_xor_si128(vLo, sign), _mm_xor_si128(next, sign));
+        vHi = _mm_sub_epi32(_mm_add_epi32(vHi, incHi), carry);
+        vLo = next;
+        vMajor = _mm_add_epi32(vMajor, incMajor);
+    }
+
+    writeFixedSteps(base, i, steps, increment, majorStep, minorStep, color);
+}
+
+__attribute__((target("avx2")))
+static void stepFixedAVX2(Pixel* base, int steps, uint64_t increment,
+                          long majorStep, long minorStep, Color color) {
+    uint32_t lo[8], hi[8], major[8];
+    for (int k = 0; k < 8; k++) {
+        uint64_t acc = FIXED_DDA_BIAS + (uint64_t)k * increment;
+        lo[k] = (uint32_t)acc;
+        hi[k] = (uint32_t)(acc >> 32);
+        major[k] = (uint32_t)(k * majorStep);
+    }
+
+    uint64_t blockIncrement = 8 * increment;
+    __m256i vLo = _mm256_loadu_si256((const __m256i*)lo);
+    __m256i vHi = _mm256_loadu_si256((const __m256i*)hi);
+    __m256i vMajor = _mm256_loadu_si256((const __m256i*)major);
+    __m256i incLo = _mm256_set1_epi32((int)(uint32_t)blockIncrement);
+    __m256i incHi = _mm256_set1_epi32((int)(uint32_t)(blockIncrement >> 32));
+    __m256i incMajor = _mm256_set1_epi32((int)(8 * majorStep));
+    __m256i vMinorStep = _mm256_set1_epi32((int)minorStep);
+    __m256i sign = _mm256_set1_epi32((int)0x80000000u);
+
+    int32_t index[8];
+    int i = 0;
+
+    for (; i + 7 <= steps; i += 8) {
+        __m256i vIndex = _mm256_add_epi32(vMajor, _mm256_mullo_epi32(vHi, vMinorStep));
+        _mm256_storeu_si256((__m256i*)index, vIndex);
+        for (int k = 0; k < 8; k++) {
+            writePixel(base + index[k], color);
+        }
+
+        __m256i next = _mm256_add_epi32(vLo, incLo);
+        __m256i carry = _mm256_cmpgt_epi32(_mm256_xor_si256(vLo, sign), _mm256_xor_si256(next, sign));
+        vHi = _mm256_sub_epi32(_mm256_add_epi32(vHi, incHi), carry);
+        vLo = next;
+        vMajor = _mm256_add_epi32(vMajor, incMajor);
+    }
+
+    writeFixedSteps(base, i, steps, increment, majorStep, minorStep, color);
+}
+
+#endif
+
+void rasterizeLineFixedSimd(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    if (!lineInRange(x1, y1, x2, y2)) {
+        return;
+    }
+
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+    int xMajor = abs(dx) >= abs(dy);
+    int steps = xMajor ? abs(dx) : abs(dy);
+    int minorDelta = xMajor ? abs(dy) : abs(dx);
+    SimdLevel level = activeSimdLevel();
+
+    // Lanes hold pixel indices in 32 bits, so the vector path needs the
+    // whole line on screen and the framebuffer below 2^31 pixels
+    if (level == SIMD_SCALAR || fb->format != PIXEL_RGB24 ||
+        steps < SIMD_MIN_STEPS || steps > FIXED_DDA_MAX_STEPS ||
+        !insideFramebuffer(fb, x1, y1) || !insideFramebuffer(fb, x2, y2) ||
+        (long)fb->stride * fb->height > 0x7FFFFFFFL) {
+        rasterizeLineFixedScalar(fb, x1, y1, x2, y2, color);
+        return;
+    }
+
+#ifdef RASTER_X86_SIMD
+    long stepX = (dx < 0) ? -1 : 1;
+    long stepY = (dy < 0) ? -(long)fb->stride : fb->stride;
+    long majorStep = xMajor ? stepX : stepY;
+    long minorStep = xMajor ? stepY : stepX;
+    uint64_t increment = ((uint64_t)minorDelta << 32) / steps;
+    Pixel* base = pixelAt(fb, x1, y1);
+
+    if (level == SIMD_AVX2) {
+        stepFixedAVX2(base, steps, increment, majorStep, minorStep, color);
+    } else {
+        stepFixedSSE2(base, steps, increment, majorStep, minorStep, color);
+    }
+#else
+    (void)minorDelta;
+    rasterizeLineFixedScalar(fb, x1, y1, x2, y2, color);
+#endif
+}
+
+// SIMD DDA Line Drawing Algorithm
+void drawLineDDASimd(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    // Traced calls take the scalar kernel, which plots the same pixels
+    if (rasterTraceLevel != TRACE_OFF) {
+        drawLineDDAFixed(fb, x1, y1, x2, y2, color);
+        return;
+    }
+    rasterizeLineFixedSimd(fb, x1, y1, x2, y2, color);
+}
@@ -0,0 +1,473 @@
+#include <stdlib.h>
+#include <math.h>
+#include "raster.h"
+#include "raster_internal.h"
+
+// Wide lines and polylines.
+//
+// A stroke is a union of convex pieces. Each segment contributes a
+// quadrilateral: its centerline pushed out by half the width on both
+// sides, and lengthened by half the width for square caps. Each join adds
+// a triangle (bevel), a quadrilateral (miter) or a disc (round). Round
+// caps add a disc. A pixel is covered when its center lies inside a
+// piece. Boundaries are half-open, [left, right) and [top, bottom), as in
+// a polygon fill, so a horizontal line of width w covers exactly w rows.
+//
+// Every piece covers one span per row. The edges are stepped row by row
+// in floating point rather than with Bresenham's error term, since the
+// offset corners are not on the pixel grid. The pieces of a single line
+// overlap into one convex shape, so each row of it is the hull of the
+// pieces' spans. A polyline is not convex. Its spans are bucketed by row,
+// sorted and merged, so every covered pixel is written by exactly one
+// span however many pieces overlap there.
+
+// Polyline spans kept on the stack; longer strokes allocate them
+#define STROKE_STACK_SPANS 512
+
+// Miter limit used when the style does not set one (as in SVG)
+#define STROKE_DEFAULT_MITER_LIMIT 4.0
+
+// A convex piece. A polygon is kept as the lines through its sloped
+// edges, x = x0 + (y - y0) * slope: on every row, x is at least each
+// lower bound and below each upper bound, which leaves one span without
+// searching for the edges that cross the row.
+typedef struct {
+    double top, bottom;         // extent on the y axis
+    int disc;
+    double cx, cy, radius;      // discs
+    int lowerCount, upperCount;
+    double lower[4][3];         // x0, y0, slope
+    double upper[4][3];
+} StrokePiece;
+
+typedef struct {
+    int y, x0, x1;
+} StrokeSpan;
+
+typedef struct {
+    StrokeSpan* spans;
+    size_t count, capacity;
+    int failed;             // an allocation failed; spans were drawn directly
+    StrokeSpan stack[STROKE_STACK_SPANS];
+} SpanList;
+
+// Pixel column or row containing the first center at or after `v`, clamped
+// to [-1, limit] so huge coordinates stay in int range
+static inline int firstCenter(double v, int limit) {
+    if (v < -1.0) {
+        return -1;
+    }
+    if (v > limit) {
+        return limit;
+    }
+    return (int)ceil(v);
+}
+
+// Rows [first, last] whose centers the piece may cover, clipped to the
+// framebuffer; returns 0 if there are none
+static inline int pieceRows(const Framebuffer* fb, const StrokePiece* piece, int* first, int* last) {
+    *first = firstCenter(piece->top, fb->height);
+    *last = firstCenter(piece->bottom, fb->height) - 1;
+    if (*first < 0) {
+        *first = 0;
+    }
+    if (*last > fb->height - 1) {
+        *last = fb->height - 1;
+    }
+    return *first <= *last;
+}
+
+// Columns [x0, x1] the piece covers on row y, one of its rows; returns 0
+// if none
+static inline int pieceSpan(const Framebuffer* fb, const StrokePiece* piece, int y, int* x0, int* x1) {
+    double left, right;
+
+    if (piece->disc) {
+        double dy = y - piece->cy;
+        double squared = piece->radius * piece->radius - dy * dy;
+        if (squared <= 0.0) {
+            return 0;
+        }
+        left = piece->cx - sqrt(squared);
+        right = piece->cx + sqrt(squared);
+    } else {
+        left = -HUGE_VAL;
+        right = HUGE_VAL;
+        for (int i = 0; i < piece->lowerCount; i++) {
+            double x = piece->lower[i][0] + (y - piece->lower[i][1]) * piece->lower[i][2];
+            left = x > left ? x : left;
+        }
+        for (int i = 0; i < piece->upperCount; i++) {
+            double x = piece->upper[i][0] + (y - piece->upper[i][1]) * piece->upper[i][2];
+            right = x < right ? x : right;
+        }
+    }
+
+    *x0 = firstCenter(left, fb->width);
+    *x1 = firstCenter(right, fb->width) - 1;
+    return *x0 <= *x1;
+}
+
+// Make a polygon piece of `count` convex corners, in either winding
+static void polygonPiece(const double* x, const double* y, int count, StrokePiece* piece) {
+    double area = 0.0;
+    for (int i = 0; i < count; i++) {
+        int j = i + 1 < count ? i + 1 : 0;
+        area += x[i] * y[j] - x[j] * y[i];
+    }
+
+    piece->disc = 0;
+    piece->lowerCount = 0;
+    piece->upperCount = 0;
+    piece->top = piece->bottom = y[0];
+    if (area == 0.0) {
+        return;     // no rows
+    }
+
+    for (int i = 0; i < count; i++) {
+        int j = i + 1 < count ? i + 1 : 0;
+        double dy = y[j] - y[i];
+
+        piece->top = y[i] < piece->top ? y[i] : piece->top;
+        piece->bottom = y[i] > piece->bottom ? y[i] : piece->bottom;
+        if (dy == 0.0) {
+            continue;   // only limits the rows
+        }
+
+        // The inside is left of each edge for a positive area, so an edge
+        // running down bounds x from above, and one running up from below
+        double* bound = (dy > 0.0) == (area > 0.0) ? piece->upper[piece->upperCount++]
+                                                   : piece->lower[piece->lowerCount++];
+        bound[0] = x[i];
+        bound[1] = y[i];
+        bound[2] = (x[j] - x[i]) / dy;
+    }
+}
+
+// Body of the segment (x1, y1)-(x2, y2), lengthened by `startExtend` and
+// `endExtend` past its ends; returns 0 for a zero-length segment
+static int segmentPiece(double x1, double y1, double x2, double y2, double half,
+                        double startExtend, double endExtend, StrokePiece* piece) {
+    double length = hypot(x2 - x1, y2 - y1);
+    if (length == 0.0) {
+        return 0;
+    }
+
+    double ux = (x2 - x1) / length, uy = (y2 - y1) / length;
+    double nx = -uy * half, ny = ux * half;
+    double sx = x1 - ux * startExtend, sy = y1 - uy * startExtend;
+    double ex = x2 + ux * endExtend, ey = y2 + uy * endExtend;
+
+    double x[4] = { sx + nx, ex + nx, ex - nx, sx - nx };
+    double y[4] = { sy + ny, ey + ny, ey - ny, sy - ny };
+    polygonPiece(x, y, 4, piece);
+    return 1;
+}
+
+static void discPiece(double x, double y, double radius, StrokePiece* piece) {
+    piece->disc = 1;
+    piece->cx = x;
+    piece->cy = y;
+    piece->radius = radius;
+    piece->top = y - radius;
+    piece->bottom = y + radius;
+}
+
+// Axis-aligned square around a point, for a square-capped zero-length line
+static void squarePiece(double x, double y, double half, StrokePiece* piece) {
+    double xs[4] = { x - half, x + half, x + half, x - half };
+    double ys[4] = { y - half, y - half, y + half, y + half };
+    polygonPiece(xs, ys, 4, piece);
+}
+
+// Join at (x, y) from unit direction (ux0, uy0) into (ux1, uy1); returns 0
+// when the segments continue straight on and need none
+static int joinPiece(double x, double y, double ux0, double uy0, double ux1, double uy1,
+                     double half, const StrokeStyle* style, StrokePiece* piece) {
+    double cross = ux0 * uy1 - uy0 * ux1;
+    double dot = ux0 * ux1 + uy0 * uy1;
+
+    if (fabs(cross) < 1e-12 && dot > 0.0) {
+        return 0;
+    }
+    if (style->join == JOIN_ROUND) {
+        discPiece(x, y, half, piece);
+        return 1;
+    }
+
+    // The gap to fill is on the outer side of the turn, between the two
+    // segments' corners there
+    double side = cross > 0.0 ? -half : half;
+    double ax = x - uy0 * side, ay = y + ux0 * side;
+    double bx = x - uy1 * side, by = y + ux1 * side;
+
+    // Miter length over line width is 1 / sin(angle / 2) for the angle
+    // between the segments, sqrt(2 / (1 + dot)) in terms of the turn
+    double limit = style->miterLimit >= 1.0 ? style->miterLimit : STROKE_DEFAULT_MITER_LIMIT;
+    if (style->join == JOIN_MITER && dot > -1.0 && 2.0 / (1.0 + dot) <= limit * limit) {
+        double scale = side / (1.0 + dot);
+        double xs[4] = { x, ax, x - (uy0 + uy1) * scale, bx };
+        double ys[4] = { y, ay, y + (ux0 + ux1) * scale, by };
+        polygonPiece(xs, ys, 4, piece);
+    } else {
+        double xs[3] = { x, ax, bx };
+        double ys[3] = { y, ay, by };
+        polygonPiece(xs, ys, 3, piece);
+    }
+    return 1;
+}
+
+// The rows of the convex union of `pieces`, one span each
+static void fillConvexPieces(Framebuffer* fb, const StrokePiece* pieces, int count, Color color) {
+    int first = fb->height, last = -1;
+    int pieceFirst[3], pieceLast[3];
+
+    for (int i = 0; i < count; i++) {
+        if (!pieceRows(fb, &pieces[i], &pieceFirst[i], &pieceLast[i])) {
+            pieceLast[i] = -1;
+            pieceFirst[i] = 0;
+            continue;
+        }
+        first = pieceFirst[i] < first ? pieceFirst[i] : first;
+        last = pieceLast[i] > last ? pieceLast[i] : last;
+    }
+
+    for (int y = first; y <= last; y++) {
+        int x0 = fb->width, x1 = -1;
+
+        for (int i = 0; i < count; i++) {
+            int from, to;
+            if (y >= pieceFirst[i] && y <= pieceLast[i] && pieceSpan(fb, &pieces[i], y, &from, &to)) {
+                x0 = from < x0 ? from : x0;
+                x1 = to > x1 ? to : x1;
+            }
+        }
+        clippedSpan(fb, x0, x1, y, color);
+    }
+}
+
+static void initSpanList(SpanList* list) {
+    list->spans = list->stack;
+    list->count = 0;
+    list->capacity = STROKE_STACK_SPANS;
+    list->failed = 0;
+}
+
+static void freeSpanList(SpanList* list) {
+    if (list->spans != list->stack) {
+        free(list->spans);
+    }
+}
+
+// Record the spans of one piece. If the list cannot grow, the span is
+// drawn straight away: the pixels are the same, some just get written
+// twice.
+static void addPieceSpans(Framebuffer* fb, SpanList* list, const StrokePiece* piece, Color color) {
+    int first, last;
+    if (!pieceRows(fb, piece, &first, &last)) {
+        return;
+    }
+
+    for (int y = first; y <= last; y++) {
+        int x0, x1;
+        if (!pieceSpan(fb, piece, y, &x0, &x1)) {
+            continue;
+        }
+
+        if (list->count == list->capacity && !list->failed) {
+            size_t capacity = list->capacity * 2;
+            StrokeSpan* grown = list->spans == list->stack
+                ? malloc(sizeof(StrokeSpan) * capacity)
+                : realloc(list->spans, sizeof(StrokeSpan) * capacity);
+            if (grown) {
+                if (list->spans == list->stack) {
+                    for (size_t i = 0; i < list->count; i++) {
+                        grown[i] = list->stack[i];
+                    }
+                }
+                list->spans = grown;
+                list->capacity = capacity;
+            } else {
+                list->failed = 1;
+            }
+        }
+        if (list->count < list->capacity) {
+            StrokeSpan* span = &list->spans[list->count++];
+            span->y = y;
+            span->x0 = x0;
+            span->x1 = x1;
+        } else {
+            clippedSpan(fb, x0, x1, y, color);
+        }
+    }
+}
+
+// Bucket the spans by row (a counting sort), order each row by start and
+// fill the merged runs
+static void fillSpanList(Framebuffer* fb, SpanList* list, Color color) {
+    if (list->count == 0) {
+        return;
+    }
+
+    int top = list->spans[0].y, bottom = top;
+    for (size_t i = 1; i < list->count; i++) {
+        top = list->spans[i].y < top ? list->spans[i].y : top;
+        bottom = list->spans[i].y > bottom ? list->spans[i].y : bottom;
+    }
+
+    size_t rows = (size_t)(bottom - top) + 1;
+    size_t* start = calloc(rows + 1, sizeof(size_t));
+    StrokeSpan* sorted = malloc(sizeof(StrokeSpan) * list->count);
+    if (!start || !sorted) {
+        // Unsorted, every span on its own
+        for (size_t i = 0; i < list->count; i++) {
+            clippedSpan(fb, list->spans[i].x0, list->spans[i].x1, list->spans[i].y, color);
+        }
+        free(start);
+        free(sorted);
+        return;
+    }
+
+    for (size_t i = 0; i < list->count; i++) {
+        start[list->spans[i].y - top + 1]++;
+    }
+    for (size_t r = 0; r < rows; r++) {
+        start[r + 1] += start[r];
+    }
+    for (size_t i = 0; i < list->count; i++) {
+        sorted[start[list->spans[i].y - top]++] = list->spans[i];
+    }
+
+    // start[r] now ends row r
+    size_t begin = 0;
+    for (size_t r = 0; r < rows; r++) {
+        size_t end = start[r];
+
+        // Rows hold a few spans each: insertion sort by start column
+        for (size_t i = begin + 1; i < end; i++) {
+            StrokeSpan span = sorted[i];
+            size_t j = i;
+            for (; j > begin && sorted[j - 1].x0 > span.x0; j--) {
+                sorted[j] = sorted[j - 1];
+            }
+            sorted[j] = span;
+        }
+
+        for (size_t i = begin; i < end; ) {
+            int x0 = sorted[i].x0, x1 = sorted[i].x1;
+            for (i++; i < end && sorted[i].x0 <= x1 + 1; i++) {
+                x1 = sorted[i].x1 > x1 ? sorted[i].x1 : x1;
+            }
+            clippedSpan(fb, x0, x1, top + (int)r, color);
+        }
+        begin = end;
+    }
+
+    free(start);
+    free(sorted);
+}
+
+// A lone point: what its caps cover
+static void fillDot(Framebuffer* fb, int x, int y, double half, LineCap cap, Color color) {
+    StrokePiece piece;
+
+    if (cap == CAP_ROUND) {
+        discPiece(x, y, half, &piece);
+    } else if (cap == CAP_SQUARE) {
+        squarePiece(x, y, half, &piece);
+    } else {
+        return;
+    }
+    fillConvexPieces(fb, &piece, 1, color);
+}
+
+void drawThickLine(Framebuffer* fb, int x1, int y1, int x2, int y2, const StrokeStyle* style,
+                   Color color) {
+    if (style->width <= 1) {
+        rasterizeLineClipped(fb, x1, y1, x2, y2, color);
+        return;
+    }
+
+    double half = style->width / 2.0;
+    double extend = style->cap == CAP_SQUARE ? half : 0.0;
+    StrokePiece pieces[3];
+    int count = 0;
+
+    if (!segmentPiece(x1, y1, x2, y2, half, extend, extend, &pieces[count])) {
+        fillDot(fb, x1, y1, half, style->cap, color);
+        return;
+    }
+    count++;
+    if (style->cap == CAP_ROUND) {
+        discPiece(x1, y1, half, &pieces[count++]);
+        discPiece(x2, y2, half, &pieces[count++]);
+    }
+    fillConvexPieces(fb, pieces, count, color);
+}
+
+void drawThickPolyline(Framebuffer* fb, const Point* points, size_t count, const StrokeStyle* style,
+                       Color color) {
+    if (count == 0) {
+        return;
+    }
+    if (style->width <= 1) {
+        if (count == 1) {
+            setPixel(fb, points[0].x, points[0].y, color);
+        }
+        for (size_t i = 1; i < count; i++) {
+            rasterizeLineClipped(fb, points[i - 1].x, points[i - 1].y, points[i].x, points[i].y, color);
+        }
+        return;
+    }
+
+    // Repeated points are dropped; they have no direction to join along
+    size_t last = count - 1;
+    while (last > 0 && points[last].x == points[last - 1].x && points[last].y == points[last - 1].y) {
+        last--;
+    }
+    if (last == 0) {
+        fillDot(fb, points[0].x, points[0].y, style->width / 2.0, style->cap, color);
+        return;
+    }
+
+    double half = style->width / 2.0;
+    double extend = style->cap == CAP_SQUARE ? half : 0.0;
+    SpanList list;
+    StrokePiece piece;
+    double ux = 0.0, uy = 0.0;      // direction of the previous segment
+    int previous = 0;               // a previous segment exists
+    size_t from = 0;
+
+    initSpanList(&list);
+    for (size_t i = 1; i <= last; i++) {
+        if (points[i].x == points[from].x && points[i].y == points[from].y) {
+            continue;
+        }
+
+        double x1 = points[from].x, y1 = points[from].y;
+        double x2 = points[i].x, y2 = points[i].y;
+        double length = hypot(x2 - x1, y2 - y1);
+        double nextUx = (x2 - x1) / length, nextUy = (y2 - y1) / length;
+
+        if (previous && joinPiece(x1, y1, ux, uy, nextUx, nextUy, half, style, &piece)) {
+            addPieceSpans(fb, &list, &piece, color);
+        }
+        segmentPiece(x1, y1, x2, y2, half, previous ? 0.0 : extend, i == last ? extend : 0.0, &piece);
+        addPieceSpans(fb, &list, &piece, color);
+
+        ux = nextUx;
+        uy = nextUy;
+        previous = 1;
+        from = i;
+    }
+
+    if (style->cap == CAP_ROUND) {
+        discPiece(points[0].x, points[0].y, half, &piece);
+        addPieceSpans(fb, &list, &piece, color);
+        discPiece(points[last].x, points[last].y, half, &piece);
+        addPieceSpans(fb, &list, &piece, color);
+    }
+
+    fillSpanList(fb, &list, color);
+    freeSpanList(&list);
+}
@@ -0,0 +1,321 @@
+#include <stdlib.h>
+#include "raster.h"
+#include "raster_internal.h"
+#include "raster_tiled.h"
+#include "raster_pool.h"
+
+// Binning tasks per thread; more than one so a chunk of long lines does not
+// leave the other threads idle
+#define BIN_CHUNKS_PER_THREAD 4
+
+// Segments binned per thread before the tiles are drawn
+#define TILED_SLAB_PER_THREAD 8192
+
+// Entries store 32-bit pixel indices and error terms; batches that need
+// more (huge canvases, lines longer than 2^30 pixels) are drawn serially
+#define TILED_MAX_INDEX 0x7FFFFFFFL
+#define TILED_MAX_MAJOR 0x3FFFFFFF
+
+// Direction bits in the top byte of TileEntry.colorFlags
+#define TILE_X_MAJOR        1
+#define TILE_MAJOR_NEGATIVE 2
+#define TILE_MINOR_NEGATIVE 4
+
+// Part of one segment that falls inside one tile, with the Bresenham state
+// at its first pixel worked out during binning. The raster pass then never
+// goes back to the segment array, which it would otherwise visit in a
+// scattered order once per tile; the packing keeps the bins, which are
+// written once and read once, at 24 bytes per entry.
+typedef struct {
+    int32_t pixel;
+    int32_t remainder;
+    int32_t twoMajor, twoMinor;
+    int32_t count;
+    uint32_t colorFlags;    // 0xRRGGBB color, direction bits in the top byte
+} TileEntry;
+
+typedef struct {
+    TileEntry* entries;
+    size_t count;
+    size_t capacity;
+} TileBin;
+
+struct TiledRenderer {
+    ThreadPool* pool;
+    int tileSize;
+
+    // bins[chunk * tileCount + tile]: the entries binning chunk `chunk`
+    // produced for `tile`, in segment order
+    TileBin* bins;
+    size_t binCount;
+};
+
+// State of one slab of a drawLineBatchTiled call, shared by all tasks
+typedef struct {
+    TiledRenderer* renderer;
+    Framebuffer* fb;
+    const Segment* segments;
+    size_t count;
+    int tilesX, tilesY;
+    int chunks;
+    size_t chunkSize;
+    int fallback;           // set when binning fails; draw serially instead
+} TiledJob;
+
+TiledRenderer* createTiledRenderer(int threads, int tileSize) {
+    TiledRenderer* renderer = calloc(1, sizeof(TiledRenderer));
+    if (!renderer) {
+        return NULL;
+    }
+
+    renderer->pool = createThreadPool(threads);
+    if (!renderer->pool) {
+        free(renderer);
+        return NULL;
+    }
+    renderer->tileSize = tileSize > 0 ? tileSize : TILED_DEFAULT_TILE_SIZE;
+    return renderer;
+}
+
+int tiledRendererThreads(const TiledRenderer* renderer) {
+    return threadPoolSize(renderer->pool);
+}
+
+static int reserveBins(TiledRenderer* renderer, size_t count) {
+    if (renderer->binCount >= count) {
+        return 1;
+    }
+
+    TileBin* bins = realloc(renderer->bins, sizeof(TileBin) * count);
+    if (!bins) {
+        return 0;
+    }
+    for (size_t i = renderer->binCount; i < count; i++) {
+        bins[i].entries = NULL;
+        bins[i].count = 0;
+        bins[i].capacity = 0;
+    }
+    renderer->bins = bins;
+    renderer->binCount = count;
+    return 1;
+}
+
+static int appendEntry(const TiledJob* job, TileBin* bin, const LineSteps* line, int first, int last,
+                       Color color) {
+    if (bin->count == bin->capacity) {
+        size_t capacity = bin->capacity ? bin->capacity * 2 : 16;
+        TileEntry* entries = realloc(bin->entries, sizeof(TileEntry) * capacity);
+        if (!entries) {
+            return 0;
+        }
+        bin->entries = entries;
+        bin->capacity = capacity;
+    }
+
+    LineCursor cursor;
+    seekLineSteps(job->fb, line, first, &cursor);
+
+    TileEntry* entry = &bin->entries[bin->count++];
+    entry->pixel = (int32_t)cursor.pixel;
+    entry->remainder = (int32_t)cursor.remainder;
+    entry->twoMajor = (int32_t)cursor.twoMajor;
+    entry->twoMinor = (int32_t)cursor.twoMinor;
+    entry->count = last - first + 1;
+    entry->colorFlags = (color & 0xFFFFFF) |
+                        (uint32_t)((line->xMajor ? TILE_X_MAJOR : 0) |
+                                   (line->majorSign < 0 ? TILE_MAJOR_NEGATIVE : 0) |
+                                   (line->minorSign < 0 ? TILE_MINOR_NEGATIVE : 0)) << 24;
+    return 1;
+}
+
+// Add the visible part of one segment to every tile it crosses. Tile rows
+// are taken from the visible step range; within a row, the x extent of the
+// row's steps gives the tile columns, and every one of them is hit because
+// consecutive pixels move at most one column. Returns 0 if the segment
+// cannot be binned (out of memory, or too long for a TileEntry).
+static int binSegment(const TiledJob* job, TileBin* bins, size_t index) {
+    const Segment* s = &job->segments[index];
+    const Framebuffer* fb = job->fb;
+    int tileSize = job->renderer->tileSize;
+    LineSteps line;
+    int first, last;
+    int xa, ya, xb, yb;
+
+    if (!lineInRange(s->x1, s->y1, s->x2, s->y2)) {
+        return 1;
+    }
+    initLineSteps(&line, s->x1, s->y1, s->x2, s->y2);
+    if (!clipLineSteps(&line, 0, 0, fb->width - 1, fb->height - 1, &first, &last)) {
+        return 1;
+    }
+    if (line.major > TILED_MAX_MAJOR) {
+        return 0;
+    }
+
+    lineStepPoint(&line, first, &xa, &ya);
+    lineStepPoint(&line, last, &xb, &yb);
+    int rowFirst = (ya < yb ? ya : yb) / tileSize;
+    int rowLast = (ya < yb ? yb : ya) / tileSize;
+
+    for (int row = rowFirst; row <= rowLast; row++) {
+        int top = row * tileSize;
+        int bottom = top + tileSize - 1 < fb->height - 1 ? top + tileSize - 1 : fb->height - 1;
+        int rowStart, rowEnd;
+
+        if (!clipLineSteps(&line, 0, top, fb->width - 1, bottom, &rowStart, &rowEnd)) {
+            continue;
+        }
+
+        lineStepPoint(&line, rowStart, &xa, &ya);
+        lineStepPoint(&line, rowEnd, &xb, &yb);
+        int columnFirst = (xa < xb ? xa : xb) / tileSize;
+        int columnLast = (xa < xb ? xb : xa) / tileSize;
+
+        if (columnFirst == columnLast) {
+            if (!appendEntry(job, &bins[row * job->tilesX + columnFirst], &line, rowStart, rowEnd, s->color)) {
+                return 0;
+            }
+            continue;
+        }
+
+        for (int column = columnFirst; column <= columnLast; column++) {
+            int left = column * tileSize;
+            int right = left + tileSize - 1 < fb->width - 1 ? left + tileSize - 1 : fb->width - 1;
+            int tileStart, tileEnd;
+
+            if (line.xMajor) {
+                // Columns cut the major axis, where the step is linear in x
+                int enter = line.majorSign > 0 ? left - line.x1 : line.x1 - right;
+                int leave = line.majorSign > 0 ? right - line.x1 : line.x1 - left;
+                tileStart = enter > rowStart ? enter : rowStart;
+                tileEnd = leave < rowEnd ? leave : rowEnd;
+            } else if (!clipLineSteps(&line, left, top, right, bottom, &tileStart, &tileEnd)) {
+                continue;
+            }
+
+            if (!appendEntry(job, &bins[row * job->tilesX + column], &line, tileStart, tileEnd, s->color)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static void binChunk(int chunk, int worker, void* arg) {
+    TiledJob* job = arg;
+    int tileCount = job->tilesX * job->tilesY;
+    TileBin* bins = &job->renderer->bins[(size_t)chunk * tileCount];
+    size_t begin = (size_t)chunk * job->chunkSize;
+    size_t end = begin + job->chunkSize < job->count ? begin + job->chunkSize : job->count;
+    (void)worker;
+
+    for (int t = 0; t < tileCount; t++) {
+        bins[t].count = 0;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        if (!binSegment(job, bins, i)) {
+            __atomic_store_n(&job->fallback, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+}
+
+// Chunks are visited in order, so segments land in batch order
+static void rasterizeTile(int tile, int worker, void* arg) {
+    TiledJob* job = arg;
+    int tileCount = job->tilesX * job->tilesY;
+    (void)worker;
+
+    for (int chunk = 0; chunk < job->chunks; chunk++) {
+        const TileBin* bin = &job->renderer->bins[(size_t)chunk * tileCount + tile];
+
+        for (size_t i = 0; i < bin->count; i++) {
+            const TileEntry* entry = &bin->entries[i];
+            unsigned flags = entry->colorFlags >> 24;
+            long stepX = (flags & (flags & TILE_X_MAJOR ? TILE_MAJOR_NEGATIVE : TILE_MINOR_NEGATIVE)) ? -1 : 1;
+            long stepY = (flags & (flags & TILE_X_MAJOR ? TILE_MINOR_NEGATIVE : TILE_MAJOR_NEGATIVE))
+                             ? -(long)job->fb->stride : job->fb->stride;
+            LineCursor cursor;
+
+            cursor.pixel = entry->pixel;
+            cursor.remainder = entry->remainder;
+            cursor.twoMajor = entry->twoMajor;
+            cursor.twoMinor = entry->twoMinor;
+            cursor.majorStep = flags & TILE_X_MAJOR ? stepX : stepY;
+            cursor.minorStep = flags & TILE_X_MAJOR ? stepY : stepX;
+            if (job->fb->format == PIXEL_RGB24) {
+                stepLineCursor(job->fb, &cursor, entry->count, entry->colorFlags & 0xFFFFFF);
+            } else {
+                stepLineCursorFormat(job->fb, &cursor, entry->count, entry->colorFlags & 0xFFFFFF);
+            }
+        }
+    }
+}
+
+// Bin and draw one slab of the batch
+static void drawSlab(TiledRenderer* renderer, Framebuffer* fb, const Segment* segments, size_t count) {
+    TiledJob job;
+
+    job.renderer = renderer;
+    job.fb = fb;
+    job.segments = segments;
+    job.count = count;
+    job.tilesX = (fb->width + renderer->tileSize - 1) / renderer->tileSize;
+    job.tilesY = (fb->height + renderer->tileSize - 1) / renderer->tileSize;
+    job.chunks = threadPoolSize(renderer->pool) * BIN_CHUNKS_PER_THREAD;
+    if ((size_t)job.chunks > count) {
+        job.chunks = (int)count;
+    }
+    job.chunkSize = (count + job.chunks - 1) / job.chunks;
+    job.fallback = 0;
+
+    int tileCount = job.tilesX * job.tilesY;
+    // 1-bit tiles must not share bytes, or two threads could write one
+    if ((long)fb->stride * fb->height > TILED_MAX_INDEX ||
+        (fb->format == PIXEL_MASK1 && renderer->tileSize % 8 != 0) ||
+        !reserveBins(renderer, (size_t)job.chunks * tileCount)) {
+        job.fallback = 1;
+    } else {
+        threadPoolRun(renderer->pool, job.chunks, binChunk, &job);
+    }
+
+    if (job.fallback) {
+        // Could not bin everything; draw the slab on this thread instead
+        drawLineBatch(fb, segments, count, LINE_BRESENHAM, NULL);
+    } else {
+        threadPoolRun(renderer->pool, tileCount, rasterizeTile, &job);
+    }
+}
+
+void drawLineBatchTiled(TiledRenderer* renderer, Framebuffer* fb, const Segment* segments,
+                        size_t count, BatchStats* stats) {
+    double start = stats ? batchClock() : 0.0;
+
+    if (fb->width > 0 && fb->height > 0) {
+        // Slabs keep the bins small enough to be read back from cache;
+        // they run one after another, so batch order is preserved
+        size_t slab = (size_t)threadPoolSize(renderer->pool) * TILED_SLAB_PER_THREAD;
+
+        for (size_t begin = 0; begin < count; begin += slab) {
+            drawSlab(renderer, fb, segments + begin, count - begin < slab ? count - begin : slab);
+        }
+    }
+
+    if (stats) {
+        finishBatchStats(stats, segments, count, start);
+    }
+}
+
+void destroyTiledRenderer(TiledRenderer* renderer) {
+    if (!renderer) {
+        return;
+    }
+
+    destroyThreadPool(renderer->pool);
+    for (size_t i = 0; i < renderer->binCount; i++) {
+        free(renderer->bins[i].entries);
+    }
+    free(renderer->bins);
+    free(renderer);
+}
@@ -0,0 +1,32 @@
+#ifndef RASTER_TILED_H
+#define RASTER_TILED_H
+
+#include "raster.h"
+
+// Multithreaded batch line rasterizer.
+//
+// The framebuffer is cut into square tiles. Each segment is clipped to the
+// tiles it crosses (binning, split across threads by segment range), then
+// the tiles are rasterized in parallel on a work-stealing thread pool.
+// Within a tile, segments are drawn in batch order, so the result is
+// pixel-identical to drawLineBatch(..., LINE_BRESENHAM, ...), overlaps
+// included.
+
+#define TILED_DEFAULT_TILE_SIZE 128
+
+typedef struct TiledRenderer TiledRenderer;
+
+// threads <= 0 means one per CPU, tileSize <= 0 means
+// TILED_DEFAULT_TILE_SIZE; returns NULL on failure
+TiledRenderer* createTiledRenderer(int threads, int tileSize);
+
+int tiledRendererThreads(const TiledRenderer* renderer);
+
+// Same contract as drawLineBatch with LINE_BRESENHAM. The renderer keeps
+// its bins between calls, so reuse one renderer for repeated batches.
+void drawLineBatchTiled(TiledRenderer* renderer, Framebuffer* fb, const Segment* segments,
+                        size_t count, BatchStats* stats);
+
+void destroyTiledRenderer(TiledRenderer* renderer);
+
+#endif
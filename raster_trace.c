@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "raster_trace.h"
+
+// Steps listed in full before the text sink starts eliding
+#define TEXT_TRACE_STEPS 10
+
+TraceLevel rasterTraceLevel = TRACE_OFF;
+
+static TraceSink currentSink = NULL;
+static void* currentUserData = NULL;
+
+void setTraceLevel(TraceLevel level) {
+    rasterTraceLevel = level;
+}
+
+void setTraceSink(TraceSink sink, void* userData) {
+    currentSink = sink;
+    currentUserData = userData;
+}
+
+void traceEmit(uint16_t kind, uint16_t algorithm, int32_t v0, int32_t v1, int32_t v2,
+               int32_t v3, int32_t v4, int32_t v5, int32_t v6) {
+    TraceEvent event = { kind, algorithm, { v0, v1, v2, v3, v4, v5, v6 } };
+
+    if (currentSink) {
+        currentSink(&event, currentUserData);
+    } else {
+        traceSinkText(&event, stderr);
+    }
+}
+
+static void printLineBegin(FILE* out, const TraceEvent* event) {
+    int x1 = event->v[0], y1 = event->v[1];
+    int x2 = event->v[2], y2 = event->v[3];
+
+    if (event->algorithm == TRACE_LINE_BRESENHAM) {
+        int dx = abs(x2 - x1);
+        int dy = abs(y2 - y1);
+
+        fprintf(out, "\n╔════════════════════════════════════════════════════╗\n");
+        fprintf(out, "║    Bresenham's Algorithm Calculation Details      ║\n");
+        fprintf(out, "╚════════════════════════════════════════════════════╝\n");
+        fprintf(out, "  Starting Point (x1, y1) : (%d, %d)\n", x1, y1);
+        fprintf(out, "  Ending Point   (x2, y2) : (%d, %d)\n", x2, y2);
+        fprintf(out, "  ────────────────────────────────────────────────────\n");
+        fprintf(out, "  dx = |x2 - x1| = |%d - %d| = %d\n", x2, x1, dx);
+        fprintf(out, "  dy = |y2 - y1| = |%d - %d| = %d\n", y2, y1, dy);
+        fprintf(out, "  ────────────────────────────────────────────────────\n");
+        fprintf(out, "  sx (x step direction) = %d\n", x1 < x2 ? 1 : -1);
+        fprintf(out, "  sy (y step direction) = %d\n", y1 < y2 ? 1 : -1);
+        fprintf(out, "  ────────────────────────────────────────────────────\n");
+        fprintf(out, "  Initial error = dx - dy = %d - %d = %d\n", dx, dy, dx - dy);
+        fprintf(out, "╚════════════════════════════════════════════════════╝\n\n");
+    } else if (event->algorithm == TRACE_LINE_RUN_SLICE) {
+        int dx = abs(x2 - x1);
+        int dy = abs(y2 - y1);
+        int major = dx >= dy ? dx : dy;
+        int minor = dx >= dy ? dy : dx;
+
+        fprintf(out, "\n╔════════════════════════════════════════════════════╗\n");
+        fprintf(out, "║    Run-Slice Bresenham Calculation Details        ║\n");
+        fprintf(out, "╚════════════════════════════════════════════════════╝\n");
+        fprintf(out, "  Starting Point (x1, y1) : (%d, %d)\n", x1, y1);
+        fprintf(out, "  Ending Point   (x2, y2) : (%d, %d)\n", x2, y2);
+        fprintf(out, "  ────────────────────────────────────────────────────\n");
+        fprintf(out, "  dx = %d, dy = %d (%s runs)\n", dx, dy, dx >= dy ? "horizontal" : "vertical");
+        fprintf(out, "  Runs = minor + 1 = %d\n", minor + 1);
+        if (minor > 0) {
+            fprintf(out, "  Run length = %d/%d = %d or %d pixels\n", major, minor,
+                    major / minor, major / minor + 1);
+        }
+        fprintf(out, "╚════════════════════════════════════════════════════╝\n\n");
+    } else if (event->algorithm == TRACE_LINE_DDA_FIXED) {
+        int dx = x2 - x1;
+        int dy = y2 - y1;
+        int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+        int minor = abs(dx) > abs(dy) ? abs(dy) : abs(dx);
+        uint64_t increment = steps ? ((uint64_t)minor << 32) / steps : 0;
+
+        fprintf(out, "\n╔════════════════════════════════════════════╗\n");
+        fprintf(out, "║  Fixed-Point DDA (32.32) Calculation      ║\n");
+        fprintf(out, "╚════════════════════════════════════════════╝\n");
+        fprintf(out, "  Starting Point (x1, y1) : (%d, %d)\n", x1, y1);
+        fprintf(out, "  Ending Point   (x2, y2) : (%d, %d)\n", x2, y2);
+        fprintf(out, "  ──────────────────────────────────────────\n");
+        fprintf(out, "  dx = %d, dy = %d, steps = %d\n", dx, dy, steps);
+        fprintf(out, "  Minor increment = %d/%d = 0x%08X.%08X\n", minor, steps,
+                (unsigned)(increment >> 32), (unsigned)(increment & 0xFFFFFFFFu));
+        fprintf(out, "  Start accumulator = 0x00000000.7FFFFFFF (just under 0.5)\n");
+        fprintf(out, "╚════════════════════════════════════════════╝\n\n");
+    } else {
+        int dx = x2 - x1;
+        int dy = y2 - y1;
+        int steps = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+        float xIncrement = steps ? (float)dx / (float)steps : 0.0f;
+        float yIncrement = steps ? (float)dy / (float)steps : 0.0f;
+
+        fprintf(out, "\n╔════════════════════════════════════════════╗\n");
+        fprintf(out, "║    DDA Algorithm Calculation Details      ║\n");
+        fprintf(out, "╚════════════════════════════════════════════╝\n");
+        fprintf(out, "  Starting Point (x1, y1) : (%d, %d)\n", x1, y1);
+        fprintf(out, "  Ending Point   (x2, y2) : (%d, %d)\n", x2, y2);
+        fprintf(out, "  ──────────────────────────────────────────\n");
+        fprintf(out, "  dx = x2 - x1 = %d - %d = %d\n", x2, x1, dx);
+        fprintf(out, "  dy = y2 - y1 = %d - %d = %d\n", y2, y1, dy);
+        fprintf(out, "  ──────────────────────────────────────────\n");
+        fprintf(out, "  Steps = max(|dx|, |dy|) = max(%d, %d) = %d\n", abs(dx), abs(dy), steps);
+        fprintf(out, "  ──────────────────────────────────────────\n");
+        fprintf(out, "  x increment = dx/steps = %d/%d = %.4f\n", dx, steps, xIncrement);
+        fprintf(out, "  y increment = dy/steps = %d/%d = %.4f\n", dy, steps, yIncrement);
+        fprintf(out, "╚════════════════════════════════════════════╝\n\n");
+        fprintf(out, "Drawing %d pixels...\n", steps + 1);
+    }
+}
+
+static void printCircleBegin(FILE* out, const TraceEvent* event) {
+    int radius = event->v[2];
+
+    fprintf(out, "\n╔════════════════════════════════════════════════════════╗\n");
+    fprintf(out, "║    Bresenham's Circle Algorithm Calculation Details   ║\n");
+    fprintf(out, "╚════════════════════════════════════════════════════════╝\n");
+    fprintf(out, "  Center (xc, yc) : (%d, %d)\n", event->v[0], event->v[1]);
+    fprintf(out, "  Radius          : %d\n", radius);
+    fprintf(out, "  ────────────────────────────────────────────────────────\n");
+    fprintf(out, "  Initial decision parameter:\n");
+    fprintf(out, "  d = 3 - 2*r = 3 - 2*%d = %d\n", radius, event->v[3]);
+    fprintf(out, "  ────────────────────────────────────────────────────────\n");
+    fprintf(out, "  Starting point: (x=0, y=%d)\n", radius);
+    fprintf(out, "╚════════════════════════════════════════════════════════╝\n\n");
+
+    fprintf(out, "Drawing circle using 8-way symmetry:\n");
+    fprintf(out, "  (Each calculated point generates 8 symmetrical points)\n\n");
+}
+
+static void printStep(FILE* out, uint16_t algorithm, int step, int x, int y, int decision) {
+    if (algorithm == TRACE_CIRCLE_BRESENHAM) {
+        fprintf(out, "Step %2d: x=%3d, y=%3d, d=%4d\n", step, x, y, decision);
+    } else if (algorithm == TRACE_LINE_BRESENHAM) {
+        fprintf(out, "Step %2d: x=%3d, y=%3d, err=%4d\n", step, x, y, decision);
+    } else if (algorithm == TRACE_LINE_RUN_SLICE) {
+        fprintf(out, "Run  %2d: x=%3d, y=%3d, length=%4d\n", step, x, y, decision);
+    } else if (algorithm == TRACE_LINE_DDA_FIXED) {
+        fprintf(out, "Step %2d: x=%3d, y=%3d, frac=0x%04X\n", step, x, y, (unsigned)decision);
+    } else {
+        fprintf(out, "Step %2d: x=%3d, y=%3d\n", step, x, y);
+    }
+}
+
+void traceSinkText(const TraceEvent* event, void* userData) {
+    FILE* out = userData ? (FILE*)userData : stderr;
+
+    switch (event->kind) {
+    case TRACE_BEGIN:
+        if (event->algorithm == TRACE_CIRCLE_BRESENHAM) {
+            printCircleBegin(out, event);
+        } else {
+            printLineBegin(out, event);
+        }
+        break;
+
+    case TRACE_STEP:
+        // Show the first steps, then only the last one (printed at TRACE_END)
+        if (event->v[0] < TEXT_TRACE_STEPS) {
+            printStep(out, event->algorithm, event->v[0], event->v[1], event->v[2], event->v[3]);
+        } else if (event->v[0] == TEXT_TRACE_STEPS) {
+            fprintf(out, "         ... (calculating remaining points) ...\n");
+        }
+        break;
+
+    case TRACE_END:
+        if (rasterTraceLevel >= TRACE_STEPS && event->v[0] > TEXT_TRACE_STEPS) {
+            printStep(out, event->algorithm, event->v[0] - 1, event->v[2], event->v[3], event->v[4]);
+        }
+        if (event->algorithm == TRACE_CIRCLE_BRESENHAM) {
+            fprintf(out, "\n✓ Circle drawn successfully!\n");
+            fprintf(out, "  Total steps (octant): %d\n", event->v[0]);
+            fprintf(out, "  Total pixels plotted: %d (using 8-way symmetry)\n", event->v[1]);
+        } else {
+            fprintf(out, "✓ Line drawn successfully!\n");
+            fprintf(out, "  Total pixels plotted: %d\n", event->v[1]);
+        }
+        break;
+    }
+}
+
+void traceSinkBinary(const TraceEvent* event, void* userData) {
+    fwrite(event, sizeof(TraceEvent), 1, (FILE*)userData);
+}
+
+void initTraceRing(TraceRing* ring, TraceEvent* storage, size_t capacity) {
+    ring->events = storage;
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->count = 0;
+}
+
+void traceSinkRing(const TraceEvent* event, void* userData) {
+    TraceRing* ring = userData;
+
+    if (ring->capacity == 0) {
+        return;
+    }
+
+    ring->events[ring->head] = *event;
+    ring->head = (ring->head + 1) % ring->capacity;
+    if (ring->count < ring->capacity) {
+        ring->count++;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef RASTER_TRACE_H
+#define RASTER_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Optional diagnostics for the single-primitive draw functions.
+//
+// With the level at TRACE_OFF (the default) the rasterizers never format or
+// write anything; the only cost is one load and compare per call. Otherwise
+// they emit fixed-size TraceEvent records to the installed sink, which may
+// print them, keep them in memory, or dump them to a file. The batch entry
+// points never trace.
+
+typedef enum {
+    TRACE_OFF,
+    TRACE_SUMMARY,      // one begin/end pair per primitive
+    TRACE_STEPS         // plus one event per algorithm step
+} TraceLevel;
+
+typedef enum {
+    TRACE_BEGIN,        // line: v = {x1, y1, x2, y2}; circle: v = {xc, yc, radius, d}
+    TRACE_STEP,         // v = {step, x, y, decision}
+    TRACE_END           // v = {steps, pixels, x, y, decision}
+} TraceEventKind;
+
+typedef enum {
+    TRACE_LINE_DDA,
+    TRACE_LINE_BRESENHAM,
+    TRACE_CIRCLE_BRESENHAM,
+    TRACE_LINE_DDA_FIXED,
+    TRACE_LINE_RUN_SLICE
+} TraceAlgorithm;
+
+// `decision` is the Bresenham error term or circle decision parameter, the
+// top 16 fraction bits of the minor-axis accumulator for fixed-point DDA,
+// and 0 for float DDA. Run-slice steps are whole runs: x, y is the first
+// pixel of the run and `decision` its length. The layout is fixed so
+// binary traces can be read back as-is.
+typedef struct {
+    uint16_t kind;          // TraceEventKind
+    uint16_t algorithm;     // TraceAlgorithm
+    int32_t v[7];
+} TraceEvent;
+
+typedef void (*TraceSink)(const TraceEvent* event, void* userData);
+
+// Current level; read directly by the rasterizers
+extern TraceLevel rasterTraceLevel;
+
+void setTraceLevel(TraceLevel level);
+
+// Route events to `sink`; NULL restores the default (traceSinkText on stderr)
+void setTraceSink(TraceSink sink, void* userData);
+
+// Deliver one event to the current sink
+void traceEmit(uint16_t kind, uint16_t algorithm, int32_t v0, int32_t v1, int32_t v2,
+               int32_t v3, int32_t v4, int32_t v5, int32_t v6);
+
+// Human-readable calculation tables; userData is the FILE* to print to
+void traceSinkText(const TraceEvent* event, void* userData);
+
+// Raw TraceEvent records; userData is a FILE* opened in binary mode
+void traceSinkBinary(const TraceEvent* event, void* userData);
+
+// In-memory ring that keeps the most recent `capacity` events
+typedef struct {
+    TraceEvent* events;
+    size_t capacity;
+    size_t head;            // index of the next write
+    size_t count;           // valid events, at most capacity
+} TraceRing;
+
+void initTraceRing(TraceRing* ring, TraceEvent* storage, size_t capacity);
+
+// userData is a TraceRing*
+void traceSinkRing(const TraceEvent* event, void* userData);
+
+#endif
@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raster.h"
+#include "raster_image.h"
+#include "raster_scenefile.h"
+#include "raster_segfile.h"
+
+// Non-interactive renderer: draw a scene file into an image.
+//
+//   ./render_scene [--binary output.rscn | --segments output.rseg] scene [image]
+//
+// The scene is text or binary (see raster_scenefile.h); "-" reads it from
+// standard input. It is streamed through a fixed buffer, so any size of
+// scene file renders in constant memory. The canvas starts out white. The
+// image defaults to scene.ppm; as in dda_interactive, a PPM or PAM image
+// is drawn straight into the memory-mapped file, and .png or .qoi are
+// encoded at the end. --binary converts the scene to the binary encoding
+// instead of rendering it.
+//
+// A segment file (raster_segfile.h) is rendered too: it is mapped and its
+// columns handed to drawLineColumns in one call. --segments converts a
+// scene of lines, drawn with one algorithm, to a segment file.
+
+// Copy every command of `reader` to `path` in the binary encoding
+static int convertScene(SceneReader* reader, const char* path) {
+    FILE* out = fopen(path, "wb");
+    if (!out) {
+        printf("Could not create %s\n", path);
+        return 0;
+    }
+
+    int width, height;
+    sceneCanvasSize(reader, &width, &height);
+
+    SceneCommand command;
+    Color color = COLOR_BLACK;
+    size_t commands = 0;
+    int status = 0;
+    int written = writeSceneHeader(out, width, height);
+    while (written && (status = readSceneCommand(reader, &command)) > 0) {
+        written = writeSceneCommand(out, &command, &color);
+        commands++;
+    }
+    if (fclose(out) != 0) {
+        written = 0;
+    }
+
+    if (!written) {
+        printf("Could not write %s\n", path);
+        return 0;
+    }
+    if (status < 0) {
+        printf("Scene error: %s\n", sceneReaderError(reader));
+        return 0;
+    }
+    printf("Converted %zu commands to %s\n", commands, path);
+    return 1;
+}
+
+// Copy the lines of `reader` to the segment file at `path`. The scene may
+// only clear the canvas before its first line and use one algorithm.
+static int convertSegments(SceneReader* reader, const char* path) {
+    SceneCommand command;
+    LineAlgorithm algorithm = LINE_BRESENHAM;
+    Color background = COLOR_WHITE;
+    const char* problem = NULL;
+    int status;
+
+    // The header needs the background and algorithm, set before the lines
+    while ((status = readSceneCommand(reader, &command)) > 0 && command.op != SCENE_LINE) {
+        if (command.op == SCENE_CLEAR) {
+            background = command.color;
+        } else if (command.op == SCENE_ALGORITHM) {
+            algorithm = (LineAlgorithm)command.v[0];
+        } else {
+            problem = "segment files hold only lines";
+            break;
+        }
+    }
+
+    int width, height;
+    sceneCanvasSize(reader, &width, &height);
+    SegmentWriter* writer = createSegmentWriter(path, width, height, algorithm, background);
+    if (!writer) {
+        printf("Could not create %s\n", path);
+        return 0;
+    }
+
+    size_t count = 0;
+    int written = 1;
+    while (status > 0 && written && !problem) {
+        if (command.op == SCENE_LINE) {
+            Segment segment = { command.v[0], command.v[1], command.v[2], command.v[3], command.color };
+            written = writeSegment(writer, &segment);
+            count++;
+        } else if (command.op == SCENE_ALGORITHM) {
+            if ((LineAlgorithm)command.v[0] != algorithm) {
+                problem = "segment files draw every line with one algorithm";
+            }
+        } else if (command.op == SCENE_CLEAR) {
+            problem = "segment files cannot clear between lines";
+        } else {
+            problem = "segment files hold only lines";
+        }
+        if (written && !problem) {
+            status = readSceneCommand(reader, &command);
+        }
+    }
+
+    if (!finishSegmentWriter(writer) || !written) {
+        printf("Could not write %s\n", path);
+        return 0;
+    }
+    if (status < 0) {
+        printf("Scene error: %s\n", sceneReaderError(reader));
+        return 0;
+    }
+    if (problem) {
+        printf("Cannot convert: %s\n", problem);
+        return 0;
+    }
+    printf("Converted %zu lines to %s\n", count, path);
+    return 1;
+}
+
+// Whether the file at `path` starts like a segment file
+static int isSegmentFile(const char* path) {
+    char magic[4] = { 0 };
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        return 0;
+    }
+    size_t got = fread(magic, 1, sizeof(magic), in);
+    fclose(in);
+    return got == sizeof(magic) && memcmp(magic, SEGMENT_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+// Image for a width x height canvas: the mapped file when the format
+// allows, otherwise a framebuffer saved by finishImage
+typedef struct {
+    const char* path;
+    ImageFormat format;
+    MappedImage* mapped;
+    Framebuffer* heap;
+    Framebuffer* fb;
+} OutputImage;
+
+static int startImage(OutputImage* image, const char* path, int width, int height) {
+    image->path = path;
+    image->format = imageFormatForPath(path);
+    image->heap = NULL;
+    image->mapped = createMappedImage(path, width, height, image->format);
+    if (image->mapped) {
+        image->fb = mappedFramebuffer(image->mapped);
+        return 1;
+    }
+    image->heap = image->fb = createFramebuffer(width, height, PIXEL_RGB24);
+    if (!image->heap) {
+        printf("Memory allocation failed!\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int finishImage(OutputImage* image) {
+    int saved;
+    if (image->mapped) {
+        saved = syncMappedImage(image->mapped);
+        closeMappedImage(image->mapped);
+    } else {
+        saved = saveFramebuffer(image->heap, image->path, image->format);
+        destroyFramebuffer(image->heap);
+    }
+    if (!saved) {
+        printf("Could not write %s\n", image->path);
+    }
+    return saved;
+}
+
+static int renderSegmentFile(const char* path, const char* imagePath) {
+    const char* error;
+    SegmentFile* file = openSegmentFile(path, &error);
+    if (!file) {
+        printf("%s: %s\n", path, error);
+        return 1;
+    }
+
+    int width, height;
+    OutputImage image;
+    segmentFileCanvas(file, &width, &height);
+    if (!startImage(&image, imagePath, width, height)) {
+        closeSegmentFile(file);
+        return 1;
+    }
+    clearFramebuffer(image.fb, segmentFileBackground(file));
+
+    BatchStats stats;
+    drawLineColumns(image.fb, segmentFileColumns(file), segmentFileAlgorithm(file), &stats);
+    closeSegmentFile(file);
+    if (!finishImage(&image)) {
+        return 1;
+    }
+
+    printf("Canvas         : %d x %d (segment file)\n", width, height);
+    printf("Lines          : %zu\n", stats.segments);
+    printf("Pixels stepped : %zu\n", stats.pixels);
+    printf("Time           : %.3f s\n", stats.seconds);
+    printf("Image          : %s\n", imagePath);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* binaryPath = NULL;
+    const char* segmentsPath = NULL;
+    const char* scenePath = NULL;
+    const char* imagePath = "scene.ppm";
+    int positional = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0 && i + 1 < argc) {
+            binaryPath = argv[++i];
+        } else if (strcmp(argv[i], "--segments") == 0 && i + 1 < argc) {
+            segmentsPath = argv[++i];
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            printf("Unknown or incomplete option '%s'\n", argv[i]);
+            return 1;
+        } else if (positional == 0) {
+            scenePath = argv[i];
+            positional++;
+        } else if (positional == 1) {
+            imagePath = argv[i];
+            positional++;
+        } else {
+            printf("Too many arguments\n");
+            return 1;
+        }
+    }
+    if (!scenePath) {
+        printf("Usage: %s [--binary output.rscn | --segments output.rseg] scene [image]\n", argv[0]);
+        return 1;
+    }
+    if (!binaryPath && !segmentsPath && strcmp(scenePath, "-") != 0 && isSegmentFile(scenePath)) {
+        return renderSegmentFile(scenePath, imagePath);
+    }
+
+    FILE* in = strcmp(scenePath, "-") == 0 ? stdin : fopen(scenePath, "rb");
+    if (!in) {
+        printf("Could not open %s\n", scenePath);
+        return 1;
+    }
+
+    const char* error;
+    SceneReader* reader = openSceneReader(in, &error);
+    if (!reader) {
+        printf("%s: %s\n", scenePath, error);
+        if (in != stdin) {
+            fclose(in);
+        }
+        return 1;
+    }
+
+    if (binaryPath || segmentsPath) {
+        int converted = binaryPath ? convertScene(reader, binaryPath)
+                                   : convertSegments(reader, segmentsPath);
+        closeSceneReader(reader);
+        if (in != stdin) {
+            fclose(in);
+        }
+        return converted ? 0 : 1;
+    }
+
+    int width, height;
+    int binary = sceneReaderIsBinary(reader);
+    sceneCanvasSize(reader, &width, &height);
+
+    OutputImage image;
+    if (!startImage(&image, imagePath, width, height)) {
+        closeSceneReader(reader);
+        if (in != stdin) {
+            fclose(in);
+        }
+        return 1;
+    }
+    clearFramebuffer(image.fb, COLOR_WHITE);
+
+    SceneStats stats;
+    int ok = drawSceneFile(reader, image.fb, &stats);
+    if (!ok) {
+        printf("%s: %s\n", scenePath, sceneReaderError(reader));
+    }
+    closeSceneReader(reader);
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    if (!finishImage(&image)) {
+        return 1;
+    }
+
+    printf("Canvas         : %d x %d (%s scene)\n", width, height,
+           binary ? "binary" : "text");
+    printf("Commands       : %zu\n", stats.commands);
+    printf("Lines          : %zu\n", stats.lines);
+    printf("Circles        : %zu\n", stats.circles);
+    printf("Markers        : %zu\n", stats.markers);
+    printf("Time           : %.3f s\n", stats.seconds);
+    printf("Image          : %s\n", imagePath);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdl_presenter.h"
+
+SdlPresenter* createPresenter(const char* title, int width, int height) {
+    SdlPresenter* presenter = calloc(1, sizeof(SdlPresenter));
+    if (!presenter) {
+        printf("\n✗ Memory allocation failed!\n");
+        return NULL;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("\n✗ SDL initialization failed: %s\n", SDL_GetError());
+        free(presenter);
+        return NULL;
+    }
+
+    presenter->window = SDL_CreateWindow(
+        title,
+        SDL_WINDOWPOS_CENTERED,
+        SDL_WINDOWPOS_CENTERED,
+        width,
+        height,
+        SDL_WINDOW_SHOWN
+    );
+    if (!presenter->window) {
+        printf("\n✗ Window creation failed: %s\n", SDL_GetError());
+        destroyPresenter(presenter);
+        return NULL;
+    }
+
+    presenter->renderer = SDL_CreateRenderer(presenter->window, -1, SDL_RENDERER_ACCELERATED);
+    if (!presenter->renderer) {
+        printf("\n✗ Renderer creation failed: %s\n", SDL_GetError());
+        destroyPresenter(presenter);
+        return NULL;
+    }
+
+    // RGB24 matches the Pixel layout, so frames upload without conversion
+    presenter->texture = SDL_CreateTexture(presenter->renderer, SDL_PIXELFORMAT_RGB24,
+                                           SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (!presenter->texture) {
+        printf("\n✗ Texture creation failed: %s\n", SDL_GetError());
+        destroyPresenter(presenter);
+        return NULL;
+    }
+
+    presenter->width = width;
+    presenter->height = height;
+    return presenter;
+}
+
+void presentFramebuffer(SdlPresenter* presenter, const Framebuffer* fb) {
+    SDL_UpdateTexture(presenter->texture, NULL, fb->pixels, (int)framebufferRowBytes(fb));
+    SDL_RenderCopy(presenter->renderer, presenter->texture, NULL, NULL);
+    SDL_RenderPresent(presenter->renderer);
+}
+
+void presentFramebufferRects(SdlPresenter* presenter, const Framebuffer* fb, const ClipRect* rects,
+                             int count) {
+    int pitch = (int)framebufferRowBytes(fb);
+
+    for (int i = 0; i < count; i++) {
+        SDL_Rect area = { rects[i].left, rects[i].top, rects[i].right - rects[i].left + 1,
+                          rects[i].bottom - rects[i].top + 1 };
+        const Pixel* first = fb->pixels + (long)rects[i].top * fb->stride + rects[i].left;
+        SDL_UpdateTexture(presenter->texture, &area, first, pitch);
+    }
+    redrawPresenter(presenter);
+}
+
+void redrawPresenter(SdlPresenter* presenter) {
+    SDL_RenderCopy(presenter->renderer, presenter->texture, NULL, NULL);
+    SDL_RenderPresent(presenter->renderer);
+}
+
+void destroyPresenter(SdlPresenter* presenter) {
+    if (!presenter) {
+        return;
+    }
+    if (presenter->texture) {
+        SDL_DestroyTexture(presenter->texture);
+    }
+    if (presenter->renderer) {
+        SDL_DestroyRenderer(presenter->renderer);
+    }
+    if (presenter->window) {
+        SDL_DestroyWindow(presenter->window);
+    }
+    SDL_Quit();
+    free(presenter);
+}
@@ -0,0 +1,36 @@
+#ifndef SDL_PRESENTER_H
+#define SDL_PRESENTER_H
+
+#include <SDL2/SDL.h>
+#include "raster.h"
+
+// Thin SDL front end: owns a window and a streaming texture and uploads a
+// finished framebuffer in one call. All drawing happens in raster.c.
+typedef struct {
+    SDL_Window* window;
+    SDL_Renderer* renderer;
+    SDL_Texture* texture;
+    int width;
+    int height;
+} SdlPresenter;
+
+// Initialize SDL and open a window; prints the SDL error and returns NULL on failure
+SdlPresenter* createPresenter(const char* title, int width, int height);
+
+// Upload the whole framebuffer and show it; `fb` must be RGB24 and the
+// presenter's size
+void presentFramebuffer(SdlPresenter* presenter, const Framebuffer* fb);
+
+// Upload only `count` rectangles of the framebuffer, e.g. the damage of a
+// Scene, and show the whole texture. Pixels outside them keep what was
+// uploaded before.
+void presentFramebufferRects(SdlPresenter* presenter, const Framebuffer* fb, const ClipRect* rects,
+                             int count);
+
+// Show the last uploaded frame again, e.g. when the window is exposed
+void redrawPresenter(SdlPresenter* presenter);
+
+// Destroy the window and shut SDL down
+void destroyPresenter(SdlPresenter* presenter);
+
+#endif
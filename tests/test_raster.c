@@ -0,0 +1,1377 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raster.h"
+#include "raster_farm.h"
+#include "raster_image.h"
+#include "raster_scene.h"
+#include "raster_scenefile.h"
+#include "raster_segfile.h"
+#include "raster_tiled.h"
+#include "raster_trace.h"
+
+// Rasterizer correctness tests.
+//
+//   ./test_raster [golden directory] [--update]
+//
+// Golden tests draw canonical cases into headless framebuffers and compare
+// the PPM bytes with the stored images in the golden directory (default
+// tests/golden). --update rewrites the stored images instead; only do that
+// for an intended change, after checking the new images.
+//
+// Equivalence tests draw seeded random segments with every optimized line
+// variant and require the same pixels as drawLineBresenham; line strips
+// must match their segments drawn one by one. Anti-aliased lines have no
+// aliased counterpart, so their kernels, formats and clipping are checked
+// against each other. So is the clipping of thick lines, whose shapes are
+// covered by the golden images. A retained scene is checked against a full
+// redraw after every edit.
+
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(condition, ...) do {          \
+        checks++;                           \
+        if (!(condition)) {                 \
+            failures++;                     \
+            printf("FAIL: " __VA_ARGS__);   \
+            printf("\n");                   \
+        }                                   \
+    } while (0)
+
+// ---------------------------------------------------------------- golden cases
+
+typedef void (*DrawFunction)(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color);
+
+// Endpoints around the center of a 65x65 canvas: one line inside each
+// octant, then the 8 boundaries between them (axes and diagonals)
+static const int octantEnds[16][2] = {
+    { 62, 43 }, { 43, 62 }, { 21, 62 }, { 2, 43 }, { 2, 21 }, { 21, 2 }, { 43, 2 }, { 62, 21 },
+    { 62, 32 }, { 62, 62 }, { 32, 62 }, { 2, 62 }, { 2, 32 }, { 2, 2 }, { 32, 2 }, { 62, 2 }
+};
+
+static const Color palette[8] = {
+    COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_BLACK,
+    COLOR_RGB(255, 128, 0), COLOR_RGB(128, 0, 255), COLOR_RGB(0, 128, 128), COLOR_RGB(128, 128, 0)
+};
+
+static void drawOctants(Framebuffer* fb, DrawFunction draw, int inward) {
+    for (int i = 0; i < 16; i++) {
+        if (inward) {
+            draw(fb, octantEnds[i][0], octantEnds[i][1], 32, 32, palette[i % 8]);
+        } else {
+            draw(fb, 32, 32, octantEnds[i][0], octantEnds[i][1], palette[i % 8]);
+        }
+    }
+}
+
+static void octantsBresenham(Framebuffer* fb) { drawOctants(fb, drawLineBresenham, 0); }
+static void octantsBresenhamInward(Framebuffer* fb) { drawOctants(fb, drawLineBresenham, 1); }
+static void octantsDDA(Framebuffer* fb) { drawOctants(fb, drawLineDDA, 0); }
+static void octantsDDAInward(Framebuffer* fb) { drawOctants(fb, drawLineDDA, 1); }
+static void octantsWu(Framebuffer* fb) { drawOctants(fb, drawLineWu, 0); }
+
+static void zeroLength(Framebuffer* fb, DrawFunction draw) {
+    draw(fb, 0, 0, 0, 0, COLOR_RED);
+    draw(fb, 3, 4, 3, 4, COLOR_GREEN);
+    draw(fb, 7, 7, 7, 7, COLOR_BLUE);
+    draw(fb, -1, -1, -1, -1, COLOR_BLACK);      // off the canvas: nothing
+    draw(fb, 8, 2, 8, 2, COLOR_BLACK);
+}
+
+static void zeroLengthBresenham(Framebuffer* fb) { zeroLength(fb, drawLineBresenham); }
+static void zeroLengthDDA(Framebuffer* fb) { zeroLength(fb, drawLineDDA); }
+
+static void diagonal(Framebuffer* fb) {
+    drawLineBresenham(fb, 0, 0, 799, 599, COLOR_BLUE);
+}
+
+static void smallCircles(Framebuffer* fb) {
+    drawCircleBresenham(fb, 4, 4, 0, COLOR_RED);     // just the center pixel
+    drawCircleBresenham(fb, 12, 4, 1, COLOR_GREEN);
+    drawCircleBresenham(fb, 22, 5, 2, COLOR_BLUE);
+    drawCircleBresenham(fb, 16, 20, 7, COLOR_BLACK);
+    drawCircleBresenham(fb, 0, 31, 3, COLOR_RED);    // clipped at the corner
+}
+
+static void largeCircle(Framebuffer* fb) {
+    drawCircleBresenham(fb, 250, 250, 250, COLOR_RED);
+}
+
+// Every cap and join, thin and sharp corners, and a stroke leaving the
+// canvas
+static void strokes(Framebuffer* fb) {
+    static const Point zigzag[] = { { 8, 90 }, { 24, 60 }, { 40, 90 }, { 56, 60 }, { 64, 76 } };
+    static const Point sharp[] = { { 76, 90 }, { 92, 44 }, { 100, 90 } };
+    static const Point reversal[] = { { 106, 52 }, { 124, 52 }, { 110, 52 }, { 110, 80 } };
+    StrokeStyle style = { 4, CAP_BUTT, JOIN_MITER, 0.0 };
+
+    drawThickLine(fb, 8, 8, 40, 8, &style, COLOR_RED);
+    style.cap = CAP_SQUARE;
+    drawThickLine(fb, 8, 18, 40, 18, &style, COLOR_GREEN);
+    style.cap = CAP_ROUND;
+    style.width = 7;
+    drawThickLine(fb, 8, 30, 40, 30, &style, COLOR_BLUE);
+    style.width = 6;
+    drawThickLine(fb, 52, 6, 90, 34, &style, COLOR_BLACK);
+    style.cap = CAP_SQUARE;
+    style.width = 3;
+    drawThickLine(fb, 100, 4, 108, 36, &style, COLOR_RGB(255, 128, 0));
+    style.width = 1;
+    drawThickLine(fb, 112, 4, 124, 36, &style, COLOR_RED);
+
+    style.width = 5;
+    style.cap = CAP_BUTT;
+    style.join = JOIN_MITER;
+    drawThickPolyline(fb, zigzag, 5, &style, COLOR_RGB(128, 0, 255));
+    style.join = JOIN_BEVEL;
+    drawThickPolyline(fb, sharp, 3, &style, COLOR_RGB(0, 128, 128));
+    style.join = JOIN_ROUND;
+    style.cap = CAP_ROUND;
+    drawThickPolyline(fb, reversal, 4, &style, COLOR_RGB(128, 128, 0));
+    style.join = JOIN_MITER;
+    style.miterLimit = 10.0;
+    drawThickPolyline(fb, sharp, 3, &style, COLOR_GREEN);
+
+    style.cap = CAP_SQUARE;
+    style.width = 8;
+    drawThickLine(fb, 60, 48, 60, 48, &style, COLOR_BLUE);       // a lone square
+    drawThickLine(fb, -20, 70, 20, 110, &style, COLOR_BLACK);    // off two edges
+}
+
+// Outlines, fills, flat ellipses, arcs and pies, one crossing the canvas
+// edge
+static void ellipses(Framebuffer* fb) {
+    drawEllipse(fb, 20, 12, 16, 8, COLOR_RED);
+    fillEllipse(fb, 52, 12, 10, 8, COLOR_BLUE);
+    drawEllipse(fb, 20, 30, 18, 1, COLOR_BLACK);       // thin
+    drawEllipse(fb, 44, 30, 6, 0, COLOR_GREEN);        // a line
+    drawEllipse(fb, 60, 30, 0, 3, COLOR_GREEN);
+    drawEllipseArc(fb, 16, 52, 12, 12, 30.0, 120.0, COLOR_RED);
+    drawEllipseArc(fb, 16, 52, 12, 12, 150.0, 240.0, COLOR_BLUE);
+    fillEllipsePie(fb, 46, 52, 14, 10, 0.0, 90.0, COLOR_RED);
+    fillEllipsePie(fb, 46, 52, 14, 10, 90.0, 135.0, COLOR_GREEN);
+    fillEllipsePie(fb, 46, 52, 14, 10, 225.0, 135.0, COLOR_BLUE);
+    fillEllipsePie(fb, 74, 46, 12, 20, -60.0, 300.0, COLOR_BLACK);    // off the edge
+}
+
+// Convex, concave and self-intersecting polygons under both fill rules,
+// a region with a hole, and one crossing the canvas edge
+static void polygons(Framebuffer* fb) {
+    static const Point triangle[] = { { 4, 4 }, { 28, 10 }, { 10, 26 } };
+    static const Point arrow[] = { { 34, 4 }, { 50, 15 }, { 34, 26 }, { 40, 15 } };
+    static const Point star[] = { { 12, 30 }, { 20, 54 }, { 0, 39 }, { 24, 39 }, { 4, 54 } };
+    static const Point region[] = {
+        { 54, 32 }, { 78, 32 }, { 78, 58 }, { 54, 58 },        // outline
+        { 60, 38 }, { 60, 50 }, { 72, 50 }                      // hole, wound the other way
+    };
+    static const size_t regionCounts[] = { 4, 3 };
+    static const Point offEdge[] = { { 60, -6 }, { 90, 8 }, { 70, 24 }, { 56, 12 } };
+
+    fillPolygon(fb, triangle, 3, FILL_EVEN_ODD, COLOR_RED);
+    fillPolygon(fb, arrow, 4, FILL_NONZERO, COLOR_BLUE);
+    fillPolygon(fb, star, 5, FILL_EVEN_ODD, COLOR_BLACK);
+    Point shifted[5];
+    for (int i = 0; i < 5; i++) {
+        shifted[i].x = star[i].x + 27;
+        shifted[i].y = star[i].y;
+    }
+    fillPolygon(fb, shifted, 5, FILL_NONZERO, COLOR_BLACK);
+    fillPolygonContours(fb, region, regionCounts, 2, FILL_NONZERO, COLOR_GREEN);
+    fillPolygon(fb, offEdge, 4, FILL_EVEN_ODD, COLOR_RGB(255, 128, 0));
+}
+
+typedef struct {
+    const char* name;
+    int width, height;
+    void (*draw)(Framebuffer* fb);
+} GoldenCase;
+
+static const GoldenCase goldenCases[] = {
+    { "octants_bresenham", 65, 65, octantsBresenham },
+    { "octants_bresenham_inward", 65, 65, octantsBresenhamInward },
+    { "octants_dda", 65, 65, octantsDDA },
+    { "octants_dda_inward", 65, 65, octantsDDAInward },
+    { "octants_wu", 65, 65, octantsWu },
+    { "zero_length_bresenham", 9, 9, zeroLengthBresenham },
+    { "zero_length_dda", 9, 9, zeroLengthDDA },
+    { "diagonal_800x600", 800, 600, diagonal },
+    { "circles_small", 32, 32, smallCircles },
+    { "circle_large", 501, 501, largeCircle },
+    { "strokes", 128, 96, strokes },
+    { "ellipses", 80, 68, ellipses },
+    { "polygons", 80, 60, polygons },
+};
+
+// PPM bytes of `fb`, in a new block; returns the size (0 on failure)
+static size_t ppmBytes(const Framebuffer* fb, char** data) {
+    size_t size = 0;
+    FILE* out = open_memstream(data, &size);
+    if (!out) {
+        return 0;
+    }
+
+    int ok = writeFramebuffer(fb, out, IMAGE_PPM);
+    if (fclose(out) != 0 || !ok) {
+        free(*data);
+        return 0;
+    }
+    return size;
+}
+
+static char* readFile(const char* path, size_t* size) {
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        return NULL;
+    }
+
+    char* data = NULL;
+    if (fseek(in, 0, SEEK_END) == 0) {
+        long length = ftell(in);
+        data = length >= 0 ? malloc((size_t)length + 1) : NULL;
+        rewind(in);
+        if (data && fread(data, 1, (size_t)length, in) == (size_t)length) {
+            *size = (size_t)length;
+        } else {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(in);
+    return data;
+}
+
+static void runGoldenCase(const GoldenCase* test, const char* directory, int update) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.ppm", directory, test->name);
+
+    Framebuffer* fb = createFramebuffer(test->width, test->height, PIXEL_RGB24);
+    clearFramebuffer(fb, COLOR_WHITE);
+    test->draw(fb);
+
+    if (update) {
+        CHECK(saveFramebuffer(fb, path, IMAGE_PPM), "%s: could not write", path);
+        destroyFramebuffer(fb);
+        return;
+    }
+
+    char* actual = NULL;
+    size_t actualSize = ppmBytes(fb, &actual);
+    size_t expectedSize = 0;
+    char* expected = readFile(path, &expectedSize);
+
+    CHECK(expected != NULL, "%s: missing golden image", path);
+    if (expected) {
+        int same = actualSize == expectedSize && memcmp(actual, expected, actualSize) == 0;
+        CHECK(same, "%s: differs from golden image", test->name);
+        if (!same) {
+            snprintf(path, sizeof(path), "%s.actual.ppm", test->name);
+            saveFramebuffer(fb, path, IMAGE_PPM);
+            printf("      actual image written to %s\n", path);
+        }
+    }
+    free(actual);
+    free(expected);
+    destroyFramebuffer(fb);
+}
+
+// ---------------------------------------------------------------- equivalence
+
+static unsigned long long randomState = 12345;
+
+static int randomBelow(int limit) {
+    randomState = randomState * 6364136223846793005ull + 1442695040888963407ull;
+    return (int)((randomState >> 33) % (unsigned long long)limit);
+}
+
+// Mostly visible segments of mixed lengths; some end far off the canvas
+static void randomSegments(Segment* segments, size_t count, int width, int height) {
+    for (size_t i = 0; i < count; i++) {
+        Segment* s = &segments[i];
+        int reach = randomBelow(4) == 0 ? 4 * (width + height) : randomBelow(3) == 0 ? 8 : width;
+
+        s->x1 = randomBelow(width + 20) - 10;
+        s->y1 = randomBelow(height + 20) - 10;
+        s->x2 = s->x1 + randomBelow(2 * reach + 1) - reach;
+        s->y2 = s->y1 + randomBelow(2 * reach + 1) - reach;
+        s->color = COLOR_RGB(randomBelow(256), randomBelow(256), randomBelow(256));
+    }
+}
+
+static int sameImage(const Framebuffer* a, const Framebuffer* b) {
+    for (int y = 0; y < a->height; y++) {
+        if (memcmp(a->pixels + (long)y * a->stride, b->pixels + (long)y * b->stride,
+                   sizeof(Pixel) * (size_t)a->width) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void drawAll(Framebuffer* fb, const Segment* segments, size_t count, DrawFunction draw) {
+    clearFramebuffer(fb, COLOR_WHITE);
+    for (size_t i = 0; i < count; i++) {
+        draw(fb, segments[i].x1, segments[i].y1, segments[i].x2, segments[i].y2, segments[i].color);
+    }
+}
+
+// drawLineClipped against the full framebuffer
+static void drawClippedFull(Framebuffer* fb, int x1, int y1, int x2, int y2, Color color) {
+    ClipRect all = { 0, 0, fb->width - 1, fb->height - 1 };
+    drawLineClipped(fb, x1, y1, x2, y2, &all, color);
+}
+
+// Every line of `segments` alone, so a difference names the segment
+static void compareEachLine(const char* name, DrawFunction draw, Framebuffer* expected,
+                            Framebuffer* actual, const Segment* segments, size_t count) {
+    int mismatches = 0;
+
+    for (size_t i = 0; i < count && mismatches < 5; i++) {
+        const Segment* s = &segments[i];
+
+        clearFramebuffer(expected, COLOR_WHITE);
+        clearFramebuffer(actual, COLOR_WHITE);
+        drawLineBresenham(expected, s->x1, s->y1, s->x2, s->y2, COLOR_BLACK);
+        draw(actual, s->x1, s->y1, s->x2, s->y2, COLOR_BLACK);
+        if (!sameImage(expected, actual)) {
+            mismatches++;
+            CHECK(0, "%s: (%d, %d)-(%d, %d) differs from drawLineBresenham on %dx%d",
+                  name, s->x1, s->y1, s->x2, s->y2, actual->width, actual->height);
+        }
+    }
+    CHECK(mismatches == 0, "%s: %d lines differ", name, mismatches);
+}
+
+static void ignoreTrace(const TraceEvent* event, void* user) {
+    (void)event;
+    (void)user;
+}
+
+static void testVariants(int width, int height, size_t count) {
+    Segment* segments = malloc(sizeof(Segment) * count);
+    Framebuffer* expected = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* actual = createFramebuffer(width, height, PIXEL_RGB24);
+    randomSegments(segments, count, width, height);
+
+    static const struct {
+        const char* name;
+        DrawFunction draw;
+    } variants[] = {
+        { "drawLineDDAFixed", drawLineDDAFixed },
+        { "drawLineDDASimd", drawLineDDASimd },
+        { "drawLineRunSlice", drawLineRunSlice },
+        { "drawLineClipped", drawClippedFull },
+    };
+
+    printf("  %dx%d, %zu segments\n", width, height, count);
+    drawAll(expected, segments, count, drawLineBresenham);
+
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        drawAll(actual, segments, count, variants[v].draw);
+        CHECK(sameImage(expected, actual), "%s: batch image differs from drawLineBresenham on %dx%d",
+              variants[v].name, width, height);
+    }
+
+    // Every SIMD kernel the CPU has, not just the best one
+    SimdLevel best = activeSimdLevel();
+    for (int level = SIMD_SCALAR; level <= (int)best; level++) {
+        char name[64];
+        setSimdLevel((SimdLevel)level);
+        snprintf(name, sizeof(name), "drawLineDDASimd (%s)", simdLevelName((SimdLevel)level));
+        drawAll(actual, segments, count, drawLineDDASimd);
+        CHECK(sameImage(expected, actual), "%s differs from drawLineBresenham on %dx%d",
+              name, width, height);
+    }
+    setSimdLevel(best);
+
+    // Batches of every exact algorithm
+    static const LineAlgorithm exact[] = {
+        LINE_BRESENHAM, LINE_DDA_FIXED, LINE_DDA_SIMD, LINE_RUN_SLICE
+    };
+    for (size_t a = 0; a < sizeof(exact) / sizeof(exact[0]); a++) {
+        clearFramebuffer(actual, COLOR_WHITE);
+        drawLineBatch(actual, segments, count, exact[a], NULL);
+        CHECK(sameImage(expected, actual), "drawLineBatch algorithm %d differs on %dx%d",
+              (int)exact[a], width, height);
+    }
+
+    // Tiled, across thread counts and tile sizes
+    static const int tiling[][2] = { { 1, TILED_DEFAULT_TILE_SIZE }, { 3, 16 }, { 4, 37 }, { 0, 64 } };
+    for (size_t t = 0; t < sizeof(tiling) / sizeof(tiling[0]); t++) {
+        TiledRenderer* renderer = createTiledRenderer(tiling[t][0], tiling[t][1]);
+        CHECK(renderer != NULL, "createTiledRenderer(%d, %d) failed", tiling[t][0], tiling[t][1]);
+        if (renderer) {
+            clearFramebuffer(actual, COLOR_WHITE);
+            drawLineBatchTiled(renderer, actual, segments, count, NULL);
+            CHECK(sameImage(expected, actual), "drawLineBatchTiled (%d threads, tile %d) differs on %dx%d",
+                  tiling[t][0], tiling[t][1], width, height);
+            destroyTiledRenderer(renderer);
+        }
+    }
+
+    // Tracing must not change the pixels
+    setTraceSink(ignoreTrace, NULL);
+    setTraceLevel(TRACE_STEPS);
+    drawAll(actual, segments, count, drawLineBresenham);
+    setTraceLevel(TRACE_OFF);
+    CHECK(sameImage(expected, actual), "traced drawLineBresenham differs on %dx%d", width, height);
+
+    // Clipping to a smaller rectangle keeps exactly the Bresenham pixels
+    // inside it and touches nothing outside
+    ClipRect clip = { width / 5, height / 4, width - width / 3, height - height / 5 };
+    clearFramebuffer(actual, COLOR_WHITE);
+    for (size_t i = 0; i < count; i++) {
+        const Segment* s = &segments[i];
+        drawLineClipped(actual, s->x1, s->y1, s->x2, s->y2, &clip, s->color);
+    }
+    int clipOk = 1;
+    for (int y = 0; y < height && clipOk; y++) {
+        for (int x = 0; x < width; x++) {
+            int inside = x >= clip.left && x <= clip.right && y >= clip.top && y <= clip.bottom;
+            const Pixel* want = inside ? &expected->pixels[(long)y * expected->stride + x] : NULL;
+            const Pixel* got = &actual->pixels[(long)y * actual->stride + x];
+            Pixel white = { 255, 255, 255 };
+            if (memcmp(got, want ? want : &white, sizeof(Pixel)) != 0) {
+                clipOk = 0;
+                break;
+            }
+        }
+    }
+    CHECK(clipOk, "drawLineClipped to (%d, %d)-(%d, %d) differs from masked drawLineBresenham",
+          clip.left, clip.top, clip.right, clip.bottom);
+
+    // One line at a time on a canvas small enough to clear per line
+    if (width * height <= 64 * 64) {
+        for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+            compareEachLine(variants[v].name, variants[v].draw, expected, actual, segments, count);
+        }
+    }
+
+    free(segments);
+    destroyFramebuffer(expected);
+    destroyFramebuffer(actual);
+}
+
+// A line with an endpoint beyond LINE_MAX_COORD draws nothing, whatever
+// the variant. Lines at the limit draw their Bresenham pixels, the float
+// DDA included: it is too long for DDA_MAX_STEPS.
+static void testLineLimits(int width, int height) {
+    static const struct {
+        const char* name;
+        DrawFunction draw;
+    } variants[] = {
+        { "drawLineBresenham", drawLineBresenham },
+        { "drawLineDDA", drawLineDDA },
+        { "drawLineDDAFixed", drawLineDDAFixed },
+        { "drawLineDDASimd", drawLineDDASimd },
+        { "drawLineRunSlice", drawLineRunSlice },
+        { "drawLineWu", drawLineWu },
+        { "drawLineClipped", drawClippedFull },
+    };
+    const Segment beyond[] = {
+        { -LINE_MAX_COORD - 1, 5, LINE_MAX_COORD, height - 5, COLOR_BLACK },
+        { INT_MIN, 0, INT_MAX, height - 1, COLOR_BLACK },
+        { width / 2, INT_MIN, width / 2, INT_MAX, COLOR_BLACK },
+    };
+    const size_t beyondCount = sizeof(beyond) / sizeof(beyond[0]);
+    const Segment limit = { -LINE_MAX_COORD, 3, LINE_MAX_COORD, height - 3, COLOR_BLACK };
+    Framebuffer* expected = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* actual = createFramebuffer(width, height, PIXEL_RGB24);
+
+    clearFramebuffer(expected, COLOR_WHITE);
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        drawAll(actual, beyond, beyondCount, variants[v].draw);
+        CHECK(sameImage(expected, actual), "%s draws a line beyond LINE_MAX_COORD", variants[v].name);
+    }
+    for (int a = LINE_BRESENHAM; a <= LINE_WU; a++) {
+        BatchStats stats;
+        clearFramebuffer(actual, COLOR_WHITE);
+        drawLineBatch(actual, beyond, beyondCount, (LineAlgorithm)a, &stats);
+        CHECK(sameImage(expected, actual), "drawLineBatch algorithm %d draws a line beyond LINE_MAX_COORD", a);
+        CHECK(stats.segments == beyondCount && stats.pixels == 0,
+              "drawLineBatch algorithm %d counts %zu pixels for lines beyond LINE_MAX_COORD", a, stats.pixels);
+    }
+
+    drawAll(expected, &limit, 1, drawLineBresenham);
+    for (size_t v = 1; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        if (variants[v].draw != drawLineWu) {
+            drawAll(actual, &limit, 1, variants[v].draw);
+            CHECK(sameImage(expected, actual), "%s differs from drawLineBresenham at LINE_MAX_COORD",
+                  variants[v].name);
+        }
+    }
+
+    destroyFramebuffer(expected);
+    destroyFramebuffer(actual);
+}
+
+// The pixels of `view` must equal those of `fb` at (left, top)
+static int sameRegion(const Framebuffer* fb, int left, int top, const Framebuffer* view) {
+    for (int y = 0; y < view->height; y++) {
+        if (memcmp(fb->pixels + (long)(y + top) * fb->stride + left, view->pixels + (long)y * view->stride,
+                   sizeof(Pixel) * (size_t)view->width) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void testWu(int width, int height, size_t count) {
+    Segment* segments = malloc(sizeof(Segment) * count);
+    Framebuffer* expected = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* actual = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* rgba = createFramebuffer(width, height, PIXEL_RGBA32);
+    randomSegments(segments, count, width, height);
+
+    printf("  %dx%d, %zu segments\n", width, height, count);
+    SimdLevel best = activeSimdLevel();
+    setSimdLevel(SIMD_SCALAR);
+    drawAll(expected, segments, count, drawLineWu);
+
+    // Every blend kernel the CPU has, per line and batched
+    for (int level = SIMD_SCALAR; level <= (int)best; level++) {
+        setSimdLevel((SimdLevel)level);
+        clearFramebuffer(actual, COLOR_WHITE);
+        drawLineBatch(actual, segments, count, LINE_WU, NULL);
+        CHECK(sameImage(expected, actual), "drawLineBatch LINE_WU (%s) differs from drawLineWu on %dx%d",
+              simdLevelName((SimdLevel)level), width, height);
+
+        // RGBA32 blends the same color channels and stays opaque
+        drawAll(rgba, segments, count, drawLineWu);
+        int rgbaOk = 1;
+        for (int y = 0; y < height && rgbaOk; y++) {
+            const unsigned char* row = (const unsigned char*)rgba->pixels + (long)y * framebufferRowBytes(rgba);
+            for (int x = 0; x < width; x++) {
+                const unsigned char* want = &expected->pixels[(long)y * expected->stride + x].r;
+                if (memcmp(row + 4 * x, want, 3) != 0 || row[4 * x + 3] != 255) {
+                    rgbaOk = 0;
+                    break;
+                }
+            }
+        }
+        CHECK(rgbaOk, "drawLineWu (%s) on RGBA32 differs from RGB24 on %dx%d",
+              simdLevelName((SimdLevel)level), width, height);
+    }
+    setSimdLevel(best);
+
+    // Clipping: a window into a larger framebuffer gets exactly the pixels
+    // the unclipped lines put there
+    Framebuffer* large = createFramebuffer(width + 40, height + 40, PIXEL_RGB24);
+    Framebuffer view;
+    initFramebufferFormat(&view, large->pixels + 20L * large->stride + 20, width, height,
+                          large->stride, PIXEL_RGB24);
+    clearFramebuffer(large, COLOR_WHITE);
+    for (size_t i = 0; i < count; i++) {
+        const Segment* s = &segments[i];
+        drawLineWu(large, s->x1 + 20, s->y1 + 20, s->x2 + 20, s->y2 + 20, s->color);
+    }
+    clearFramebuffer(actual, COLOR_WHITE);
+    drawLineBatch(actual, segments, count, LINE_WU, NULL);
+    CHECK(sameRegion(large, 20, 20, actual), "clipped drawLineWu differs from unclipped on %dx%d",
+          width, height);
+
+    // Every step deposits exactly full coverage, endpoints included
+    int coverageOk = 1;
+    for (size_t i = 0; i < count && i < 200 && coverageOk; i++) {
+        const Segment* s = &segments[i];
+        int x1 = s->x1 < 0 ? 0 : s->x1 >= width ? width - 1 : s->x1;
+        int y1 = s->y1 < 0 ? 0 : s->y1 >= height ? height - 1 : s->y1;
+        int x2 = s->x2 < 0 ? 0 : s->x2 >= width ? width - 1 : s->x2;
+        int y2 = s->y2 < 0 ? 0 : s->y2 >= height ? height - 1 : s->y2;
+        long total = 0;
+
+        clearFramebuffer(&view, COLOR_BLACK);
+        drawLineWu(&view, x1, y1, x2, y2, COLOR_WHITE);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                total += view.pixels[(long)y * view.stride + x].g;
+            }
+        }
+        int dx = abs(x2 - x1), dy = abs(y2 - y1);
+        coverageOk = total == 255L * ((dx > dy ? dx : dy) + 1);
+    }
+    CHECK(coverageOk, "drawLineWu coverage does not add up to 255 per step on %dx%d", width, height);
+
+    free(segments);
+    destroyFramebuffer(expected);
+    destroyFramebuffer(actual);
+    destroyFramebuffer(rgba);
+    destroyFramebuffer(large);
+}
+
+static void testStrokes(int width, int height, size_t count) {
+    Segment* segments = malloc(sizeof(Segment) * count);
+    Point* points = malloc(sizeof(Point) * count);
+    Framebuffer* expected = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* large = createFramebuffer(width + 40, height + 40, PIXEL_RGB24);
+    Framebuffer view;
+    randomSegments(segments, count, width, height);
+
+    printf("  %dx%d, %zu segments\n", width, height, count);
+
+    // Width 1 is the Bresenham line
+    StrokeStyle thin = { 1, CAP_ROUND, JOIN_MITER, 0.0 };
+    drawAll(expected, segments, count, drawLineBresenham);
+    initFramebufferFormat(&view, large->pixels, width, height, large->stride, PIXEL_RGB24);
+    clearFramebuffer(&view, COLOR_WHITE);
+    for (size_t i = 0; i < count; i++) {
+        const Segment* s = &segments[i];
+        drawThickLine(&view, s->x1, s->y1, s->x2, s->y2, &thin, s->color);
+    }
+    CHECK(sameImage(expected, &view), "drawThickLine of width 1 differs from drawLineBresenham on %dx%d",
+          width, height);
+
+    // Clipping: the top-left corner of a larger framebuffer gets exactly
+    // the pixels of the same strokes drawn unclipped
+    for (size_t i = 0; i < count; i++) {
+        points[i].x = segments[i].x1;
+        points[i].y = segments[i].y1;
+    }
+    for (int cap = CAP_BUTT; cap <= CAP_ROUND; cap++) {
+        for (int join = JOIN_MITER; join <= JOIN_ROUND; join++) {
+            StrokeStyle style = { 2 + 3 * join + cap, (LineCap)cap, (LineJoin)join, 0.0 };
+
+            clearFramebuffer(large, COLOR_WHITE);
+            clearFramebuffer(expected, COLOR_WHITE);
+            for (size_t i = 0; i + 8 <= count; i += 8) {
+                drawThickPolyline(large, points + i, 8, &style, segments[i].color);
+                drawThickPolyline(expected, points + i, 8, &style, segments[i].color);
+                drawThickLine(large, segments[i].x1, segments[i].y1, segments[i].x2, segments[i].y2,
+                              &style, segments[i + 1].color);
+                drawThickLine(expected, segments[i].x1, segments[i].y1, segments[i].x2, segments[i].y2,
+                              &style, segments[i + 1].color);
+            }
+            CHECK(sameImage(expected, &view), "clipped stroke (cap %d, join %d) differs from unclipped on %dx%d",
+                  cap, join, width, height);
+        }
+    }
+
+    free(segments);
+    free(points);
+    destroyFramebuffer(expected);
+    destroyFramebuffer(large);
+}
+
+// Strips of random vertices (some repeated) against their segments drawn
+// one by one
+static void testPolylines(int width, int height, size_t count) {
+    Segment* segments = malloc(sizeof(Segment) * count);
+    Point* points = malloc(sizeof(Point) * count);
+    Framebuffer* expected = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* actual = createFramebuffer(width, height, PIXEL_RGB24);
+    static const LineAlgorithm exact[] = { LINE_BRESENHAM, LINE_DDA_FIXED, LINE_DDA_SIMD, LINE_RUN_SLICE };
+    static const size_t lengths[] = { 1, 2, 3, 50, 400 };
+    randomSegments(segments, count, width, height);
+
+    printf("  %dx%d, %zu points\n", width, height, count);
+    for (size_t i = 0; i < count; i++) {
+        points[i].x = segments[i].x1;
+        points[i].y = segments[i].y1;
+        if (i > 0 && randomBelow(16) == 0) {
+            points[i] = points[i - 1];
+        }
+    }
+
+    for (int wu = 0; wu <= 1; wu++) {
+        DrawFunction draw = wu ? drawLineWu : drawLineBresenham;
+
+        clearFramebuffer(expected, COLOR_WHITE);
+        for (size_t i = 0, strip = 0; i < count; i += lengths[strip % 5], strip++) {
+            size_t n = count - i < lengths[strip % 5] ? count - i : lengths[strip % 5];
+            draw(expected, points[i].x, points[i].y, points[i].x, points[i].y, segments[i].color);
+            for (size_t k = i + 1; k < i + n; k++) {
+                draw(expected, points[k - 1].x, points[k - 1].y, points[k].x, points[k].y, segments[i].color);
+            }
+        }
+
+        for (size_t a = 0; a < (wu ? 1 : sizeof(exact) / sizeof(exact[0])); a++) {
+            LineAlgorithm algorithm = wu ? LINE_WU : exact[a];
+            BatchStats stats;
+            size_t stepped = 0, segmentCount = 0;
+            int statsOk = 1;
+
+            clearFramebuffer(actual, COLOR_WHITE);
+            for (size_t i = 0, strip = 0; i < count; i += lengths[strip % 5], strip++) {
+                size_t n = count - i < lengths[strip % 5] ? count - i : lengths[strip % 5];
+                drawPolyline(actual, points + i, n, segments[i].color, algorithm, &stats);
+
+                // Each vertex is stepped once
+                stepped = 1;
+                for (size_t k = i + 1; k < i + n; k++) {
+                    int dx = abs(points[k].x - points[k - 1].x), dy = abs(points[k].y - points[k - 1].y);
+                    stepped += (size_t)(dx > dy ? dx : dy);
+                }
+                segmentCount = n - 1;
+                statsOk &= stats.pixels == stepped && stats.segments == segmentCount;
+            }
+            CHECK(sameImage(expected, actual), "drawPolyline (algorithm %d) differs from separate lines on %dx%d",
+                  (int)algorithm, width, height);
+            CHECK(statsOk, "drawPolyline (algorithm %d) stats count shared vertices twice on %dx%d",
+                  (int)algorithm, width, height);
+        }
+    }
+
+    free(segments);
+    free(points);
+    destroyFramebuffer(expected);
+    destroyFramebuffer(actual);
+}
+
+// Random additions and removals: after every edit the scene must equal a
+// full redraw of its items, and every changed pixel must lie in the damage
+static void testScene(int width, int height, int edits) {
+    static const int algorithms[] = { LINE_BRESENHAM, LINE_DDA, LINE_WU, LINE_RUN_SLICE, -1 };
+    Scene* scene = createScene(width, height, COLOR_WHITE);
+    Segment* items = malloc(sizeof(Segment) * (size_t)edits);  // markers: x2 is the radius
+    int* kinds = malloc(sizeof(int) * (size_t)edits);          // line algorithm, -1 for markers
+    Framebuffer* expected = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* previous = createFramebuffer(width, height, PIXEL_RGB24);
+    const Framebuffer* actual = sceneFramebuffer(scene);
+    ClipRect damage[SCENE_MAX_DAMAGE];
+    size_t count = 0;
+    int sameOk = 1, damageOk = 1, countOk = 1;
+
+    printf("  %dx%d, %d edits\n", width, height, edits);
+    clearFramebuffer(previous, COLOR_BLACK);
+    for (int edit = 0; edit < edits && sameOk && damageOk && countOk; edit++) {
+        int action = randomBelow(16);
+
+        if (action < 9) {
+            Segment* item = &items[count];
+            randomSegments(item, 1, width, height);
+            kinds[count] = algorithms[randomBelow(5)];
+            if (kinds[count] < 0) {
+                item->x2 = randomBelow(4) ? 3 : 30;
+                sceneAddMarker(scene, item->x1, item->y1, item->x2, item->color);
+            } else {
+                sceneAddLine(scene, item->x1, item->y1, item->x2, item->y2, item->color,
+                             (LineAlgorithm)kinds[count]);
+            }
+            count++;
+        } else if (action < 15) {
+            size_t removed = (size_t)randomBelow(4);
+            sceneRemoveLast(scene, removed);
+            count = removed > count ? 0 : count - removed;
+        } else {
+            sceneClear(scene);
+            count = 0;
+        }
+        countOk &= sceneItemCount(scene) == count;
+
+        clearFramebuffer(expected, COLOR_WHITE);
+        for (size_t i = 0; i < count; i++) {
+            const Segment* item = &items[i];
+            if (kinds[i] < 0) {
+                drawMarker(expected, item->x1, item->y1, item->x2, item->color);
+            } else if (kinds[i] == LINE_DDA) {
+                drawLineDDA(expected, item->x1, item->y1, item->x2, item->y2, item->color);
+            } else if (kinds[i] == LINE_WU) {
+                drawLineWu(expected, item->x1, item->y1, item->x2, item->y2, item->color);
+            } else {
+                drawLineBresenham(expected, item->x1, item->y1, item->x2, item->y2, item->color);
+            }
+        }
+        sameOk = sameImage(expected, actual);
+
+        int damageCount = takeSceneDamage(scene, damage);
+        for (int y = 0; y < height && damageOk; y++) {
+            for (int x = 0; x < width; x++) {
+                const Pixel* now = &actual->pixels[(long)y * actual->stride + x];
+                Pixel* before = &previous->pixels[(long)y * previous->stride + x];
+                int inside = 0;
+
+                for (int i = 0; i < damageCount; i++) {
+                    inside |= x >= damage[i].left && x <= damage[i].right &&
+                              y >= damage[i].top && y <= damage[i].bottom;
+                }
+                if (memcmp(now, before, sizeof(Pixel)) != 0 && !inside) {
+                    damageOk = 0;
+                    break;
+                }
+                *before = *now;
+            }
+        }
+    }
+    CHECK(countOk, "scene item count does not follow its edits on %dx%d", width, height);
+    CHECK(sameOk, "scene differs from a full redraw of its items on %dx%d", width, height);
+    CHECK(damageOk, "scene changed pixels outside its damage on %dx%d", width, height);
+
+    free(items);
+    free(kinds);
+    destroyFramebuffer(expected);
+    destroyFramebuffer(previous);
+    destroyScene(scene);
+}
+
+// A text scene big enough to cross several read chunks, drawn through
+// the reader, converted to binary and drawn again
+static void testSceneFiles(int width, int height, size_t count) {
+    static const char* const algorithms[] = { "bresenham", "dda", "wu" };
+    Segment* segments = malloc(sizeof(Segment) * count);
+    Framebuffer* expected = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* actual = createFramebuffer(width, height, PIXEL_RGB24);
+    FILE* text = tmpfile();
+    FILE* binary = tmpfile();
+    SceneStats stats;
+    const char* error;
+    randomSegments(segments, count, width, height);
+
+    printf("  %dx%d, %zu commands\n", width, height, count);
+    clearFramebuffer(expected, COLOR_WHITE);
+    fprintf(text, "# generated\n\ncanvas %d %d\ncolor 250 250 240\nclear\n", width, height);
+    for (size_t i = 0; i < count; i++) {
+        const Segment* s = &segments[i];
+        int kind = (int)(i / 64 % 6);
+
+        fprintf(text, "color #%06X\n", (unsigned)s->color);
+        if (i == 0) {
+            clearFramebuffer(expected, COLOR_RGB(250, 250, 240));
+        }
+        if (kind < 3) {
+            if (i % 64 == 0) {
+                fprintf(text, "  algorithm %s\n", algorithms[kind]);
+            }
+            fprintf(text, "line %d %d %d %d\n", s->x1, s->y1, s->x2, s->y2);
+            if (kind == 0) {
+                drawLineBresenham(expected, s->x1, s->y1, s->x2, s->y2, s->color);
+            } else if (kind == 1) {
+                drawLineDDA(expected, s->x1, s->y1, s->x2, s->y2, s->color);
+            } else {
+                drawLineWu(expected, s->x1, s->y1, s->x2, s->y2, s->color);
+            }
+        } else if (kind == 3) {
+            int radius = (int)(i % 7) * 5;
+            fprintf(text, "%s %d %d %d\n", i % 2 ? "circle" : "disc", s->x1, s->y1, radius);
+            (i % 2 ? drawCircleBresenham : fillCircle)(expected, s->x1, s->y1, radius, s->color);
+        } else if (kind == 4) {
+            fprintf(text, "ring %d %d %d %d\n", s->x1, s->y1, 12, 1 + (int)(i % 3));
+            drawRing(expected, s->x1, s->y1, 12, 1 + (int)(i % 3), s->color);
+        } else {
+            fprintf(text, "marker %d %d %d\n", s->x1, s->y1, 1 + (int)(i / 128 % 3));
+            drawMarker(expected, s->x1, s->y1, 1 + (int)(i / 128 % 3), s->color);
+        }
+    }
+    CHECK(ftell(text) > 2 * SCENE_READ_CHUNK, "scene text is too short to cross read chunks");
+
+    rewind(text);
+    SceneReader* reader = openSceneReader(text, &error);
+    CHECK(reader != NULL, "text scene rejected: %s", reader ? "" : error);
+    if (reader) {
+        int w, h;
+        sceneCanvasSize(reader, &w, &h);
+        clearFramebuffer(actual, COLOR_WHITE);
+        CHECK(w == width && h == height && drawSceneFile(reader, actual, &stats),
+              "text scene did not draw: %s", sceneReaderError(reader));
+        CHECK(sameImage(expected, actual), "text scene differs from drawing directly on %dx%d", width, height);
+        CHECK(stats.lines + stats.circles + stats.markers == count, "text scene drew %zu of %zu shapes",
+              stats.lines + stats.circles + stats.markers, count);
+        closeSceneReader(reader);
+    }
+
+    // Text to binary and back
+    rewind(text);
+    reader = openSceneReader(text, &error);
+    SceneCommand command;
+    Color color = COLOR_BLACK;
+    int writtenOk = reader && writeSceneHeader(binary, width, height);
+    while (writtenOk && readSceneCommand(reader, &command) > 0) {
+        writtenOk = writeSceneCommand(binary, &command, &color);
+    }
+    closeSceneReader(reader);
+    rewind(binary);
+    reader = writtenOk ? openSceneReader(binary, &error) : NULL;
+    CHECK(reader && sceneReaderIsBinary(reader), "binary scene was not written or not recognized");
+    if (reader) {
+        clearFramebuffer(actual, COLOR_WHITE);
+        CHECK(drawSceneFile(reader, actual, NULL), "binary scene did not draw: %s", sceneReaderError(reader));
+        CHECK(sameImage(expected, actual), "binary scene differs from drawing directly on %dx%d", width, height);
+        closeSceneReader(reader);
+    }
+
+    // Malformed input names the line
+    static const struct {
+        const char* text;
+        const char* error;
+    } broken[] = {
+        { "canvas 8 8\nline 1 2 3\n", "line 2: line takes 4 arguments" },
+        { "canvas 8 8\n\n# x\ncolor #12345\n", "line 4: expected color #RRGGBB or color r g b" },
+        { "canvas 8 8\nalgorithm fast\n", "line 2: unknown algorithm 'fast'" },
+        { "canvas 8 8\nmarker 1 2 x\n", "line 2: 'x' is not an integer" },
+        { "canvas 8 8\ndisc 1 2 2147483647\n", "line 2: radius 2147483647 out of range" },
+        { "canvas 64 64\nline -2000000000 5 2000000000 40\n", "line 2: coordinate -2000000000 out of range" },
+    };
+    for (size_t i = 0; i < sizeof(broken) / sizeof(broken[0]); i++) {
+        FILE* in = tmpfile();
+        fputs(broken[i].text, in);
+        rewind(in);
+        reader = openSceneReader(in, &error);
+        int failedOk = reader && !drawSceneFile(reader, actual, NULL) &&
+                       strcmp(sceneReaderError(reader), broken[i].error) == 0;
+        CHECK(failedOk, "scene error for case %zu is '%s'", i, reader ? sceneReaderError(reader) : error);
+        closeSceneReader(reader);
+        fclose(in);
+    }
+
+    free(segments);
+    fclose(text);
+    fclose(binary);
+    destroyFramebuffer(expected);
+    destroyFramebuffer(actual);
+}
+
+// Segments written to a segment file (enough to grow the writer several
+// times), mapped and drawn from its columns
+static void testSegmentFiles(int width, int height, size_t count) {
+    static const char* const path = "test_segments.rseg";
+    Segment* segments = malloc(sizeof(Segment) * count);
+    Framebuffer* expected = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* actual = createFramebuffer(width, height, PIXEL_RGB24);
+    BatchStats expectedStats, actualStats;
+    const char* error;
+    randomSegments(segments, count, width, height);
+
+    printf("  %dx%d, %zu segments\n", width, height, count);
+    SegmentWriter* writer = createSegmentWriter(path, width, height, LINE_WU, COLOR_RGB(1, 2, 3));
+    int writtenOk = writer != NULL;
+    for (size_t i = 0; writtenOk && i < count; i++) {
+        writtenOk = writeSegment(writer, &segments[i]);
+    }
+    CHECK(writer && finishSegmentWriter(writer) && writtenOk, "segment file was not written");
+
+    SegmentFile* file = openSegmentFile(path, &error);
+    CHECK(file != NULL, "segment file rejected: %s", file ? "" : error);
+    if (file) {
+        const SegmentColumns* columns = segmentFileColumns(file);
+        int w, h;
+        segmentFileCanvas(file, &w, &h);
+        CHECK(w == width && h == height && columns->count == count &&
+              segmentFileAlgorithm(file) == LINE_WU && segmentFileBackground(file) == COLOR_RGB(1, 2, 3),
+              "segment file header does not match what was written");
+        int alignedOk = ((uintptr_t)columns->x1 | (uintptr_t)columns->y1 | (uintptr_t)columns->x2 |
+                         (uintptr_t)columns->y2 | (uintptr_t)columns->color) % 64 == 0;
+        CHECK(alignedOk, "segment file columns are not 64-byte aligned");
+
+        for (LineAlgorithm algorithm = LINE_BRESENHAM; algorithm <= LINE_WU; algorithm++) {
+            clearFramebuffer(expected, COLOR_WHITE);
+            clearFramebuffer(actual, COLOR_WHITE);
+            drawLineBatch(expected, segments, count, algorithm, &expectedStats);
+            drawLineColumns(actual, columns, algorithm, &actualStats);
+            CHECK(sameImage(expected, actual), "columns differ from the batch with algorithm %d",
+                  (int)algorithm);
+            CHECK(actualStats.segments == count && actualStats.pixels == expectedStats.pixels,
+                  "column stats %zu/%zu differ from the batch", actualStats.segments, actualStats.pixels);
+        }
+        closeSegmentFile(file);
+    }
+
+    // Endpoints beyond LINE_MAX_COORD are not checked on opening, but are
+    // skipped when drawn
+    const Segment beyond[] = {
+        { INT_MIN, 0, INT_MAX, height - 1, COLOR_BLACK },
+        { -LINE_MAX_COORD - 1, 5, width / 2, height / 2, COLOR_BLACK },
+    };
+    writer = createSegmentWriter(path, width, height, LINE_BRESENHAM, COLOR_WHITE);
+    writtenOk = writer && writeSegment(writer, &beyond[0]) && writeSegment(writer, &beyond[1]);
+    CHECK(writer && finishSegmentWriter(writer) && writtenOk, "segment file was not written");
+    file = openSegmentFile(path, &error);
+    CHECK(file != NULL, "segment file beyond LINE_MAX_COORD rejected: %s", file ? "" : error);
+    if (file) {
+        clearFramebuffer(expected, COLOR_WHITE);
+        for (LineAlgorithm algorithm = LINE_BRESENHAM; algorithm <= LINE_WU; algorithm++) {
+            clearFramebuffer(actual, COLOR_WHITE);
+            drawLineColumns(actual, segmentFileColumns(file), algorithm, &actualStats);
+            CHECK(sameImage(expected, actual) && actualStats.pixels == 0,
+                  "columns beyond LINE_MAX_COORD drawn with algorithm %d", (int)algorithm);
+        }
+        closeSegmentFile(file);
+    }
+
+    // An empty file, and a header promising more than the file holds
+    writer = createSegmentWriter(path, width, height, LINE_BRESENHAM, COLOR_WHITE);
+    CHECK(writer && finishSegmentWriter(writer), "empty segment file was not written");
+    file = openSegmentFile(path, &error);
+    CHECK(file && segmentFileColumns(file)->count == 0, "empty segment file was not read back");
+    closeSegmentFile(file);
+
+    FILE* out = fopen(path, "r+b");
+    if (out) {
+        unsigned char stride[8] = { 64 };
+        fseek(out, 32, SEEK_SET);
+        fwrite(stride, 1, sizeof(stride), out);
+        fclose(out);
+    }
+    file = openSegmentFile(path, &error);
+    CHECK(file == NULL && strcmp(error, "segment file is truncated or corrupt") == 0,
+          "truncated segment file was accepted");
+    closeSegmentFile(file);
+    remove(path);
+
+    free(segments);
+    destroyFramebuffer(expected);
+    destroyFramebuffer(actual);
+}
+
+// Frame f of the farm test: segments that depend on f and on nothing else
+static void drawFarmFrame(Framebuffer* fb, int frame, void* arg) {
+    const Segment* segments = arg;
+    clearFramebuffer(fb, (Color)frame * 0x010203);
+    for (int i = 0; i < 40; i++) {
+        const Segment* s = &segments[(frame * 7 + i) % 200];
+        drawLineBresenham(fb, s->x1, s->y1, s->x2, s->y2, s->color);
+    }
+}
+
+// Frames rendered by the farm, on more threads than frames per thread, must
+// be the files of the same frames drawn one by one
+static void testFarm(int width, int height, int frames, int threads) {
+    Segment segments[200];
+    Framebuffer* fb = createFramebuffer(width, height, PIXEL_RGB24);
+    FrameFarm* farm = createFrameFarm(threads, width, height);
+    FarmStats stats;
+    char path[64];
+    randomSegments(segments, 200, width, height);
+
+    printf("  %dx%d, %d frames on %d threads\n", width, height, frames, threads);
+    CHECK(farm != NULL, "render farm could not start");
+    if (!farm) {
+        destroyFramebuffer(fb);
+        return;
+    }
+    int failed = renderFrames(farm, frames, drawFarmFrame, segments, "test_farm.ppm", IMAGE_PPM, &stats);
+    CHECK(failed == 0 && stats.frames == (size_t)frames && stats.failed == 0,
+          "render farm failed %d of %d frames", failed, frames);
+
+    int sameOk = 1;
+    for (int frame = 0; frame < frames; frame++) {
+        char* expected = NULL;
+        size_t expectedSize = 0, actualSize = 0;
+        drawFarmFrame(fb, frame, segments);
+        expectedSize = ppmBytes(fb, &expected);
+        frameFilePath(path, sizeof(path), "test_farm.ppm", frame);
+        char* actual = readFile(path, &actualSize);
+        if (!actual || actualSize != expectedSize || memcmp(actual, expected, actualSize) != 0) {
+            sameOk = 0;
+        }
+        free(expected);
+        free(actual);
+        remove(path);
+    }
+    CHECK(sameOk, "render farm frames differ from drawing them one by one");
+
+    CHECK(frameFilePath(path, sizeof(path), "out.d/fan", 42) && strcmp(path, "out.d/fan000042") == 0,
+          "frame path of an extensionless name is %s", path);
+    CHECK(!frameFilePath(path, 8, "fan.png", 1), "frame path overflow not reported");
+
+    destroyFrameFarm(farm);
+    destroyFramebuffer(fb);
+}
+
+// Ellipses and arcs against the properties the span engine promises:
+// clipping, batches, fills containing outlines, and complementary arcs
+// and pies splitting the ellipse between them
+static void testEllipses(int width, int height, size_t count) {
+    Framebuffer* fb = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* other = createFramebuffer(width, height, PIXEL_RGB24);
+    Framebuffer* whole = createFramebuffer(width, height, PIXEL_RGB24);
+    Ellipse* shapes = malloc(sizeof(Ellipse) * count);
+    EllipseArc* arcs = malloc(sizeof(EllipseArc) * count);
+    BatchStats stats;
+
+    printf("  %dx%d, %zu ellipses and arcs\n", width, height, count);
+    for (size_t i = 0; i < count; i++) {
+        shapes[i].xc = randomBelow(width + 40) - 20;
+        shapes[i].yc = randomBelow(height + 40) - 20;
+        shapes[i].rx = i % 16 == 0 ? 0 : randomBelow(i % 8 == 0 ? 3 * width : 40);
+        shapes[i].ry = i % 24 == 0 ? 0 : randomBelow(i % 8 == 0 ? 3 * height : 40);
+        shapes[i].color = palette[i % 8];
+        arcs[i].xc = shapes[i].xc;
+        arcs[i].yc = shapes[i].yc;
+        arcs[i].rx = shapes[i].rx;
+        arcs[i].ry = shapes[i].ry;
+        arcs[i].start = randomBelow(7200) / 10.0 - 360.0;
+        arcs[i].sweep = i % 5 == 0 ? 180.0 : randomBelow(3600) / 10.0 + 0.1;
+        arcs[i].color = shapes[i].color;
+    }
+
+    // Batches draw what the single calls draw
+    for (int filled = 0; filled <= 1; filled++) {
+        EllipseMode mode = filled ? ELLIPSE_FILLED : ELLIPSE_OUTLINE;
+        clearFramebuffer(fb, COLOR_WHITE);
+        clearFramebuffer(other, COLOR_WHITE);
+        drawEllipseBatch(fb, shapes, count, mode, &stats);
+        for (size_t i = 0; i < count; i++) {
+            const Ellipse* e = &shapes[i];
+            (filled ? fillEllipse : drawEllipse)(other, e->xc, e->yc, e->rx, e->ry, e->color);
+        }
+        CHECK(sameImage(fb, other) && stats.segments == count, "ellipse batch (filled %d) differs",
+              filled);
+
+        clearFramebuffer(fb, COLOR_WHITE);
+        clearFramebuffer(other, COLOR_WHITE);
+        drawArcBatch(fb, arcs, count, mode, NULL);
+        for (size_t i = 0; i < count; i++) {
+            const EllipseArc* a = &arcs[i];
+            (filled ? fillEllipsePie : drawEllipseArc)(other, a->xc, a->yc, a->rx, a->ry, a->start,
+                                                       a->sweep, a->color);
+        }
+        CHECK(sameImage(fb, other), "arc batch (filled %d) differs", filled);
+    }
+
+    // One shape at a time on a white canvas: `fb` and `other` get the two
+    // complementary arcs (or pies), `whole` the full outline (or fill)
+    int partitionOk = 1, insideOk = 1, clipOk = 1;
+    for (size_t i = 0; i < count; i++) {
+        const EllipseArc* a = &arcs[i];
+        int filled = i % 2;
+        void (*cut)(Framebuffer*, int, int, int, int, double, double, Color) =
+            filled ? fillEllipsePie : drawEllipseArc;
+
+        clearFramebuffer(fb, COLOR_WHITE);
+        clearFramebuffer(other, COLOR_WHITE);
+        clearFramebuffer(whole, COLOR_WHITE);
+        cut(fb, a->xc, a->yc, a->rx, a->ry, a->start, a->sweep, COLOR_RED);
+        cut(other, a->xc, a->yc, a->rx, a->ry, a->start + a->sweep, 360.0 - a->sweep, COLOR_BLUE);
+        (filled ? fillEllipse : drawEllipse)(whole, a->xc, a->yc, a->rx, a->ry, COLOR_BLACK);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int inFirst = fb->pixels[(long)y * fb->stride + x].g == 0;
+                int inSecond = other->pixels[(long)y * other->stride + x].g == 0;
+                int inWhole = whole->pixels[(long)y * whole->stride + x].g == 0;
+                // A pie has the center whichever side it is on
+                int center = filled && x == a->xc && y == a->yc;
+                if (inWhole != (inFirst || inSecond) || (inFirst && inSecond && !center)) {
+                    partitionOk = 0;
+                }
+            }
+        }
+
+        // The outline lies within the fill
+        clearFramebuffer(fb, COLOR_WHITE);
+        drawEllipse(fb, a->xc, a->yc, a->rx, a->ry, COLOR_BLACK);
+        fillEllipse(fb, a->xc, a->yc, a->rx, a->ry, COLOR_WHITE);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                insideOk &= fb->pixels[(long)y * fb->stride + x].r == 255;
+            }
+        }
+
+        // Clipped at the canvas edge: the visible part of an unclipped copy
+        int shift = a->rx + 2;
+        Framebuffer* wide = createFramebuffer(width + 2 * shift, height, PIXEL_RGB24);
+        Framebuffer view;
+        if (wide && a->xc >= 0 && a->xc < width) {
+            initFramebufferFormat(&view, wide->pixels + shift, width, height, wide->stride,
+                                  PIXEL_RGB24);
+            clearFramebuffer(wide, COLOR_WHITE);
+            clearFramebuffer(fb, COLOR_WHITE);
+            cut(wide, a->xc + shift, a->yc, a->rx, a->ry, a->start, a->sweep, COLOR_RED);
+            cut(fb, a->xc, a->yc, a->rx, a->ry, a->start, a->sweep, COLOR_RED);
+            clipOk &= sameRegion(fb, 0, 0, &view);
+        }
+        destroyFramebuffer(wide);
+    }
+    CHECK(partitionOk, "complementary arcs or pies do not split the ellipse exactly");
+    CHECK(insideOk, "an ellipse outline leaves its fill");
+    CHECK(clipOk, "clipped arcs or pies differ from the visible part of unclipped ones");
+
+    free(shapes);
+    free(arcs);
+    destroyFramebuffer(fb);
+    destroyFramebuffer(other);
+    destroyFramebuffer(whole);
+}
+
+// Reference for fillPolygonContours: the pixel center (x, y) tested
+// against every edge, exactly in integers. An edge counts when it crosses
+// row y, top included and bottom excluded, at or left of x.
+static int insidePolygon(const Point* points, const size_t* counts, size_t contours, FillRule rule,
+                         int x, int y) {
+    int winding = 0;
+
+    for (size_t c = 0; c < contours; points += counts[c], c++) {
+        for (size_t i = 0; i < counts[c]; i++) {
+            Point a = points[i];
+            Point b = points[i + 1 == counts[c] ? 0 : i + 1];
+            int direction = 1;
+            if (a.y > b.y) {
+                Point swap = a;
+                a = b;
+                b = swap;
+                direction = -1;
+            }
+            if (y >= a.y && y < b.y &&
+                (long long)(x - a.x) * (b.y - a.y) >= (long long)(y - a.y) * (b.x - a.x)) {
+                winding += direction;
+            }
+        }
+    }
+    return rule == FILL_NONZERO ? winding != 0 : winding & 1;
+}
+
+// Polygons against the per-pixel reference: convex ones (the fast path),
+// concave and self-intersecting ones and several contours (the edge
+// table), under both fill rules, many of them crossing the canvas edge.
+// A triangle mesh must then cover every pixel exactly once.
+static void testPolygons(int width, int height, size_t count) {
+    Framebuffer* fb = createFramebuffer(width, height, PIXEL_RGB24);
+    Point points[24];
+    size_t counts[3];
+
+    printf("  %dx%d, %zu polygons\n", width, height, count);
+    int referenceOk = 1;
+    for (size_t i = 0; i < count; i++) {
+        size_t contours = i % 4 == 0 ? 2 + i % 8 / 4 : 1;
+        FillRule rule = i % 2 ? FILL_NONZERO : FILL_EVEN_ODD;
+        int scale = i % 50 == 0 ? 1 << 16 : 1;
+        size_t total = 0;
+
+        for (size_t c = 0; c < contours; c++) {
+            int cx = randomBelow(width + 60) - 30, cy = randomBelow(height + 60) - 30;
+            int rx = randomBelow(40) + 1, ry = randomBelow(40) + 1;
+            if (i % 3 == 0) {
+                // A diamond: convex
+                Point diamond[4] = { { cx, cy - ry }, { cx + rx, cy }, { cx, cy + ry }, { cx - rx, cy } };
+                memcpy(&points[total], diamond, sizeof(diamond));
+                counts[c] = 4;
+            } else {
+                counts[c] = 3 + (size_t)randomBelow(6);
+                for (size_t k = 0; k < counts[c]; k++) {
+                    points[total + k].x = cx + (randomBelow(2 * rx + 1) - rx) * scale;
+                    points[total + k].y = cy + (randomBelow(2 * ry + 1) - ry) * scale;
+                }
+            }
+            total += counts[c];
+        }
+
+        clearFramebuffer(fb, COLOR_WHITE);
+        fillPolygonContours(fb, points, counts, contours, rule, COLOR_BLACK);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int filled = fb->pixels[(long)y * fb->stride + x].g == 0;
+                if (filled != insidePolygon(points, counts, contours, rule, x, y)) {
+                    referenceOk = 0;
+                }
+            }
+        }
+    }
+    CHECK(referenceOk, "filled polygons differ from the per-pixel reference");
+
+    // Jittered grid reaching past the canvas, each cell split in two
+    // triangles along alternating diagonals
+    enum { CELL = 12 };
+    int columns = width / CELL + 4, rows = height / CELL + 4;
+    Point* grid = malloc(sizeof(Point) * (size_t)(columns * rows));
+    int* covered = calloc((size_t)(width * height), sizeof(int));
+    Framebuffer* one = createFramebuffer(width, height, PIXEL_RGB24);
+    for (int gy = 0; gy < rows; gy++) {
+        for (int gx = 0; gx < columns; gx++) {
+            grid[gy * columns + gx].x = (gx - 1) * CELL + randomBelow(9) - 4;
+            grid[gy * columns + gx].y = (gy - 1) * CELL + randomBelow(9) - 4;
+        }
+    }
+    for (int gy = 0; gy + 1 < rows; gy++) {
+        for (int gx = 0; gx + 1 < columns; gx++) {
+            Point a = grid[gy * columns + gx], b = grid[gy * columns + gx + 1];
+            Point c = grid[(gy + 1) * columns + gx + 1], d = grid[(gy + 1) * columns + gx];
+            Point halves[2][3] = { { a, b, c }, { a, c, d } };
+            if ((gx + gy) % 2) {
+                Point other[2][3] = { { a, b, d }, { b, c, d } };
+                memcpy(halves, other, sizeof(halves));
+            }
+            for (int h = 0; h < 2; h++) {
+                clearFramebuffer(one, COLOR_WHITE);
+                fillPolygon(one, halves[h], 3, FILL_NONZERO, COLOR_BLACK);
+                for (int y = 0; y < height; y++) {
+                    for (int x = 0; x < width; x++) {
+                        covered[y * width + x] += one->pixels[(long)y * one->stride + x].g == 0;
+                    }
+                }
+            }
+        }
+    }
+    int meshOk = 1;
+    for (int i = 0; i < width * height; i++) {
+        meshOk &= covered[i] == 1;
+    }
+    CHECK(meshOk, "a triangle mesh leaves gaps or overlaps");
+
+    // Vertices at the coordinate limit still fill exactly the canvas;
+    // one beyond it draws nothing
+    Point huge[3] = { { -POLYGON_MAX_COORD, -POLYGON_MAX_COORD },
+                      { POLYGON_MAX_COORD, -POLYGON_MAX_COORD }, { 0, POLYGON_MAX_COORD } };
+    clearFramebuffer(fb, COLOR_WHITE);
+    clearFramebuffer(one, COLOR_BLACK);
+    fillPolygon(fb, huge, 3, FILL_EVEN_ODD, COLOR_BLACK);
+    int hugeOk = sameImage(fb, one);
+    huge[2].y++;
+    clearFramebuffer(fb, COLOR_WHITE);
+    clearFramebuffer(one, COLOR_WHITE);
+    fillPolygon(fb, huge, 3, FILL_EVEN_ODD, COLOR_BLACK);
+    CHECK(hugeOk && sameImage(fb, one), "polygons at or beyond the coordinate limit are wrong");
+
+    free(grid);
+    free(covered);
+    destroyFramebuffer(one);
+    destroyFramebuffer(fb);
+}
+
+int main(int argc, char* argv[]) {
+    const char* directory = "tests/golden";
+    int update = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0) {
+            update = 1;
+        } else {
+            directory = argv[i];
+        }
+    }
+
+    printf("Golden images (%s)%s\n", directory, update ? ", updating" : "");
+    for (size_t i = 0; i < sizeof(goldenCases) / sizeof(goldenCases[0]); i++) {
+        runGoldenCase(&goldenCases[i], directory, update);
+    }
+
+    printf("Line variants against drawLineBresenham\n");
+    testVariants(64, 48, 4000);
+    testVariants(257, 193, 3000);
+    testVariants(800, 600, 2000);
+    testLineLimits(64, 48);
+
+    printf("Anti-aliased lines\n");
+    testWu(64, 48, 4000);
+    testWu(257, 193, 3000);
+
+    printf("Line strips\n");
+    testPolylines(64, 48, 4000);
+    testPolylines(257, 193, 3000);
+
+    printf("Retained scene\n");
+    testScene(64, 48, 600);
+    testScene(257, 193, 600);
+
+    printf("Scene files\n");
+    testSceneFiles(257, 193, 6000);
+
+    printf("Segment files\n");
+    testSegmentFiles(257, 193, 20000);
+
+    printf("Render farm\n");
+    testFarm(96, 64, 37, 3);
+
+    printf("Ellipses\n");
+    testEllipses(97, 71, 300);
+
+    printf("Polygons\n");
+    testPolygons(97, 71, 400);
+
+    printf("Thick lines\n");
+    testStrokes(64, 48, 800);
+    testStrokes(257, 193, 800);
+
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures ? 1 : 0;
+}